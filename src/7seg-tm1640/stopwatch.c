@@ -3,13 +3,16 @@
  * purpose:     Sample program for two 4-digit 7-Segment LED    *
  *              displays. It implements a simple stopwatch with *
  *              buttons Mode=start, Enter=stop, Up=clear.       *
+ *              Buttons come from the button event queue, the   *
+ *              renders on centisecond ticks in phase with the  *
+ *              start press, and sleeps while stopped.          *
  *                                                              *
  * return:      0 on success, and -1 on errors.                 *
  *                                                              *
  * requires:    tm1640.c/.h and font.h                          *
  *              orig. in https://github.com/micolous/tm1640-rpi *
  *                                                              *
- * compile:     see Makefile, needs -lWiringPi -lm              *
+ * compile:     see Makefile, needs tick.c and buttons.c        *
  *                                                              *
  * example:     ./timetest                                      *
  *                                                              *
@@ -18,92 +21,107 @@
 #define _POSIX_C_SOURCE 200809L
 #include <unistd.h>
 #include <inttypes.h>
-#include <math.h>
 #include <time.h>
 #include <stdio.h>
 #include <stdbool.h>
-#include <wiringPi.h>
 #include <signal.h>
 #include "tm1640.h"
+#include "tick.h"
+#include "buttons.h"
+
+tm1640_display *d1;                       // tm1640 display handle
+char shown[32] = "";                      // string on the display
+
+/* ------------------------------------------------------------ *
+ * Handler() prints the last time shown and the display traffic *
+ * statistics on ctrl+c                                         *
+ * ------------------------------------------------------------ */
+void Handler(int signo) {
+  printf("Stopwatch: %s\n", shown);
+  tm1640_printStats(d1, stdout);
+  exit(0);
+}
 
 int main() {
-  int res;                                // program returncode
+  int res = 0;                            // program returncode
   struct tm *time;                        // standard time struct
-  struct timespec tp1, tp2, tp3, tp4;     // nanosec time structs
-  long ms = 0;                            // milliseconds
-  char timestr[10] = "000000.00";         // 7Seg display string
-  tm1640_display *d1 = tm1640_init(3,2);  // tm1640 clock and data pins
+  ticker tick;                            // centisecond ticks
+  struct pollfd fds[1];                   // button event queue fd
+  btn_event ev;                           // button press/release
+  long long start = 0;                    // monotonic start time in ns
+  long long elapsed = 0;                  // elapsed ns before start
+  long long show;                         // elapsed ns to display
+  time_t tsnow;                           // elapsed seconds
+  long cs = 0;                            // elapsed centiseconds
+  tm1640_frame frame;                     // 7Seg display frame
+  char timestr[32] = "000000.00";         // 7Seg display string
+  int nfds, ret;
+  d1 = tm1640_init(3,2);                  // tm1640 clock and data pins
+  if(d1 == NULL) return -1;
+  signal(SIGINT, Handler);                // print stats on ctrl+c
   tm1640_displayOn(d1, 2);                // display on + brightness 0..4
   tm1640_displayClear(d1);                // display zero out
 
-  wiringPiSetup();
-  pinMode (21, INPUT);  // SW1 Up
-  pinMode (22, INPUT);  // SW2 Mode
-  pinMode (23, INPUT);  // SW3 Down
-  pinMode (24, INPUT);  // SW4 Enter
+  if(btn_open(BTN_DEBOUNCE) == -1) return -1;
+  nfds = btn_pollfds(fds);
 
-  bool runstate = FALSE;
-  tp3.tv_sec  = 0;
-  tp3.tv_nsec = 0;
-  tp4.tv_sec  = 0;
-  tp4.tv_nsec = 0;
+  bool runstate = false;
+  tick.fd = -1;
 
   while(1) {
     /* ----------------------------------------------------------- *
-     * Check button press MODE for start action                    *
+     * Running: wake on centisecond ticks or buttons. Stopped: the *
+     * display does not change, sleep until a button edge.         *
      * ----------------------------------------------------------- */
-    if((digitalRead(22) == LOW) && (runstate == FALSE)) { 
-      runstate = TRUE;
-      clock_gettime(CLOCK_MONOTONIC_RAW, &tp1);
-      //printf("Start\n");
-    }
-    /* ----------------------------------------------------------- *
-     * Check button press ENTER for stop action                    *
-     * ----------------------------------------------------------- */
-    if((digitalRead(24) == LOW) && (runstate == TRUE)) {
-      runstate = FALSE;
-      tp4.tv_sec = tp3.tv_sec;
-      tp4.tv_nsec = tp3.tv_nsec;
-    }
-    /* ----------------------------------------------------- *
-     * Check button press UP for clear action                *
-     * ----------------------------------------------------- */
-    if((digitalRead(21) == LOW) && (runstate == FALSE)) {
-      snprintf(timestr, sizeof(timestr), "000000.00");
-      tp4.tv_sec = 0;
-      tp4.tv_nsec = 0;
-    }
+    if(runstate == true) ret = tick_wait(&tick, fds, nfds);
+    else ret = poll(fds, nfds, -1);
+    if(ret < 0) break;
 
-    /* ----------------------------------------------------------- *
-     * In runstate, check and display the elapsing time            *
-     * ----------------------------------------------------------- */
-    if(runstate == TRUE) {
-      clock_gettime(CLOCK_MONOTONIC_RAW, &tp2);
-      if (tp1.tv_nsec > (tp2.tv_nsec + tp4.tv_nsec)) {
-         tp3.tv_sec = tp4.tv_sec + tp2.tv_sec - tp1.tv_sec - 1;
-         tp3.tv_nsec = (tp4.tv_nsec + tp2.tv_nsec + 1e9) - tp1.tv_nsec;
+    while(btn_read(&ev) == 1) {
+      if(ev.type != BTN_PRESS) continue;
+      /* --------------------------------------------------------- *
+       * Button press MODE for start action. Time counts from the  *
+       * kernel edge timestamp, the ticks run in phase with it.    *
+       * --------------------------------------------------------- */
+      if((ev.button == BTN_MODE) && (runstate == false)) {
+        runstate = true;
+        start = ev.time;
+        if(tick_start(&tick, CLOCK_MONOTONIC, 10000000LL, start) == -1) return -1;
+        //printf("Start\n");
       }
-      else {
-         tp3.tv_sec = tp4.tv_sec + tp2.tv_sec - tp1.tv_sec;
-         tp3.tv_nsec = tp4.tv_nsec + tp2.tv_nsec - tp1.tv_nsec;
+      /* --------------------------------------------------------- *
+       * Button press ENTER for stop action                        *
+       * --------------------------------------------------------- */
+      else if((ev.button == BTN_ENTER) && (runstate == true)) {
+        runstate = false;
+        elapsed += ev.time - start;
+        tick_stop(&tick);
       }
-      if(tp3.tv_nsec > 1e9) {
-        tp3.tv_nsec = tp3.tv_nsec / 10;
-        tp3.tv_sec = tp3.tv_sec + 1;
+      /* --------------------------------------------------- *
+       * Button press UP for clear action                    *
+       * --------------------------------------------------- */
+      else if((ev.button == BTN_UP) && (runstate == false)) {
+        elapsed = 0;
       }
-      time_t tsnow = tp3.tv_sec;
-      time = gmtime(&tsnow);
-      ms = round(tp3.tv_nsec / 1.0e6); // nanosec to millisec
-      if (ms > 999) { tsnow++; ms = 0; }
+    }
 
-      snprintf(timestr, sizeof(timestr), "%02d%02d%02d.%02ld",
-               time->tm_hour, time->tm_min, time->tm_sec, ms);
+    /* ----------------------------------------------------------- *
+     * Render the elapsing time, only if the digits changed        *
+     * ----------------------------------------------------------- */
+    show = elapsed;
+    if(runstate == true && tick.last > start) show += tick.last - start;
+    tsnow = show / 1000000000LL;
+    cs = (show % 1000000000LL) / 10000000LL;
+    time = gmtime(&tsnow);
+    snprintf(timestr, sizeof(timestr), "%02d%02d%02d.%02ld",
+             time->tm_hour, time->tm_min, time->tm_sec, cs % 100);
+    if(strcmp(timestr, shown) == 0) continue;       // nothing to render
+    strcpy(shown, timestr);
 
-    }
-    //printf("time %lu - %lu - %lu\n", tp2.tv_nsec, tp1.tv_nsec, ms);
-    res = tm1640_displayWrite(d1, 0, timestr, strlen(timestr), INVERT_MODE_NONE);
-    if(ms < 500) tm1640_setColon(d1, 0, 1);         // display-1 Colon on
-    else tm1640_setColon(d1, 0, 0);                 // display-1 Colon off
+    tm1640_frameClear(&frame);
+    res = tm1640_frameText(&frame, 0, timestr, strlen(timestr), INVERT_MODE_NONE);
+    tm1640_frameColon(&frame, 0, cs < 50);          // display-1 Colon on 1st half
+    tm1640_frameCommit(d1, &frame);                 // send in one burst
   }
   return res;
-} 
+}
@@ -2,71 +2,98 @@
  * file:        temptime.c                                      *
  * purpose:     Sample program for two 4-digit 7-Segment LED    *
  *              displays. It shows the current time and CPU     *
- *              temperature to both 7Seg LED displays.          *
+ *              temperature to both 7Seg LED displays. It wakes *
+ *              on each half-second boundary of the clock.      *
  *                                                              *
  * return:      0 on success, and -1 on errors.                 *
  *                                                              *
  * requires:    tm1640.c/.h and font.h                          *
  *              orig. in https://github.com/micolous/tm1640-rpi *
  *                                                              *
- * compile:     see Makefile, needs -lWiringPi -lm              *
+ * compile:     see Makefile, needs tick.c                      *
  *                                                              *
  * example:     ./temptime                                      *
  *                                                              *
  * author:      05/15/2020 Frank4DD                             *
  * ------------------------------------------------------------ */
+#define _POSIX_C_SOURCE 200809L
 #include <unistd.h>
 #include <inttypes.h>
-#include <math.h>
 #include <time.h>
 #include <stdio.h>
+#include <signal.h>
 #include "tm1640.h"
+#include "tick.h"
+
+tm1640_display *d1;                       // tm1640 display handle
+
+/* ------------------------------------------------------------ *
+ * Handler() prints the display traffic statistics on ctrl+c    *
+ * ------------------------------------------------------------ */
+void Handler(int signo) {
+  tm1640_printStats(d1, stdout);
+  exit(0);
+}
 
 int main() {
-   int res;                                // program returncode
+   int res = 0;                            // program returncode
    struct tm *now_tm;                      // standard time struct
    time_t now;                             // seconds since epoch
-   struct timespec sleep;                  // new timespec struct
+   ticker tick;                            // half-second ticks
+   tm1640_frame frame;                     // display frame
    char segstr[15];                        // display string
+   char shown[15] = "";                    // string on the display
    FILE *thermal;                          // Handle for CPU temp
-   float systemp, millideg;                // temp values
+   float systemp = 0, millideg;            // temp values
    int colon_state = 0;                    // blink the colon
+   int shown_colon = -1;                   // colon on the display
 
-/* ------------------------------------------------------------ *
- * Setup sleep time and display control                         *
- * ------------------------------------------------------------ */
-   sleep.tv_sec = 0;                       // set sleep time
-   sleep.tv_nsec = 500000000;              // to 0.5 seconds
-
-   tm1640_display *d1 = tm1640_init(3,2);  // tm1640 clock and data pins
+   d1 = tm1640_init(3,2);                  // tm1640 clock and data pins
+   if(d1 == NULL) return -1;
+   signal(SIGINT, Handler);                // print stats on ctrl+c
    tm1640_displayClear(d1);                // display zero out
    tm1640_displayOn(d1, 4);                // display on brightness 0..4
 
-   while(1) {
+/* ------------------------------------------------------------ *
+ * Tick on each half second of the clock: the colon is on for   *
+ * the first half of every second, in phase with the seconds.   *
+ * ------------------------------------------------------------ */
+   if(tick_start(&tick, CLOCK_REALTIME, 500000000LL, 0) == -1) return -1;
+
+   while(tick_wait(&tick, NULL, 0) >= 0) {
       /* -------------------------------------------------------- *
-       * get current time (now)                                   *
+       * get tick time (now)                                      *
        * -------------------------------------------------------- */
-      now = time(0);
+      now = tick.last / 1000000000LL;
       now_tm = localtime(&now);
+      colon_state = (tick.last % 1000000000LL) < 500000000LL;
 
       /* --------------------------------------------------------- *
-       * get CPU temp, and write it into variable systemp          *
+       * get CPU temp once per second, write it into systemp       *
        * --------------------------------------------------------- */
-      thermal = fopen("/sys/class/thermal/thermal_zone0/temp", "r");
-      fscanf(thermal, "%f", &millideg);
-      fclose(thermal);
-      systemp = (millideg / 10.0) / 100.0;
+      if(colon_state || shown_colon < 0) {
+         thermal = fopen("/sys/class/thermal/thermal_zone0/temp", "r");
+         if(thermal != NULL) {
+            if(fscanf(thermal, "%f", &millideg) == 1)
+               systemp = (millideg / 10.0) / 100.0;
+            fclose(thermal);
+         }
+      }
 
       /* --------------------------------------------------------- *
        * write time and systemp with .1 precision to 7-seg display *
+       * only if the text or the colon changed                     *
        * --------------------------------------------------------- */
       snprintf(segstr, sizeof(segstr), "%02d%02d%5.1f",
                now_tm->tm_hour, now_tm->tm_min, systemp);
-      res = tm1640_displayWrite(d1, 0, segstr, strlen(segstr), INVERT_MODE_NONE);
+      if(colon_state == shown_colon && strcmp(segstr, shown) == 0) continue;
+      strcpy(shown, segstr);
+      shown_colon = colon_state;
 
-      tm1640_setColon(d1, 0, colon_state);    // display-1 Colon blink
-      colon_state = 1 - colon_state;          // cycle between 0 and 1
-      nanosleep(&sleep, NULL);
+      tm1640_frameClear(&frame);
+      res = tm1640_frameText(&frame, 0, segstr, strlen(segstr), INVERT_MODE_NONE);
+      tm1640_frameColon(&frame, 0, colon_state); // display-1 Colon blink
+      tm1640_frameCommit(d1, &frame);         // send in one burst
   }
   return res;
 }
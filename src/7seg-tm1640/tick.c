@@ -0,0 +1,110 @@
+/* ------------------------------------------------------------ *
+ * file:        tick.c                                          *
+ * purpose:     Tick scheduler on a timerfd, armed with an      *
+ *              absolute start time and a fixed interval. The   *
+ *              kernel keeps the ticks on the period boundaries *
+ *              and counts missed ones, so the program sleeps   *
+ *              in poll() between ticks and never drifts.       *
+ *              Extra fds (buttons) are waited on in the same   *
+ *              poll() call.                                    *
+ *                                                              *
+ * requires:    tick.h, Linux timerfd                           *
+ *                                                              *
+ * author:      10/17/2026 Frank4DD                             *
+ * ------------------------------------------------------------ */
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+#include "tick.h"
+
+/* ------------------------------------------------------------ *
+ * tick_ns() converts a timespec into nanoseconds               *
+ * ------------------------------------------------------------ */
+long long tick_ns(const struct timespec *ts) {
+  return ts->tv_sec * 1000000000LL + ts->tv_nsec;
+}
+
+/* ------------------------------------------------------------ *
+ * tick_clock() returns the current time of clock in ns         *
+ * ------------------------------------------------------------ */
+long long tick_clock(clockid_t clock) {
+  struct timespec now;
+  clock_gettime(clock, &now);
+  return tick_ns(&now);
+}
+
+/* ------------------------------------------------------------ *
+ * tick_arm() sets the timer to the next period boundary after  *
+ * now. On CLOCK_REALTIME, a clock change cancels the timer so  *
+ * that tick_wait() can realign it.                             *
+ * ------------------------------------------------------------ */
+static int tick_arm(ticker *t) {
+  struct itimerspec its;
+  long long now = tick_clock(t->clock);
+  long long next = t->origin + ((now - t->origin) / t->period + 1) * t->period;
+  int flags = TFD_TIMER_ABSTIME;
+
+  if(t->clock == CLOCK_REALTIME) flags |= TFD_TIMER_CANCEL_ON_SET;
+  its.it_value.tv_sec = next / 1000000000LL;
+  its.it_value.tv_nsec = next % 1000000000LL;
+  its.it_interval.tv_sec = t->period / 1000000000LL;
+  its.it_interval.tv_nsec = t->period % 1000000000LL;
+  t->last = next - t->period;
+  return timerfd_settime(t->fd, flags, &its, NULL);
+}
+
+/* ------------------------------------------------------------ *
+ * tick_start() starts ticks every period ns, on the multiples  *
+ * of period from origin (0 = the clock epoch).                 *
+ * ------------------------------------------------------------ */
+int tick_start(ticker *t, clockid_t clock, long long period, long long origin) {
+  memset(t, 0, sizeof(ticker));
+  t->clock = clock;
+  t->period = period;
+  t->origin = origin;
+  if((t->fd = timerfd_create(clock, TFD_CLOEXEC)) == -1) return -1;
+  if(tick_arm(t) == -1) {
+    close(t->fd);
+    return -1;
+  }
+  return 0;
+}
+
+/* ------------------------------------------------------------ *
+ * tick_wait() sleeps until the next tick, or until one of the  *
+ * nfds extra fds is ready. Returns the number of ticks passed, *
+ * t->last holds the tick time. Returns 0 if only fds are ready *
+ * (check their revents), and -1 on errors or signals.          *
+ * ------------------------------------------------------------ */
+int tick_wait(ticker *t, struct pollfd *fds, int nfds) {
+  struct pollfd p[1 + TICK_MAXFD];
+  uint64_t expired;
+  int i;
+
+  if(nfds > TICK_MAXFD) nfds = TICK_MAXFD;
+  p[0].fd = t->fd;
+  p[0].events = POLLIN;
+  for(i = 0; i < nfds; i++) p[i+1] = fds[i];
+
+  if(poll(p, nfds + 1, -1) == -1) return -1;
+  for(i = 0; i < nfds; i++) fds[i].revents = p[i+1].revents;
+  if(!(p[0].revents & POLLIN)) return 0;
+
+  if(read(t->fd, &expired, sizeof(expired)) != sizeof(expired)) {
+    if(errno != ECANCELED || tick_arm(t) == -1) return -1;
+    return 0;                      // clock was set, realigned
+  }
+  t->last += expired * t->period;
+  t->missed += expired - 1;
+  return (int) expired;
+}
+
+/* ------------------------------------------------------------ *
+ * tick_stop() closes the timer                                 *
+ * ------------------------------------------------------------ */
+void tick_stop(ticker *t) {
+  close(t->fd);
+  t->fd = -1;
+}
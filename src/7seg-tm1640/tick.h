@@ -0,0 +1,33 @@
+/* ------------------------------------------------------------ *
+ * file:        tick.h                                          *
+ * purpose:     Tick scheduler on a timerfd. Ticks fall on the  *
+ *              exact multiples of the period from an origin,   *
+ *              e.g. on each centisecond of the realtime clock, *
+ *              and do not drift with the loop processing time. *
+ *                                                              *
+ * author:      10/17/2026 Frank4DD                             *
+ * ------------------------------------------------------------ */
+#ifndef TICK_H
+#define TICK_H
+
+#include <time.h>
+#include <poll.h>
+
+#define TICK_MAXFD 8               // max extra fds for tick_wait()
+
+typedef struct {
+  int fd;                          // timerfd
+  clockid_t clock;                 // CLOCK_REALTIME or CLOCK_MONOTONIC
+  long long period;                // tick period in ns
+  long long origin;                // tick phase reference in ns
+  long long last;                  // time of the last tick in ns
+  unsigned long missed;            // ticks skipped by late wakeups
+} ticker;
+
+extern long long tick_ns(const struct timespec *ts);
+extern long long tick_clock(clockid_t clock);
+extern int tick_start(ticker *t, clockid_t clock, long long period, long long origin);
+extern int tick_wait(ticker *t, struct pollfd *fds, int nfds);
+extern void tick_stop(ticker *t);
+
+#endif
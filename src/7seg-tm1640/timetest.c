@@ -3,13 +3,15 @@
  * purpose:     Sample program for two 4-digit 7-Segment LED    *
  *              displays. It shows the current time on 8 digits *
  *              incl. hour, min, sec and 2 digit sub-seconds.   *
+ *              It wakes on each centisecond boundary of the    *
+ *              clock, and renders only changed text.           *
  *                                                              *
  * return:      0 on success, and -1 on errors.                 *
  *                                                              *
  * requires:    tm1640.c/.h and font.h                          *
  *              orig. in https://github.com/micolous/tm1640-rpi *
  *                                                              *
- * compile:     see Makefile, needs -lWiringPi -lm              *
+ * compile:     see Makefile, needs tick.c                      *
  *                                                              *
  * example:     ./timetest                                      *
  *                                                              *
@@ -18,37 +20,57 @@
 #define _POSIX_C_SOURCE 200809L
 #include <unistd.h>
 #include <inttypes.h>
-#include <math.h>
 #include <time.h>
 #include <stdio.h>
+#include <signal.h>
 #include "tm1640.h"
+#include "tick.h"
+
+tm1640_display *d1;                       // tm1640 display handle
+
+/* ------------------------------------------------------------ *
+ * Handler() prints the display traffic statistics on ctrl+c    *
+ * ------------------------------------------------------------ */
+void Handler(int signo) {
+  tm1640_printStats(d1, stdout);
+  exit(0);
+}
 
 int main() {
-  int res;                                // program returncode
+  int res = 0;                            // program returncode
   struct tm *time;                        // standard time struct
-  struct timespec now;                    // nanosec time struct
-  long ms = 0;                            // milliseconds
-  char timestr[10] = "000000.00";         // 7Seg display string;
-  tm1640_display *d1 = tm1640_init(3,2);  // tm1640 clock and data pins
+  ticker tick;                            // centisecond ticks
+  time_t tsnow;                           // tick time seconds
+  long cs = 0;                            // tick time centiseconds
+  tm1640_frame frame;                     // 7Seg display frame
+  char timestr[32] = "000000.00";         // 7Seg display string;
+  char shown[32] = "";                    // string on the display
+  d1 = tm1640_init(3,2);                  // tm1640 clock and data pins
+  if(d1 == NULL) return -1;
+  signal(SIGINT, Handler);                // print stats on ctrl+c
   tm1640_displayOn(d1, 2);                // display on + brightness 0..4
   tm1640_displayClear(d1);                // display zero out
 
-  while(1) {
-    /* ----------------------------------------------------------- *
-     * get current time (now)                                      *
-     * ----------------------------------------------------------- */
-    clock_gettime(CLOCK_REALTIME, &now);
-    time_t tsnow = now.tv_sec;
+  /* ------------------------------------------------------------- *
+   * wake exactly on each centisecond of the realtime clock, and   *
+   * commit right away: the digits change in phase with the clock  *
+   * ------------------------------------------------------------- */
+  if(tick_start(&tick, CLOCK_REALTIME, 10000000LL, 0) == -1) return -1;
+
+  while(tick_wait(&tick, NULL, 0) >= 0) {
+    tsnow = tick.last / 1000000000LL;
+    cs = (tick.last % 1000000000LL) / 10000000LL;
     time = gmtime(&tsnow);
-    ms = round(now.tv_nsec / 1.0e6); // Convert nanosec to millisec
-    if (ms > 999) { tsnow++; ms = 0; }
 
-    snprintf(timestr, sizeof(timestr), "%02d%02d%02d.%02lu",
-             time->tm_hour, time->tm_min, time->tm_sec, ms);
+    snprintf(timestr, sizeof(timestr), "%02d%02d%02d.%02ld",
+             time->tm_hour, time->tm_min, time->tm_sec, cs);
+    if(strcmp(timestr, shown) == 0) continue;       // nothing to render
+    strcpy(shown, timestr);
 
-    res = tm1640_displayWrite(d1, 0, timestr, strlen(timestr), INVERT_MODE_NONE);
-    if(ms < 500) tm1640_setColon(d1, 0, 1);         // display-1 Colon on
-    else tm1640_setColon(d1, 0, 0);                 // display-1 Colon off
+    tm1640_frameClear(&frame);
+    res = tm1640_frameText(&frame, 0, timestr, strlen(timestr), INVERT_MODE_NONE);
+    tm1640_frameColon(&frame, 0, cs < 50);          // display-1 Colon on 1st half
+    tm1640_frameCommit(d1, &frame);                 // send in one burst
   }
   return res;
 }
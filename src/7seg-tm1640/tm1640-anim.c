@@ -0,0 +1,96 @@
+/* ------------------------------------------------------------ *
+ * file:        tm1640-anim.c                                   *
+ * purpose:     Precompiled animations for the 7-segment digits *
+ *              e.g. a marquee of text that is longer than the  *
+ *              8 digits (node names, IP addresses). Texts are  *
+ *              translated once into a strip of segment cells,  *
+ *              playback steps are windows into the strip.      *
+ *                                                              *
+ * requires:    tm1640.c/.h                                     *
+ *                                                              *
+ * author:      10/17/2026 Frank4DD                             *
+ * ------------------------------------------------------------ */
+#define _POSIX_C_SOURCE 200809L
+#include <time.h>
+#include "tm1640.h"
+
+int tm1640_animInit(tm1640_anim* anim, int width, int offset) {
+   if(width < 1 || offset < 0 || offset + width > 8) return -EINVAL;
+   memset(anim, 0, sizeof(tm1640_anim));
+   anim->width = width;
+   anim->offset = offset;
+   return 0;
+}
+
+/* ------------------------------------------------------------ *
+ * anim_add() appends a step showing cells from start           *
+ * ------------------------------------------------------------ */
+static int anim_add(tm1640_anim* anim, int start, int hold) {
+   if(anim->count >= TM1640_ANIM_STEPS) return -ENOSPC;
+   anim->step[anim->count].start = start;
+   anim->step[anim->count].hold = hold;
+   anim->count++;
+   return 0;
+}
+
+int tm1640_animText(tm1640_anim* anim, const char * string, int invertMode, int hold, int pause) {
+   int start = anim->ncells;
+   int room = TM1640_ANIM_CELLS - start;
+   int n, pos, ret;
+
+   if(invertMode != INVERT_MODE_NONE && invertMode != INVERT_MODE_VERTICAL) return -EINVAL;
+   n = tm1640_textSegments(string, strlen(string), &anim->cells[start], room, invertMode);
+   if(n < 0) return -ENOSPC;       // does not fit the strip
+
+   // Text shorter than the display is padded with blanks
+   if(n < anim->width) {
+      if(start + anim->width > TM1640_ANIM_CELLS) return -ENOSPC;
+      memset(&anim->cells[start + n], 0, anim->width - n);
+      n = anim->width;
+   }
+   if(anim->count + n - anim->width + 1 > TM1640_ANIM_STEPS) return -ENOSPC;
+   anim->ncells += n;
+
+   // One step per digit position, pause on the first and last
+   for(pos = 0; pos <= n - anim->width; pos++) {
+      ret = anim_add(anim, start + pos, (pos == 0 || pos == n - anim->width) ? pause : hold);
+      if(ret != 0) return ret;
+   }
+   return 0;
+}
+
+int tm1640_animSegments(tm1640_anim* anim, const char * segments, int hold) {
+   if(anim->ncells + anim->width > TM1640_ANIM_CELLS) return -ENOSPC;
+   if(anim->count >= TM1640_ANIM_STEPS) return -ENOSPC;
+   memcpy(&anim->cells[anim->ncells], segments, anim->width);
+   anim_add(anim, anim->ncells, hold);
+   anim->ncells += anim->width;
+   return 0;
+}
+
+int tm1640_animStep(const tm1640_anim* anim, int index, tm1640_frame* frame) {
+   if(index < 0 || index >= anim->count) return -EINVAL;
+   memcpy(&frame->grid[anim->offset], &anim->cells[anim->step[index].start], anim->width);
+   return anim->step[index].hold;
+}
+
+int tm1640_animPlay(tm1640_display* display, const tm1640_anim* anim, int loops) {
+   struct timespec next;
+   tm1640_frame frame;
+   int i, loop;
+
+   memcpy(frame.grid, display->ram, sizeof(frame.grid));
+   clock_gettime(CLOCK_MONOTONIC, &next);
+   for(loop = 0; loops == 0 || loop < loops; loop++) {
+      for(i = 0; i < anim->count; i++) {
+         next.tv_nsec += tm1640_animStep(anim, i, &frame) * 1000000L;
+         tm1640_frameCommit(display, &frame);
+         while(next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+         }
+         if(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) != 0) return -1;
+      }
+   }
+   return 0;
+}
@@ -0,0 +1,202 @@
+/* ------------------------------------------------------------ *
+ * file:        tm1640-bench.c                                  *
+ * purpose:     Measures the TM1640 transport throughput. It    *
+ *              sends full 16-grid frames through each backend  *
+ *              built into the driver, and reports the bytes    *
+ *              per second and the CPU time used. Backends that *
+ *              fail to open (no /dev/gpiomem) are skipped.     *
+ *              With -g, it drives a group of displays sharing  *
+ *              the clock pin, and on the mock transport checks *
+ *              the decoded signal of each data line.           *
+ *                                                              *
+ * return:      0 on success, and -1 on errors.                 *
+ *                                                              *
+ * requires:    tm1640.c/.h and font.h                          *
+ *                                                              *
+ * compile:     see Makefile                                    *
+ *                                                              *
+ * example:     ./tm1640-bench -n 2000 -t mock                  *
+ *              ./tm1640-bench -t mock -g 4                     *
+ *                                                              *
+ * author:      10/17/2026 Frank4DD                             *
+ * ------------------------------------------------------------ */
+#define _POSIX_C_SOURCE 200809L
+#include <unistd.h>
+#include <time.h>
+#include <stdio.h>
+#include "tm1640.h"
+
+/* ------------------------------------------------------------ *
+ * seconds() returns the time difference between two timespecs  *
+ * ------------------------------------------------------------ */
+static double seconds(struct timespec *t1, struct timespec *t2) {
+   return (t2->tv_sec - t1->tv_sec) + (t2->tv_nsec - t1->tv_nsec) / 1.0e9;
+}
+
+/* ------------------------------------------------------------ *
+ * bench() sends full frames and prints the result line         *
+ * ------------------------------------------------------------ */
+static int bench(const tm1640_transport *transport, int frames) {
+   struct timespec wall1, wall2, cpu1, cpu2;
+   const tm1640_mock_sample *samples;
+   tm1640_frame frame;
+   char digits[10];
+   double wall, cpu;
+   int i;
+
+   tm1640_display *d1 = tm1640_initTransport(transport, 3, 2);
+   if(d1 == NULL) {
+      printf("%-10s skipped, transport not available\n", transport->name);
+      return -1;
+   }
+
+   clock_gettime(CLOCK_MONOTONIC, &wall1);
+   clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu1);
+   for(i = 0; i < frames; i++) {
+      snprintf(digits, sizeof(digits), "%08d", i % 100000000);
+      tm1640_frameClear(&frame);
+      tm1640_frameText(&frame, 0, digits, 8, INVERT_MODE_NONE);
+      tm1640_frameColon(&frame, 0, i & 1);
+      d1->ramValid = false;                // force a full frame
+      tm1640_frameCommit(d1, &frame);
+      if(transport == &tm1640_mock) tm1640_mockReset(d1);
+   }
+   clock_gettime(CLOCK_MONOTONIC, &wall2);
+   clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu2);
+   wall = seconds(&wall1, &wall2);
+   cpu = seconds(&cpu1, &cpu2);
+
+   printf("%-10s %8lu bytes %8.3f s %10.0f bytes/s CPU %5.1f%%",
+          transport->name, d1->bytesSent, wall,
+          d1->bytesSent / wall, 100.0 * cpu / wall);
+
+   /* --------------------------------------------------------- *
+    * the mock transport also knows the virtual bus time, which *
+    * is the rate a backend with exact delays would reach.      *
+    * --------------------------------------------------------- */
+   if(tm1640_mockSamples(d1, &samples) > 0) {
+      printf(" (bus limit %.0f bytes/s)",
+             d1->bytesSent * 1.0e9 / samples[0].time);
+   }
+   printf("\n");
+   tm1640_destroy(d1);
+   return 0;
+}
+
+/* ------------------------------------------------------------ *
+ * Data pins of a display group: pin 2 of the PiCon One display *
+ * first, then free header pins. Do not run -g with a hardware  *
+ * transport if these pins are wired to something else.         *
+ * ------------------------------------------------------------ */
+static const int group_pins[TM1640_GROUP_MAX] = { 2, 0, 7, 15, 16, 27, 28, 29 };
+
+/* ------------------------------------------------------------ *
+ * group_check() decodes each data line of a mock recording and *
+ * compares the last transaction with the frame of that chip.   *
+ * ------------------------------------------------------------ */
+static int group_check(tm1640_group *g, const tm1640_frame *frames) {
+   static tm1640_mock_sample line[65536];
+   static tm1640_decode_result r;
+   const tm1640_mock_sample *samples;
+   int count, i, errors = 0;
+
+   count = tm1640_groupSamples(g, &samples);
+   for(i = 0; i < g->count; i++) {
+      tm1640_decode(line, tm1640_groupLine(samples, count, i, line), &r, 0);
+      if(r.violations > 0 || r.count < 1
+         || r.tr[r.count-1].length != 1 + TM1640_GRIDS
+         || memcmp(&r.tr[r.count-1].data[1], frames[i].grid, TM1640_GRIDS) != 0) errors++;
+   }
+   return errors;
+}
+
+/* ------------------------------------------------------------ *
+ * bench_group() sends full frames to a group of displays       *
+ * ------------------------------------------------------------ */
+static int bench_group(const tm1640_transport *transport, int frames, int count) {
+   struct timespec wall1, wall2, cpu1, cpu2;
+   const tm1640_mock_sample *samples;
+   tm1640_frame frame[TM1640_GROUP_MAX];
+   char digits[10];
+   double wall, cpu;
+   int i, j, errors = 0;
+
+   tm1640_group *g = tm1640_initGroupTransport(transport, 3, group_pins, count);
+   if(g == NULL) {
+      printf("%-10s skipped, no group of %d\n", transport->name, count);
+      return -1;
+   }
+
+   clock_gettime(CLOCK_MONOTONIC, &wall1);
+   clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu1);
+   for(i = 0; i < frames; i++) {
+      for(j = 0; j < count; j++) {
+         snprintf(digits, sizeof(digits), "%08d", (i + j * 1111) % 100000000);
+         tm1640_frameClear(&frame[j]);
+         tm1640_frameText(&frame[j], 0, digits, 8, INVERT_MODE_NONE);
+         tm1640_frameColon(&frame[j], 0, (i + j) & 1);
+      }
+      g->ramValid = false;                 // force a full frame
+      g->addrMode = TM1640_MODE_UNKNOWN;
+      tm1640_groupCommit(g, frame);
+      if(transport == &tm1640_mock) {
+         errors += group_check(g, frame);
+         tm1640_groupReset(g);
+      }
+   }
+   clock_gettime(CLOCK_MONOTONIC, &wall2);
+   clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu2);
+   wall = seconds(&wall1, &wall2);
+   cpu = seconds(&cpu1, &cpu2);
+
+   printf("%-10s %d x %8lu bytes %8.3f s %10.0f bytes/s CPU %5.1f%%",
+          transport->name, count, g->bytesSent, wall,
+          count * g->bytesSent / wall, 100.0 * cpu / wall);
+   if(tm1640_groupSamples(g, &samples) > 0) {
+      printf(" (bus limit %.0f bytes/s)",
+             count * g->bytesSent * 1.0e9 / samples[0].time);
+   }
+   printf("\n");
+   tm1640_groupDestroy(g);
+   if(errors > 0) {
+      printf("Error: %d frames decoded wrong\n", errors);
+      return -1;
+   }
+   return 0;
+}
+
+int main(int argc, char *argv[]) {
+   const tm1640_transport *transport;
+   int frames = 1000;
+   int group = 0;
+   int arg, i;
+   char *name = NULL;
+
+   while ((arg = getopt(argc, argv, "n:t:g:h")) != -1) {
+      switch (arg) {
+         case 'n': frames = atoi(optarg); break;
+         case 't': name = optarg; break;
+         case 'g': group = atoi(optarg); break;
+         default:
+            printf("Usage: ./tm1640-bench [-n frames] [-t transport] [-g group size]\n");
+            return -1;
+      }
+   }
+
+   printf("TM1640 transport benchmark, %d frames of %d grids\n",
+          frames, TM1640_GRIDS);
+   if(name != NULL) {
+      if((transport = tm1640_findTransport(name)) == NULL) {
+         printf("Error: unknown transport %s\n", name);
+         return -1;
+      }
+      return (group > 0) ? bench_group(transport, frames, group) : bench(transport, frames);
+   }
+   for(i = 0; (transport = tm1640_getTransport(i)) != NULL; i++) {
+      if(group > 0) {
+         if(transport->openGroup != NULL) bench_group(transport, frames, group);
+      }
+      else bench(transport, frames);
+   }
+   return 0;
+}
@@ -18,9 +18,101 @@
 // renamed final binary as tm1640-ctl for better clarity.
 // This is a derivate copy
 
-#include "tm1640.h"
+#define _POSIX_C_SOURCE 200809L
+#include <time.h>
+#include "tm1640d.h"
+
+#define SCROLL_HOLD  300           // ms per scroll step
+#define SCROLL_PAUSE 1000          // ms on first and last position
+
+static int brightness = 1;         // "on" brightness, 1..7
+
+/* ------------------------------------------------------------ *
+ * scroll_compile() compiles a scroll command text for 8 digits *
+ * ------------------------------------------------------------ */
+static int scroll_compile(tm1640_anim *anim, const char *text, int invertMode) {
+   tm1640_animInit(anim, 8, 0);
+   return tm1640_animText(anim, text, invertMode, SCROLL_HOLD, SCROLL_PAUSE);
+}
+
+/* ------------------------------------------------------------ *
+ * daemon_cmd() sends command to tm1640d if it is running, the  *
+ * daemon owns the pins then. Returns 1 if the daemon was not   *
+ * reachable, and the display needs to be driven directly.      *
+ * ------------------------------------------------------------ */
+static int daemon_cmd(int argc, char** argv) {
+   tm1640_frame frame;
+   int fd, result = 0;
+
+   if((fd = tm1640d_connect()) < 0) return 1;
+
+   if(strcmp( argv[1], "on" ) == 0 && argc == 3) {
+      result = tm1640d_brightness(fd, brightness);
+   }
+   else if(strcmp( argv[1], "off") == 0) {
+      result = tm1640d_brightness(fd, 0);
+   }
+   else if(strcmp( argv[1], "clear") == 0) {
+      result = tm1640d_clear(fd);
+   }
+   else if((strcmp( argv[1], "write") == 0 || strcmp(argv[1], "iwrite") == 0) && argc == 3) {
+      tm1640_frameClear(&frame);
+      result = tm1640_frameText(&frame, 0, argv[2], strlen(argv[2]),
+                 (argv[1][0] == 'i') ? INVERT_MODE_VERTICAL : INVERT_MODE_NONE);
+      if(result == 0) result = tm1640d_segments(fd, 0, frame.grid, 8);
+   }
+   else if((strcmp( argv[1], "scroll") == 0 || strcmp(argv[1], "iscroll") == 0) && argc == 3) {
+      /* ------------------------------------------------------ *
+       * the daemon gets one segments message per step, on the  *
+       * same absolute step times as tm1640_animPlay            *
+       * ------------------------------------------------------ */
+      static tm1640_anim anim;
+      struct timespec next;
+      int i;
+      result = scroll_compile(&anim, argv[2],
+                 (argv[1][0] == 'i') ? INVERT_MODE_VERTICAL : INVERT_MODE_NONE);
+      clock_gettime(CLOCK_MONOTONIC, &next);
+      for(i = 0; result == 0 && i < anim.count; i++) {
+         next.tv_nsec += tm1640_animStep(&anim, i, &frame) * 1000000L;
+         result = tm1640d_segments(fd, 0, frame.grid, 8);
+         while(next.tv_nsec >= 1000000000L) {
+            next.tv_nsec -= 1000000000L;
+            next.tv_sec++;
+         }
+         clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+      }
+   }
+   else {
+      fprintf(stderr, "Invalid command\n");
+      exit(EXIT_FAILURE);
+   }
+
+   tm1640d_close(fd);
+   if (result != 0) {
+      fprintf(stderr, "%s: error %d\n", argv[0], result);
+      exit(EXIT_FAILURE);
+   }
+   return 0;
+}
 
 int main( int argc, char** argv ) {
+   /* ------------------------------------------------------------ *
+    * check the "on" brightness once, so the daemon and the direct *
+    * path both get the same 1..7 value                            *
+    * ------------------------------------------------------------ */
+   if(argc == 3 && strcmp( argv[1], "on" ) == 0) {
+      char *end;
+      brightness = strtol(argv[2], &end, 10);
+      if(argv[2][0] == '\0' || *end != '\0') {
+         fprintf(stderr, "%s: invalid brightness %s\n", argv[0], argv[2]);
+         return (EXIT_FAILURE);
+      }
+      if(brightness < 1) brightness = 1;
+      if(brightness > 7) brightness = 7;
+   }
+
+   if(argc > 1 && daemon_cmd(argc, argv) == 0) return (EXIT_SUCCESS);
+
    tm1640_display* display = tm1640_init(3, 2);
    if (display == NULL) {
       fprintf(stderr, "%s: display initialisation failed\n", argv[0]);
@@ -29,7 +121,7 @@ int main( int argc, char** argv ) {
    
    if(argc > 1) {
       if(strcmp( argv[1], "on" ) == 0 && argc == 3) {
-         tm1640_displayOn(display, atoi(argv[2]));
+         tm1640_displayOn(display, brightness);
       }
       else if(strcmp( argv[1], "off") == 0) {
          tm1640_displayOff(display);
@@ -50,6 +142,16 @@ int main( int argc, char** argv ) {
             fprintf(stderr, "%s: error %d\n", argv[0], result);
             return (EXIT_FAILURE);
          }
+      }
+      else if ((strcmp(argv[1], "scroll") == 0 || strcmp(argv[1], "iscroll") == 0) && argc == 3) {
+         static tm1640_anim anim;
+         int result = scroll_compile(&anim, argv[2],
+                        (argv[1][0] == 'i') ? INVERT_MODE_VERTICAL : INVERT_MODE_NONE);
+         if (result == 0) result = tm1640_animPlay(display, &anim, 1);
+         if (result != 0) {
+            fprintf(stderr, "%s: error %d\n", argv[0], result);
+            return (EXIT_FAILURE);
+         }
       } else {
          fprintf(stderr, "Invalid command\n");
          return (EXIT_FAILURE);
@@ -61,7 +163,9 @@ int main( int argc, char** argv ) {
       fprintf(stderr, "  tm1640-ctl on <0..7>  : Turn on and set brightness. 1 (lowest)..7 (highest)\n");
       fprintf(stderr, "  tm1640-ctl off        : Turn off display, preserving data.\n");
       fprintf(stderr, "  tm1640-ctl clear      : Clear display.\n");
-      fprintf(stderr, "  tm1640-ctl write <num>: Write digit to display, up to 8 digits.\n");      
+      fprintf(stderr, "  tm1640-ctl write <num>: Write digit to display, up to 8 digits.\n");
+      fprintf(stderr, "  tm1640-ctl scroll <txt>: Scroll text longer than 8 digits once.\n");
+      fprintf(stderr, "Commands go to tm1640d if it is running, otherwise to the display directly.\n");
       return (EXIT_FAILURE);
    }
    return (EXIT_SUCCESS);
@@ -0,0 +1,130 @@
+/* ------------------------------------------------------------ *
+ * file:        tm1640-decode.c                                 *
+ * purpose:     Offline TM1640 protocol decoder. It rebuilds    *
+ *              the bytes sent from recorded pin transitions    *
+ *              (mock or tap transport), and checks the start,  *
+ *              stop, clock pulse and data setup/hold timings   *
+ *              against the datasheet minimum values.           *
+ *                                                              *
+ *              start: DIN H->L while SCLK=H                    *
+ *              data:  DIN sampled on SCLK L->H, LSB first      *
+ *                     (bit complete on the next SCLK H->L)     *
+ *              stop:  DIN L->H while SCLK=H                    *
+ *                                                              *
+ * requires:    tm1640.c/.h                                     *
+ *                                                              *
+ * author:      10/17/2026 Frank4DD                             *
+ * ------------------------------------------------------------ */
+#include <limits.h>
+#include "tm1640.h"
+
+/* ------------------------------------------------------------ *
+ * violation() counts and optionally prints a protocol error    *
+ * ------------------------------------------------------------ */
+static void violation(tm1640_decode_result *r, int verbose,
+                      unsigned long long time, const char *what,
+                      unsigned long long ns, unsigned int min) {
+   r->violations++;
+   if(verbose == 1) {
+      fprintf(stderr, "Decode: t=%llu ns transaction %d: %s", time, r->count, what);
+      if(min > 0) fprintf(stderr, " %llu ns < %u ns", ns, min);
+      fprintf(stderr, "\n");
+   }
+}
+
+/* ------------------------------------------------------------ *
+ * check() compares a measured timing against its minimum, and  *
+ * keeps the smallest value seen                                *
+ * ------------------------------------------------------------ */
+static void check(tm1640_decode_result *r, int verbose, unsigned long long time,
+                  const char *what, unsigned long long ns, unsigned int min,
+                  unsigned long long *least) {
+   if(ns < *least) *least = ns;
+   if(ns < min) violation(r, verbose, time, what, ns, min);
+}
+
+int tm1640_decode(const tm1640_mock_sample * samples, int count, tm1640_decode_result * r, int verbose) {
+   tm1640_transaction scratch;            // used when r->tr is full
+   tm1640_transaction *t = &scratch;
+   unsigned long long now, rise = 0, fall = 0, change = 0, start = 0;
+   unsigned char byte = 0;
+   int active = 0, firstFall = 0, bit = 0;
+   int pending = -1;                      // bit sampled, clock still high
+   int i;
+
+   memset(r, 0, sizeof(tm1640_decode_result));
+   r->minSetup = r->minHold = ULLONG_MAX;
+   r->minClockHigh = r->minClockLow = ULLONG_MAX;
+
+   for(i = 1; i < count; i++) {
+      const tm1640_mock_sample *prev = &samples[i-1];
+      const tm1640_mock_sample *cur = &samples[i];
+      now = cur->time;
+
+      /* ------------------------------------------------------ *
+       * clock edges: sample data on the rising edge            *
+       * ------------------------------------------------------ */
+      if(cur->clock != prev->clock) {
+         if(cur->clock) {
+            if(active) {
+               if(!firstFall) check(r, verbose, now, "clock low", now - fall, TM1640_MIN_PULSE_NS, &r->minClockLow);
+               check(r, verbose, now, "data setup", now - change, TM1640_MIN_SETUP_NS, &r->minSetup);
+               pending = cur->data ? 1 : 0;
+            }
+            rise = now;
+         } else {
+            if(active && firstFall) {
+               check(r, verbose, now, "start hold", now - start, TM1640_MIN_HOLD_NS, &r->minHold);
+               firstFall = 0;
+            } else if(active) {
+               check(r, verbose, now, "clock high", now - rise, TM1640_MIN_PULSE_NS, &r->minClockHigh);
+            }
+            /* --------------------------------------------------- *
+             * the bit sampled on the rising edge is only complete *
+             * here, the rising edge before a stop carries no data *
+             * --------------------------------------------------- */
+            if(active && pending >= 0) {
+               byte |= pending << bit;
+               if(++bit == 8) {
+                  if(t->length < (int) sizeof(t->data)) t->data[t->length++] = byte;
+                  else violation(r, verbose, now, "transaction too long", 0, 0);
+                  byte = 0;
+                  bit = 0;
+               }
+            }
+            pending = -1;
+            fall = now;
+         }
+      }
+
+      /* ------------------------------------------------------ *
+       * data edges: start/stop with clock high, else data bits *
+       * ------------------------------------------------------ */
+      if(cur->data != prev->data) {
+         if(cur->clock && prev->clock) {
+            if(!cur->data) {
+               if(active) violation(r, verbose, now, "start inside transaction", 0, 0);
+               t = (r->count < TM1640_DECODE_MAX) ? &r->tr[r->count] : &scratch;
+               memset(t, 0, sizeof(tm1640_transaction));
+               active = 1;
+               firstFall = 1;
+               start = now;
+               pending = -1;
+               byte = 0;
+               bit = 0;
+            } else if(active) {
+               check(r, verbose, now, "stop setup", now - rise, TM1640_MIN_SETUP_NS, &r->minSetup);
+               t->bits = bit;
+               if(bit != 0) violation(r, verbose, now, "incomplete byte", 0, 0);
+               if(r->count < TM1640_DECODE_MAX) r->count++;
+               active = 0;
+            }
+         } else if(active && !cur->clock) {
+            check(r, verbose, now, "data hold", now - rise, TM1640_MIN_HOLD_NS, &r->minHold);
+         }
+         change = now;
+      }
+   }
+   if(active) violation(r, verbose, now, "no stop condition", 0, 0);
+   return r->violations;
+}
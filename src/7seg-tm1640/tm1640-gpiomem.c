@@ -0,0 +1,171 @@
+/* ------------------------------------------------------------ *
+ * file:        tm1640-gpiomem.c                                *
+ * purpose:     TM1640 transport backend with direct register   *
+ *              access to the BCM283x GPIO block. The registers *
+ *              are mapped through /dev/gpiomem, which does not *
+ *              need root permissions (group gpio is enough).   *
+ *              Each pin change is a single store to the GPSET0 *
+ *              or GPCLR0 register. Groups drive all data pins  *
+ *              with one GPSET0 and one GPCLR0 store per bit.   *
+ *                                                              *
+ * requires:    tm1640.c/.h                                     *
+ *                                                              *
+ * author:      10/17/2026 Frank4DD                             *
+ * ------------------------------------------------------------ */
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "tm1640.h"
+
+/* ------------------------------------------------------------ *
+ * GPIO register word offsets, see BCM2835 ARM peripherals 6.1  *
+ * ------------------------------------------------------------ */
+#define GPIO_FSEL0  0              // function select, 3 bits/pin
+#define GPIO_SET0   7              // output set, write 1 = high
+#define GPIO_CLR0  10              // output clear, write 1 = low
+#define GPIO_MAPLEN 0xB4           // register block size
+
+/* ------------------------------------------------------------ *
+ * WiringPi pin number to BCM GPIO number (board rev 2 and up)  *
+ * ------------------------------------------------------------ */
+static const int wpi_to_bcm[32] = {
+   17, 18, 27, 22, 23, 24, 25,  4,  2,  3,  8,  7, 10,  9, 11, 14,
+   15, -1, -1, -1, -1,  5,  6, 13, 19, 26, 12, 16, 20, 21,  0,  1
+};
+
+typedef struct {
+   volatile uint32_t *gpio;        // mapped register block
+   uint32_t clockMask;             // SCLK bit in GPSET0/GPCLR0
+   uint32_t dataMask;              // DIN bit in GPSET0/GPCLR0
+   uint32_t *lineSet;              // group: DIN bits set per lines value
+} gpiomem_ctx;
+
+/* ------------------------------------------------------------ *
+ * gpiomem_output() sets the BCM pin function to output         *
+ * ------------------------------------------------------------ */
+static void gpiomem_output(volatile uint32_t *gpio, int bcm) {
+   int reg = GPIO_FSEL0 + bcm / 10;
+   int shift = (bcm % 10) * 3;
+   gpio[reg] = (gpio[reg] & ~(7u << shift)) | (1u << shift);
+}
+
+/* ------------------------------------------------------------ *
+ * gpiomem_valid() checks a WiringPi pin has a BCM GPIO number  *
+ * ------------------------------------------------------------ */
+static int gpiomem_valid(int pin) {
+   return (pin >= 0 && pin <= 31 && wpi_to_bcm[pin] >= 0);
+}
+
+/* ------------------------------------------------------------ *
+ * gpiomem_map() maps the register block, NULL on failure       *
+ * ------------------------------------------------------------ */
+static volatile uint32_t* gpiomem_map(void) {
+   void *map;
+   int fd;
+
+   if((fd = open("/dev/gpiomem", O_RDWR | O_SYNC)) == -1) return NULL;
+   map = mmap(NULL, GPIO_MAPLEN, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+   close(fd);
+   if(map == MAP_FAILED) return NULL;
+   return (volatile uint32_t *) map;
+}
+
+static void* gpiomem_open(int clockPin, int dataPin) {
+   volatile uint32_t *gpio;
+   gpiomem_ctx *ctx;
+
+   if(!gpiomem_valid(clockPin) || !gpiomem_valid(dataPin)) return NULL;
+   if((gpio = gpiomem_map()) == NULL) return NULL;
+
+   ctx = malloc(sizeof(gpiomem_ctx));
+   ctx->gpio = gpio;
+   ctx->clockMask = 1u << wpi_to_bcm[clockPin];
+   ctx->dataMask = 1u << wpi_to_bcm[dataPin];
+   ctx->lineSet = NULL;
+
+   tm1640_calibrate();
+   ctx->gpio[GPIO_SET0] = ctx->clockMask | ctx->dataMask;
+   gpiomem_output(ctx->gpio, wpi_to_bcm[clockPin]);
+   gpiomem_output(ctx->gpio, wpi_to_bcm[dataPin]);
+   return ctx;
+}
+
+/* ------------------------------------------------------------ *
+ * gpiomem_openGroup() precomputes the GPSET0 word for each of  *
+ * the 1 << count line values, dataMask holds all DIN bits.     *
+ * ------------------------------------------------------------ */
+static void* gpiomem_openGroup(int clockPin, const int *dataPins, int count) {
+   volatile uint32_t *gpio;
+   gpiomem_ctx *ctx;
+   unsigned int lines;
+   int i;
+
+   if(count < 1 || count > TM1640_GROUP_MAX || !gpiomem_valid(clockPin)) return NULL;
+   for(i = 0; i < count; i++) {
+      if(!gpiomem_valid(dataPins[i])) return NULL;
+   }
+   if((gpio = gpiomem_map()) == NULL) return NULL;
+
+   ctx = malloc(sizeof(gpiomem_ctx));
+   ctx->gpio = gpio;
+   ctx->clockMask = 1u << wpi_to_bcm[clockPin];
+   ctx->dataMask = 0;
+   ctx->lineSet = malloc((1u << count) * sizeof(uint32_t));
+   for(lines = 0; lines < (1u << count); lines++) {
+      ctx->lineSet[lines] = 0;
+      for(i = 0; i < count; i++) {
+         if(lines & (1u << i)) ctx->lineSet[lines] |= 1u << wpi_to_bcm[dataPins[i]];
+      }
+   }
+   ctx->dataMask = ctx->lineSet[(1u << count) - 1];
+
+   tm1640_calibrate();
+   ctx->gpio[GPIO_SET0] = ctx->clockMask | ctx->dataMask;
+   gpiomem_output(ctx->gpio, wpi_to_bcm[clockPin]);
+   for(i = 0; i < count; i++) gpiomem_output(ctx->gpio, wpi_to_bcm[dataPins[i]]);
+   return ctx;
+}
+
+static void gpiomem_setClock(void *ctx, int level) {
+   gpiomem_ctx *g = ctx;
+   g->gpio[level ? GPIO_SET0 : GPIO_CLR0] = g->clockMask;
+}
+
+static void gpiomem_setData(void *ctx, int level) {
+   gpiomem_ctx *g = ctx;
+   g->gpio[level ? GPIO_SET0 : GPIO_CLR0] = g->dataMask;
+}
+
+static void gpiomem_setLines(void *ctx, unsigned int lines) {
+   gpiomem_ctx *g = ctx;
+   uint32_t set = g->lineSet[lines];
+   g->gpio[GPIO_SET0] = set;
+   g->gpio[GPIO_CLR0] = g->dataMask & ~set;
+}
+
+/* ------------------------------------------------------------ *
+ * gpiomem_delay() busy-waits, nanosleep would reschedule and   *
+ * take 50us+ on the Pi Zero for a 1us delay.                   *
+ * ------------------------------------------------------------ */
+static void gpiomem_delay(void *ctx, unsigned int ns) {
+   tm1640_delayNs(ns);
+}
+
+static void gpiomem_close(void *ctx) {
+   gpiomem_ctx *g = ctx;
+   munmap((void *) g->gpio, GPIO_MAPLEN);
+   free(g->lineSet);
+   free(g);
+}
+
+const tm1640_transport tm1640_gpiomem = {
+   "gpiomem",
+   gpiomem_open,
+   gpiomem_setClock,
+   gpiomem_setData,
+   gpiomem_delay,
+   gpiomem_close,
+   gpiomem_openGroup,
+   gpiomem_setLines
+};
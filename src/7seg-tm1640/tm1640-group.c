@@ -0,0 +1,162 @@
+/* ------------------------------------------------------------ *
+ * file:        tm1640-group.c                                  *
+ * purpose:     Drives several TM1640 chips that share one      *
+ *              clock pin, and have one data pin each. The bits *
+ *              for all chips are shifted out in parallel: each *
+ *              bit period sets all data pins at once through   *
+ *              the transport setLines call, followed by one    *
+ *              clock pulse. N displays take the bus time of 1. *
+ *                                                              *
+ * requires:    tm1640.c/.h                                     *
+ *                                                              *
+ * author:      10/17/2026 Frank4DD                             *
+ * ------------------------------------------------------------ */
+#include "tm1640.h"
+
+tm1640_group* tm1640_initGroup(int clockPin, const int * dataPins, int count) {
+   const tm1640_transport* transport = tm1640_findTransport(NULL);
+   if(transport == NULL) {
+     printf("Error unknown TM1640_TRANSPORT %s\n", getenv("TM1640_TRANSPORT"));
+     return NULL;
+   }
+   return tm1640_initGroupTransport(transport, clockPin, dataPins, count);
+}
+
+tm1640_group* tm1640_initGroupTransport(const tm1640_transport* transport, int clockPin, const int * dataPins, int count) {
+   void *ctx;
+   if(transport->openGroup == NULL) {
+     printf("Error %s transport has no group support\n", transport->name);
+     return NULL;
+   }
+   if(count < 1 || count > TM1640_GROUP_MAX) return NULL;
+   if((ctx = transport->openGroup(clockPin, dataPins, count)) == NULL) {
+     printf("Error %s transport\n", transport->name);
+     return NULL;
+   }
+   tm1640_group* group = malloc(sizeof(tm1640_group));
+   memset(group, 0, sizeof(tm1640_group));
+   group->clockPin = clockPin;
+   memcpy(group->dataPins, dataPins, count * sizeof(int));
+   group->count = count;
+   group->transport = transport;
+   group->ctx = ctx;
+   group->delayNs = TM1640_DELAY_NS;
+   if(getenv("TM1640_DELAY_NS") != NULL) group->delayNs = atoi(getenv("TM1640_DELAY_NS"));
+   return group;
+}
+
+void tm1640_groupDestroy(tm1640_group* group) {
+   group->transport->close(group->ctx);
+   free(group);
+}
+
+static void group_wait(tm1640_group* group) {
+   group->transport->delay(group->ctx, group->delayNs);
+}
+
+/* ------------------------------------------------------------ *
+ * group_send() sends one transaction to all chips. bytes holds *
+ * len bytes per chip, bytes[i * stride + n] is byte n of chip  *
+ * i. The bit timing matches tm1640_send.                       *
+ * ------------------------------------------------------------ */
+static void group_send(tm1640_group* group, const unsigned char *bytes, int stride, int len) {
+   const tm1640_transport *t = group->transport;
+   unsigned int lines;
+   int n, bit, i;
+
+   // start: CLK=H, all DIN H->L
+   t->setLines(group->ctx, 0);
+   group_wait(group);
+   t->setClock(group->ctx, 0);
+   group_wait(group);
+
+   for(n = 0; n < len; n++) {
+      for(bit = 0; bit < 8; bit++) {
+         lines = 0;
+         for(i = 0; i < group->count; i++) {
+            lines |= ((bytes[i * stride + n] >> bit) & 1) << i;
+         }
+         t->setLines(group->ctx, lines);
+         group_wait(group);
+         t->setClock(group->ctx, 1);
+         group_wait(group);
+         t->setClock(group->ctx, 0);
+      }
+   }
+
+   // stop: CLK=H, all DIN L->H
+   t->setLines(group->ctx, 0);
+   group_wait(group);
+   t->setClock(group->ctx, 1);
+   group_wait(group);
+   t->setLines(group->ctx, (1u << group->count) - 1);
+   group_wait(group);
+}
+
+/* ------------------------------------------------------------ *
+ * group_cmd() sends the same command byte to all chips         *
+ * ------------------------------------------------------------ */
+static void group_cmd(tm1640_group* group, unsigned char cmd) {
+   unsigned char bytes[TM1640_GROUP_MAX];
+   memset(bytes, cmd, sizeof(bytes));
+   group_send(group, bytes, 1, 1);
+}
+
+int tm1640_groupCommit(tm1640_group* group, const tm1640_frame * frames) {
+   unsigned char bytes[TM1640_GROUP_MAX][1 + TM1640_GRIDS];
+   int first = TM1640_GRIDS, last = -1;
+   int grid, i, sent;
+
+   // Union of the changed spans of all chips
+   for(i = 0; i < group->count; i++) {
+      for(grid = 0; grid < TM1640_GRIDS; grid++) {
+         if(!group->ramValid || frames[i].grid[grid] != group->ram[i][grid]) {
+            if(grid < first) first = grid;
+            if(grid > last) last = grid;
+         }
+      }
+   }
+   if(last < 0) {
+      group->bytesSaved += group->count * TM1640_FULL_WRITE;
+      return 0;
+   }
+
+   // Address command and the span for each chip, all chips get the
+   // same span, unchanged grids are rewritten with the same data.
+   for(i = 0; i < group->count; i++) {
+      bytes[i][0] = 0xC0 + first;
+      memcpy(&bytes[i][1], &frames[i].grid[first], last - first + 1);
+      memcpy(group->ram[i], frames[i].grid, TM1640_GRIDS);
+   }
+   sent = 1 + last - first + 1;
+   if(group->addrMode != TM1640_MODE_AUTO) {
+      group_cmd(group, 0x40);
+      group->addrMode = TM1640_MODE_AUTO;
+      sent++;
+   }
+   group_send(group, &bytes[0][0], sizeof(bytes[0]), 1 + last - first + 1);
+
+   group->ramValid = true;
+   group->bytesSent += sent;
+   group->bytesSaved += group->count * TM1640_FULL_WRITE - sent;
+   return sent;
+}
+
+void tm1640_groupOn(tm1640_group* group, char brightness) {
+   if (brightness < 1) brightness = 1;
+   if (brightness > 7) brightness = 7;
+   group_cmd(group, 0x40);
+   group->addrMode = TM1640_MODE_AUTO;
+   group_cmd(group, 0x88 + brightness);
+}
+
+void tm1640_groupOff(tm1640_group* group) {
+   group_cmd(group, 0x40);
+   group->addrMode = TM1640_MODE_AUTO;
+   group_cmd(group, 0x80);
+}
+
+void tm1640_groupStats(tm1640_group* group, FILE * out) {
+   fprintf(out, "TM1640 group of %d, bytes sent: %lu, bytes saved: %lu\n",
+           group->count, group->bytesSent, group->bytesSaved);
+}
@@ -0,0 +1,227 @@
+/* ------------------------------------------------------------ *
+ * file:        tm1640-mock.c                                   *
+ * purpose:     TM1640 transport backend that drives no pins.   *
+ *              It records every clock and data transition with *
+ *              a virtual timestamp, so the driver builds and   *
+ *              runs on any Linux box, and the recorded signal  *
+ *              can be checked offline.                         *
+ *              In groups, data records one bit per data pin.   *
+ *              With GPIO_SIM_LOG set, each pin change is also  *
+ *              logged with its real time, see gpio-sim.c.      *
+ *              The tap transport passes the pin changes on to  *
+ *              a real backend, and records them with the real  *
+ *              CLOCK_MONOTONIC time for waveform validation.   *
+ *                                                              *
+ * requires:    tm1640.c/.h, gpio-sim.c/.h                      *
+ *                                                              *
+ * author:      10/17/2026 Frank4DD                             *
+ * ------------------------------------------------------------ */
+#define _POSIX_C_SOURCE 200809L
+#include <time.h>
+#include "tm1640.h"
+#include "gpio-sim.h"
+
+#define MOCK_MAX_SAMPLES 65536     // recording stops when full
+
+typedef struct {
+   unsigned long long time;        // virtual time in ns
+   char clock;                     // current SCLK level
+   char data;                      // current DIN level
+   int pins[1 + TM1640_GROUP_MAX]; // SCLK + DIN BCM GPIO, for the log
+   int lines;                      // number of DIN pins
+   int count;                      // recorded transitions
+   tm1640_mock_sample *samples;    // transition buffer
+   const tm1640_transport *target; // tap only: backend driven
+   void *targetCtx;                // tap only: backend context
+   struct timespec origin;         // tap only: time zero
+} mock_ctx;
+
+const tm1640_transport* tm1640_tapTarget = &tm1640_gpiomem;
+
+/* ------------------------------------------------------------ *
+ * mock_record() stores a transition if the buffer has space    *
+ * ------------------------------------------------------------ */
+static void mock_record(mock_ctx *m) {
+   if(m->count >= MOCK_MAX_SAMPLES) return;
+   m->samples[m->count].time = m->time;
+   m->samples[m->count].clock = m->clock;
+   m->samples[m->count].data = m->data;
+   m->count++;
+}
+
+static void* mock_open(int clockPin, int dataPin) {
+   mock_ctx *m = malloc(sizeof(mock_ctx));
+   memset(m, 0, sizeof(mock_ctx));
+   m->samples = malloc(MOCK_MAX_SAMPLES * sizeof(tm1640_mock_sample));
+   m->clock = 1;
+   m->data = 1;
+   m->pins[0] = gpiosim_wpi(clockPin);
+   m->pins[1] = gpiosim_wpi(dataPin);
+   m->lines = 1;
+   if(gpiosim_open() == -1) {
+      free(m->samples);
+      free(m);
+      return NULL;
+   }
+   mock_record(m);
+   return m;
+}
+
+static void* mock_openGroup(int clockPin, const int *dataPins, int count) {
+   mock_ctx *m;
+   int i;
+   if(count < 1 || count > TM1640_GROUP_MAX) return NULL;
+   if((m = mock_open(clockPin, dataPins[0])) == NULL) return NULL;
+   for(i = 0; i < count; i++) m->pins[1 + i] = gpiosim_wpi(dataPins[i]);
+   m->lines = count;
+   m->data = (1 << count) - 1;
+   m->samples[0].data = m->data;
+   return m;
+}
+
+static void mock_setClock(void *ctx, int level) {
+   mock_ctx *m = ctx;
+   if(m->clock == (level != 0)) return;
+   m->clock = (level != 0);
+   mock_record(m);
+   gpiosim_output(m->pins[0], m->clock);
+}
+
+static void mock_setData(void *ctx, int level) {
+   mock_ctx *m = ctx;
+   if(m->data == (level != 0)) return;
+   m->data = (level != 0);
+   mock_record(m);
+   gpiosim_output(m->pins[1], m->data);
+}
+
+static void mock_setLines(void *ctx, unsigned int lines) {
+   mock_ctx *m = ctx;
+   int i;
+   if(m->data == (char) lines) return;
+   m->data = lines;
+   mock_record(m);
+   for(i = 0; i < m->lines; i++) gpiosim_output(m->pins[1 + i], (lines >> i) & 1);
+}
+
+static void mock_delay(void *ctx, unsigned int ns) {
+   ((mock_ctx *) ctx)->time += ns;
+}
+
+static void mock_close(void *ctx) {
+   mock_ctx *m = ctx;
+   free(m->samples);
+   free(m);
+}
+
+const tm1640_transport tm1640_mock = {
+   "mock",
+   mock_open,
+   mock_setClock,
+   mock_setData,
+   mock_delay,
+   mock_close,
+   mock_openGroup,
+   mock_setLines
+};
+
+/* ------------------------------------------------------------ *
+ * tap_now() sets the recording time to the real time in ns     *
+ * ------------------------------------------------------------ */
+static void tap_now(mock_ctx *m) {
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   m->time = (now.tv_sec - m->origin.tv_sec) * 1000000000ULL
+             + now.tv_nsec - m->origin.tv_nsec;
+}
+
+static void* tap_open(int clockPin, int dataPin) {
+   void *targetCtx = tm1640_tapTarget->open(clockPin, dataPin);
+   if(targetCtx == NULL) return NULL;
+   mock_ctx *m = mock_open(clockPin, dataPin);
+   if(m == NULL) {
+      tm1640_tapTarget->close(targetCtx);
+      return NULL;
+   }
+   m->target = tm1640_tapTarget;
+   m->targetCtx = targetCtx;
+   clock_gettime(CLOCK_MONOTONIC, &m->origin);
+   return m;
+}
+
+static void tap_setClock(void *ctx, int level) {
+   mock_ctx *m = ctx;
+   m->target->setClock(m->targetCtx, level);
+   tap_now(m);
+   mock_setClock(ctx, level);
+}
+
+static void tap_setData(void *ctx, int level) {
+   mock_ctx *m = ctx;
+   m->target->setData(m->targetCtx, level);
+   tap_now(m);
+   mock_setData(ctx, level);
+}
+
+static void tap_delay(void *ctx, unsigned int ns) {
+   mock_ctx *m = ctx;
+   m->target->delay(m->targetCtx, ns);
+}
+
+static void tap_close(void *ctx) {
+   mock_ctx *m = ctx;
+   m->target->close(m->targetCtx);
+   mock_close(ctx);
+}
+
+const tm1640_transport tm1640_tap = {
+   "tap",
+   tap_open,
+   tap_setClock,
+   tap_setData,
+   tap_delay,
+   tap_close,
+   NULL,                           // no group support
+   NULL
+};
+
+int tm1640_mockSamples(tm1640_display* display, const tm1640_mock_sample ** samples) {
+   mock_ctx *m = display->ctx;
+   if(display->transport != &tm1640_mock && display->transport != &tm1640_tap) return -EINVAL;
+   *samples = m->samples;
+   return m->count;
+}
+
+void tm1640_mockReset(tm1640_display* display) {
+   mock_ctx *m = display->ctx;
+   if(display->transport != &tm1640_mock && display->transport != &tm1640_tap) return;
+   m->count = 0;
+   mock_record(m);
+}
+
+int tm1640_groupSamples(tm1640_group* group, const tm1640_mock_sample ** samples) {
+   mock_ctx *m = group->ctx;
+   if(group->transport != &tm1640_mock) return -EINVAL;
+   *samples = m->samples;
+   return m->count;
+}
+
+void tm1640_groupReset(tm1640_group* group) {
+   mock_ctx *m = group->ctx;
+   if(group->transport != &tm1640_mock) return;
+   m->count = 0;
+   mock_record(m);
+}
+
+int tm1640_groupLine(const tm1640_mock_sample * samples, int count, int line, tm1640_mock_sample * out) {
+   int i, n = 0;
+   for(i = 0; i < count; i++) {
+      char data = (samples[i].data >> line) & 1;
+      if(n > 0 && out[n-1].clock == samples[i].clock && out[n-1].data == data) continue;
+      out[n].time = samples[i].time;
+      out[n].clock = samples[i].clock;
+      out[n].data = data;
+      n++;
+   }
+   return n;
+}
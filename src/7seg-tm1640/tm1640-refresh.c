@@ -0,0 +1,105 @@
+/* ------------------------------------------------------------ *
+ * file:        tm1640-refresh.c                                *
+ * purpose:     Background refresh thread for the TM1640. The   *
+ *              application publishes frames into a lock-free   *
+ *              exchange buffer, the thread wakes at a fixed    *
+ *              rate and sends the newest frame, if there is    *
+ *              one. The bus is only touched on changes, and    *
+ *              the producer never waits for the bit-banging.   *
+ *                                                              *
+ * requires:    tm1640.c/.h, -lpthread                          *
+ *                                                              *
+ * author:      10/17/2026 Frank4DD                             *
+ * ------------------------------------------------------------ */
+#define _POSIX_C_SOURCE 200809L
+#include <time.h>
+#include "tm1640.h"
+
+/* ------------------------------------------------------------ *
+ * refresh_take() swaps in the newest published frame. Returns  *
+ * 1 if the front buffer now holds a frame not seen before.     *
+ * ------------------------------------------------------------ */
+static int refresh_take(tm1640_refresh *r) {
+   if(!(atomic_load(&r->middle) & TM1640_REFRESH_NEW)) return 0;
+   r->front = atomic_exchange(&r->middle, r->front) & 3;
+   return 1;
+}
+
+/* ------------------------------------------------------------ *
+ * refresh_control() sends a queued display control command     *
+ * ------------------------------------------------------------ */
+static void refresh_control(tm1640_refresh *r) {
+   int cmd = atomic_exchange(&r->control, -1);
+   if(cmd >= 0) tm1640_sendCmd(r->display, (char) cmd);
+}
+
+/* ------------------------------------------------------------ *
+ * refresh_thread() commits new frames at the refresh rate. The *
+ * wakeups are absolute, so a slow commit does not add drift.   *
+ * ------------------------------------------------------------ */
+static void* refresh_thread(void *arg) {
+   tm1640_refresh *r = arg;
+   struct timespec next;
+
+   clock_gettime(CLOCK_MONOTONIC, &next);
+   while(atomic_load(&r->running)) {
+      next.tv_nsec += r->periodNs;
+      while(next.tv_nsec >= 1000000000L) {
+         next.tv_nsec -= 1000000000L;
+         next.tv_sec++;
+      }
+      clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+      refresh_control(r);
+      if(refresh_take(r)) {
+         tm1640_frameCommit(r->display, &r->buffer[r->front]);
+         atomic_fetch_add(&r->committed, 1);
+      }
+   }
+   // last frame and command published before the stop
+   refresh_control(r);
+   if(refresh_take(r)) {
+      tm1640_frameCommit(r->display, &r->buffer[r->front]);
+      atomic_fetch_add(&r->committed, 1);
+   }
+   return NULL;
+}
+
+tm1640_refresh* tm1640_refreshStart(tm1640_display* display, int hz) {
+   tm1640_refresh *r;
+   if(hz < 1) return NULL;
+
+   r = malloc(sizeof(tm1640_refresh));
+   memset(r, 0, sizeof(tm1640_refresh));
+   r->display = display;
+   r->back = 0;
+   r->front = 1;
+   atomic_init(&r->middle, 2);
+   atomic_init(&r->control, -1);
+   atomic_init(&r->running, 1);
+   atomic_init(&r->published, 0);
+   atomic_init(&r->committed, 0);
+   r->periodNs = 1000000000L / hz;
+
+   if(pthread_create(&r->thread, NULL, refresh_thread, r) != 0) {
+      free(r);
+      return NULL;
+   }
+   return r;
+}
+
+void tm1640_refreshPublish(tm1640_refresh* refresh, const tm1640_frame* frame) {
+   memcpy(&refresh->buffer[refresh->back], frame, sizeof(tm1640_frame));
+   refresh->back = atomic_exchange(&refresh->middle, refresh->back | TM1640_REFRESH_NEW) & 3;
+   atomic_fetch_add(&refresh->published, 1);
+}
+
+void tm1640_refreshControl(tm1640_refresh* refresh, char cmd) {
+   atomic_store(&refresh->control, (unsigned char) cmd);
+}
+
+void tm1640_refreshStop(tm1640_refresh* refresh) {
+   atomic_store(&refresh->running, 0);
+   pthread_join(refresh->thread, NULL);
+   free(refresh);
+}
@@ -0,0 +1,57 @@
+/* ------------------------------------------------------------ *
+ * file:        tm1640-timing.c                                 *
+ * purpose:     Calibrated busy-wait for the TM1640 bit timing. *
+ *              A spin loop is timed against CLOCK_MONOTONIC    *
+ *              once, then delays are counted in loop cycles    *
+ *              without any syscall per clock edge.             *
+ *                                                              *
+ * requires:    tm1640.c/.h                                     *
+ *                                                              *
+ * author:      10/17/2026 Frank4DD                             *
+ * ------------------------------------------------------------ */
+#define _POSIX_C_SOURCE 200809L
+#include <time.h>
+#include "tm1640.h"
+
+#define CAL_MIN_NS  10000000L      // time each calibration run 10ms+
+#define CAL_RUNS    3              // keep the fastest of 3 runs
+
+static unsigned long loops_per_1024ns = 0;   // 0 = not calibrated
+
+/* ------------------------------------------------------------ *
+ * spin() counts down, volatile keeps the compiler from folding *
+ * ------------------------------------------------------------ */
+static void spin(unsigned long loops) {
+   volatile unsigned long i = loops;
+   while(i > 0) i--;
+}
+
+void tm1640_calibrate(void) {
+   struct timespec t1, t2;
+   unsigned long loops = 10000;
+   unsigned long best = 0;
+   long ns;
+   int run;
+
+   for(run = 0; run < CAL_RUNS; run++) {
+      /* ------------------------------------------------------ *
+       * grow the loop count until a run takes CAL_MIN_NS. The  *
+       * fastest run was the least disturbed by other tasks, a  *
+       * slower one would give too short delays.                *
+       * ------------------------------------------------------ */
+      do {
+         clock_gettime(CLOCK_MONOTONIC, &t1);
+         spin(loops);
+         clock_gettime(CLOCK_MONOTONIC, &t2);
+         ns = (t2.tv_sec - t1.tv_sec) * 1000000000L + (t2.tv_nsec - t1.tv_nsec);
+         if(ns < CAL_MIN_NS) loops *= 2;
+      } while(ns < CAL_MIN_NS);
+      if((loops << 10) / ns > best) best = (loops << 10) / ns;
+   }
+   loops_per_1024ns = (best > 0) ? best : 1;
+}
+
+void tm1640_delayNs(unsigned int ns) {
+   if(loops_per_1024ns == 0) tm1640_calibrate();
+   spin(((unsigned long long) ns * loops_per_1024ns) >> 10);
+}
@@ -0,0 +1,168 @@
+/* ------------------------------------------------------------ *
+ * file:        tm1640-tune.c                                   *
+ * purpose:     Searches the fastest TM1640 bit timing that is  *
+ *              still decoded correctly. Test frames are sent   *
+ *              through the tap transport, which records the    *
+ *              real pin timing of the backend. The recording   *
+ *              is decoded and checked against the datasheet    *
+ *              setup/hold/pulse minimums. A binary search over *
+ *              the clock edge delay finds the smallest clean   *
+ *              value, which is printed with a safety margin.   *
+ *                                                              *
+ *              With -t mock, the virtual timing of the mock    *
+ *              transport is searched (runs on any Linux box).  *
+ *                                                              *
+ * return:      0 on success, and -1 on errors.                 *
+ *                                                              *
+ * requires:    tm1640.c/.h and font.h                          *
+ *                                                              *
+ * compile:     see Makefile                                    *
+ *                                                              *
+ * example:     ./tm1640-tune -t gpiomem -m 25                  *
+ *                                                              *
+ * author:      10/17/2026 Frank4DD                             *
+ * ------------------------------------------------------------ */
+#include <unistd.h>
+#include <stdio.h>
+#include "tm1640.h"
+
+int verbose = 0;                          // 1 = print violations
+int repeats = 20;                         // test frames per delay
+
+/* ------------------------------------------------------------ *
+ * run() sends the test frames and a displayOn cmd with the    *
+ * given delay, and checks the decoded bytes. Returns 1 if all  *
+ * transactions were clean.                                     *
+ * ------------------------------------------------------------ */
+static int run(tm1640_display *d1, unsigned int delayNs, tm1640_decode_result *r) {
+   const tm1640_mock_sample *samples;
+   tm1640_transaction *last;
+   tm1640_frame frame;
+   char digits[10];
+   int i, count;
+
+   d1->delayNs = delayNs;
+   for(i = 0; i < repeats; i++) {
+      /* ------------------------------------------------------ *
+       * alternate 0x00/0xFF heavy patterns to get all edges    *
+       * ------------------------------------------------------ */
+      snprintf(digits, sizeof(digits), (i & 1) ? "8.8.8.8.8" : "1234");
+      tm1640_frameClear(&frame);
+      tm1640_frameText(&frame, 0, digits, strlen(digits), INVERT_MODE_NONE);
+      tm1640_frameColon(&frame, i & 1, 1);
+      tm1640_frameDegree(&frame, 1 - (i & 1), 1);
+
+      tm1640_mockReset(d1);
+      d1->ramValid = false;
+      tm1640_frameCommit(d1, &frame);
+      count = tm1640_mockSamples(d1, &samples);
+
+      if(tm1640_decode(samples, count, r, verbose) != 0) return 0;
+      if(r->count == 0) return 0;
+      last = &r->tr[r->count - 1];
+      if(last->length != TM1640_GRIDS + 1 || last->data[0] != 0xC0
+         || memcmp(&last->data[1], frame.grid, TM1640_GRIDS) != 0) {
+         if(verbose == 1) fprintf(stderr, "Decode: %u ns data mismatch\n", delayNs);
+         return 0;
+      }
+   }
+
+   /* --------------------------------------------------------- *
+    * displayOn goes through sendCmd: two single byte commands, *
+    * nothing may follow the last stop condition                *
+    * --------------------------------------------------------- */
+   tm1640_mockReset(d1);
+   tm1640_displayOn(d1, 7);
+   count = tm1640_mockSamples(d1, &samples);
+   if(tm1640_decode(samples, count, r, verbose) != 0) return 0;
+   if(r->count != 2 || r->tr[0].length != 1 || r->tr[0].data[0] != 0x40
+      || r->tr[1].length != 1 || r->tr[1].data[0] != 0x8F || r->tr[1].bits != 0) {
+      if(verbose == 1) fprintf(stderr, "Decode: %u ns displayOn mismatch\n", delayNs);
+      return 0;
+   }
+   return 1;
+}
+
+int main(int argc, char *argv[]) {
+   const tm1640_transport *transport;
+   tm1640_decode_result r;
+   const tm1640_mock_sample *samples;
+   tm1640_display *d1;
+   unsigned long long before, after;
+   unsigned int lo, hi, mid, tuned;
+   int count;
+   int margin = 25;                       // safety margin in percent
+   char *name = "gpiomem";
+   int arg;
+
+   while ((arg = getopt(argc, argv, "t:m:r:vh")) != -1) {
+      switch (arg) {
+         case 't': name = optarg; break;
+         case 'm': margin = atoi(optarg); break;
+         case 'r': repeats = atoi(optarg); break;
+         case 'v': verbose = 1; break;
+         default:
+            printf("Usage: ./tm1640-tune [-t transport] [-m margin%%] [-r repeats] [-v]\n");
+            return -1;
+      }
+   }
+
+   /* --------------------------------------------------------- *
+    * the mock transport has exact virtual timing, any other    *
+    * backend is measured through the tap transport             *
+    * --------------------------------------------------------- */
+   if((transport = tm1640_findTransport(name)) == NULL) {
+      printf("Error: unknown transport %s\n", name);
+      return -1;
+   }
+   if(transport != &tm1640_mock) {
+      tm1640_tapTarget = transport;
+      transport = &tm1640_tap;
+   }
+   if((d1 = tm1640_initTransport(transport, 3, 2)) == NULL) return -1;
+
+   /* --------------------------------------------------------- *
+    * binary search for the smallest clean delay, hi is known   *
+    * to pass, lo is known to fail (or zero).                   *
+    * --------------------------------------------------------- */
+   hi = TM1640_DELAY_NS;
+   if(!run(d1, hi, &r)) {
+      printf("Error: %s fails at the default %u ns delay\n", name, hi);
+      tm1640_destroy(d1);
+      return -1;
+   }
+   lo = 0;
+   if(run(d1, lo, &r)) hi = lo;
+   while(hi - lo > 10) {
+      mid = (lo + hi) / 2;
+      if(run(d1, mid, &r)) hi = mid;
+      else lo = mid;
+      if(verbose == 1) printf("Debug: %4u ns %s\n", mid, (hi == mid) ? "clean" : "fails");
+   }
+   tuned = hi + hi * margin / 100;
+
+   /* --------------------------------------------------------- *
+    * confirm the tuned value, the recording of the last frame  *
+    * gives the full frame latency on the bus, before and after *
+    * --------------------------------------------------------- */
+   run(d1, TM1640_DELAY_NS, &r);
+   count = tm1640_mockSamples(d1, &samples);
+   before = samples[count-1].time - samples[0].time;
+   if(!run(d1, tuned, &r)) {
+      printf("Error: %s fails at the tuned %u ns delay\n", name, tuned);
+      tm1640_destroy(d1);
+      return -1;
+   }
+   count = tm1640_mockSamples(d1, &samples);
+   after = samples[count-1].time - samples[0].time;
+
+   printf("Transport %s: fastest clean delay %u ns, with %d%% margin %u ns\n",
+          name, hi, margin, tuned);
+   printf("Measured minimum: setup %llu ns, hold %llu ns, clock high %llu ns, low %llu ns\n",
+          r.minSetup, r.minHold, r.minClockHigh, r.minClockLow);
+   printf("Full frame time %.1f us, was %.1f us with %d ns delay\n",
+          after / 1.0e3, before / 1.0e3, TM1640_DELAY_NS);
+   printf("export TM1640_DELAY_NS=%u\n", tuned);
+   tm1640_destroy(d1);
+   return 0;
+}
@@ -0,0 +1,89 @@
+/* ------------------------------------------------------------ *
+ * file:        tm1640-wiringpi.c                               *
+ * purpose:     TM1640 transport backend using the WiringPi     *
+ *              library calls digitalWrite/delayMicroseconds.   *
+ *              This is the original driver pin handling, only  *
+ *              built with: make WIRINGPI=1                     *
+ *                                                              *
+ * requires:    tm1640.c/.h, WiringPi                           *
+ *                                                              *
+ * compile:     see Makefile, needs -lWiringPi                  *
+ *                                                              *
+ * author:      10/17/2026 Frank4DD                             *
+ * ------------------------------------------------------------ */
+#include <wiringPi.h>
+#include "tm1640.h"
+
+typedef struct {
+   int clockPin;
+   int dataPin;
+   int dataPins[TM1640_GROUP_MAX]; // group only
+   int count;                      // group only
+} wiringpi_ctx;
+
+static void* wiringpi_open(int clockPin, int dataPin) {
+   wiringpi_ctx *ctx;
+   if(wiringPiSetup() == -1) return NULL;
+   pinMode(clockPin, OUTPUT);
+   pinMode(dataPin, OUTPUT);
+   digitalWrite(clockPin, HIGH);
+   digitalWrite(dataPin, HIGH);
+   ctx = malloc(sizeof(wiringpi_ctx));
+   ctx->clockPin = clockPin;
+   ctx->dataPin = dataPin;
+   ctx->count = 0;
+   return ctx;
+}
+
+/* ------------------------------------------------------------ *
+ * wiringPi has no multi-pin write, a group sets one data pin   *
+ * after the other. Use gpiomem for the parallel timing.        *
+ * ------------------------------------------------------------ */
+static void* wiringpi_openGroup(int clockPin, const int *dataPins, int count) {
+   wiringpi_ctx *ctx;
+   int i;
+   if(count < 1 || count > TM1640_GROUP_MAX) return NULL;
+   if((ctx = wiringpi_open(clockPin, dataPins[0])) == NULL) return NULL;
+   for(i = 0; i < count; i++) {
+      pinMode(dataPins[i], OUTPUT);
+      digitalWrite(dataPins[i], HIGH);
+      ctx->dataPins[i] = dataPins[i];
+   }
+   ctx->count = count;
+   return ctx;
+}
+
+static void wiringpi_setClock(void *ctx, int level) {
+   digitalWrite(((wiringpi_ctx *) ctx)->clockPin, level ? HIGH : LOW);
+}
+
+static void wiringpi_setData(void *ctx, int level) {
+   digitalWrite(((wiringpi_ctx *) ctx)->dataPin, level ? HIGH : LOW);
+}
+
+static void wiringpi_setLines(void *ctx, unsigned int lines) {
+   wiringpi_ctx *w = ctx;
+   int i;
+   for(i = 0; i < w->count; i++) {
+      digitalWrite(w->dataPins[i], ((lines >> i) & 1) ? HIGH : LOW);
+   }
+}
+
+static void wiringpi_delay(void *ctx, unsigned int ns) {
+   delayMicroseconds((ns + 999) / 1000);
+}
+
+static void wiringpi_close(void *ctx) {
+   free(ctx);
+}
+
+const tm1640_transport tm1640_wiringpi = {
+   "wiringpi",
+   wiringpi_open,
+   wiringpi_setClock,
+   wiringpi_setData,
+   wiringpi_delay,
+   wiringpi_close,
+   wiringpi_openGroup,
+   wiringpi_setLines
+};
@@ -34,51 +34,122 @@ char tm1640_invertVertical(char input) {
 
 
 int tm1640_displayWrite(tm1640_display* display, int offset, const char * string, char length, int invertMode) {
-   int c=0;
-   char buffer[33];
-   memset(buffer, 0, sizeof(buffer));
-   memcpy(buffer, string, sizeof(buffer));
+   tm1640_frame frame;
+   int ret;
+
+   memcpy(frame.grid, display->ram, sizeof(frame.grid));
+   ret = tm1640_frameText(&frame, offset, string, length, invertMode);
+   if(ret != 0) return ret;
+   tm1640_flush(display, frame.grid);
+   return 0;
+}
+
+int tm1640_displayWriteRaw(tm1640_display* display, int offset, const char * segments, int length) {
+   tm1640_frame frame;
+   int ret;
+
+   memcpy(frame.grid, display->ram, sizeof(frame.grid));
+   ret = tm1640_frameSegments(&frame, offset, segments, length);
+   if(ret != 0) return ret;
+   tm1640_flush(display, frame.grid);
+   return 0;
+}
+
+void tm1640_frameClear(tm1640_frame* frame) {
+   memset(frame->grid, 0, sizeof(frame->grid));
+}
+
+int tm1640_textSegments(const char * string, int length, char * segments, int max, int invertMode) {
+   int c, n = 0;
+   char seg;
+   if(length < 0 || max < 0) return -EINVAL;
+   if(invertMode != INVERT_MODE_NONE && invertMode != INVERT_MODE_VERTICAL) return -EINVAL;
 
    // Translate input to segments
-   // Return -EINVAL if input string is too long.  Allowance is made for
-   // decimal points.
-   // TODO: provide function to allow raw writing of segments
    for (c=0; c<length; c++) {
-      if (((buffer[c] == '.') && (offset + c) >= 9) ||
-          ((buffer[c] != '.') && (offset + c) >= 8)) {
-         return -EINVAL;
-      }
-      buffer[c] = tm1640_ascii_to_7segment(buffer[c]);
-
-      switch (invertMode) {
-         case INVERT_MODE_NONE:
-            // do nothing
-            break;
-         case INVERT_MODE_VERTICAL:
-            buffer[c] = tm1640_invertVertical(buffer[c]);
-            break;
-         default:
-            return -EINVAL;
-      }
+      seg = tm1640_ascii_to_7segment(string[c]);
+      if(invertMode == INVERT_MODE_VERTICAL) seg = tm1640_invertVertical(seg);
 
       // If possible merge the decimal point with the previous
       // character.  This is only possible if it is not the first
       // character or if the previous character has not already had
       // a decimal point merged.
-      if(c!=0 && (0b10000000 & buffer[c]) && !(0b10000000 & buffer[c-1])) {
-         buffer[c-1] |= 0b10000000;
-         memmove(&buffer[c], (const char *)(&buffer[c+1]), (sizeof(char)*(17-c)));
-         memset(&buffer[16], 0, sizeof(char));;
-         c--;
-         length--;
+      if(n!=0 && (0b10000000 & seg) && !(0b10000000 & segments[n-1])) {
+         segments[n-1] |= 0b10000000;
+         continue;
       }
+      if(n >= max) return -EINVAL;
+      segments[n++] = seg;
    }
-   tm1640_sendCmd(display, 0x44);
-      delayMicroseconds(2);
-   tm1640_send(display, 0xC0 + offset, buffer, c);
+   return n;
+}
+
+int tm1640_frameText(tm1640_frame* frame, int offset, const char * string, char length, int invertMode) {
+   char buffer[8];
+   int n;
+
+   // Return -EINVAL if input string is too long.  Allowance is made for
+   // decimal points.
+   if(offset < 0 || offset > 8 || length < 0 || length > 32) return -EINVAL;
+   n = tm1640_textSegments(string, length, buffer, 8 - offset, invertMode);
+   if(n < 0) return n;
+   memcpy(&frame->grid[offset], buffer, n);
    return 0;
 }
 
+int tm1640_frameSegments(tm1640_frame* frame, int offset, const char * segments, int length) {
+   if(offset < 0 || length < 0 || offset + length > TM1640_GRIDS) return -EINVAL;
+   memcpy(&frame->grid[offset], segments, length);
+   return 0;
+}
+
+int tm1640_frameColon(tm1640_frame* frame, int num, int state) {
+   if(num < 0 || num > 7) return -EINVAL;
+   if(state == 1) frame->grid[8 + num] |= 0b00000011;
+   else frame->grid[8 + num] &= ~0b00000011;
+   return 0;
+}
+
+int tm1640_frameDegree(tm1640_frame* frame, int num, int state) {
+   if(num < 0 || num > 7) return -EINVAL;
+   if(state == 1) frame->grid[8 + num] |= 0b00000001;
+   else frame->grid[8 + num] &= ~0b00000001;
+   return 0;
+}
+
+int tm1640_frameCommit(tm1640_display* display, const tm1640_frame* frame) {
+   int first = TM1640_GRIDS, last = -1;
+   int grid, sent;
+
+   // Find the span of grids that differ from the shadow RAM
+   for(grid = 0; grid < TM1640_GRIDS; grid++) {
+      if(!display->ramValid || frame->grid[grid] != display->ram[grid]) {
+         if(grid < first) first = grid;
+         last = grid;
+      }
+   }
+   if(last < 0) {
+      display->bytesSaved += TM1640_FULL_WRITE;
+      return 0;
+   }
+
+   // Send the whole span in one auto-increment burst. Unchanged grids
+   // inside the span are rewritten with the same data.
+   sent = 1 + last - first + 1;
+   if(display->addrMode != TM1640_MODE_AUTO) {
+      tm1640_send(display, 0x40, NULL, 0);
+      display->addrMode = TM1640_MODE_AUTO;
+      sent++;
+   }
+   tm1640_send(display, 0xC0 + first, (char *) &frame->grid[first], last - first + 1);
+
+   memcpy(display->ram, frame->grid, TM1640_GRIDS);
+   display->ramValid = true;
+   display->bytesSent += sent;
+   if(sent < TM1640_FULL_WRITE) display->bytesSaved += TM1640_FULL_WRITE - sent;
+   return sent;
+}
+
 
 char tm1640_ascii_to_7segment(char ascii) {
    if (ascii < FONT_FIRST_CHAR || ascii > FONT_LAST_CHAR) {
@@ -88,28 +159,98 @@ char tm1640_ascii_to_7segment(char ascii) {
    return DEFAULT_FONT[ascii - FONT_FIRST_CHAR];
 }
 
-void tm1640_setColon(tm1640_display* display, int num, int state) {
-   char colon;
-   if(state == 1) colon = 0b00000011;
-   else colon = 0b00000000;
-   tm1640_sendCmd(display, 0x44);
-      delayMicroseconds(2);
-   tm1640_send(display, 0xC0 + 8 + num, &colon, 1);
+int tm1640_setColon(tm1640_display* display, int num, int state) {
+   char frame[TM1640_GRIDS];
+   if(num < 0 || num > 7) return -EINVAL;
+   memcpy(frame, display->ram, sizeof(frame));
+   if(state == 1) frame[8 + num] |= 0b00000011;
+   else frame[8 + num] &= ~0b00000011;
+   return tm1640_flush(display, frame);
 }
 
-void tm1640_setDegree(tm1640_display* display, int num, int state) {
-   char degree;
-   if(state == 1) degree = 0b00000001;
-   else degree = 0b00000000;
-   tm1640_sendCmd(display, 0x44);
-      delayMicroseconds(2);
-   tm1640_send(display, 0xC0 + 8 + num, &degree, 1);
+int tm1640_setDegree(tm1640_display* display, int num, int state) {
+   char frame[TM1640_GRIDS];
+   if(num < 0 || num > 7) return -EINVAL;
+   memcpy(frame, display->ram, sizeof(frame));
+   if(state == 1) frame[8 + num] |= 0b00000001;
+   else frame[8 + num] &= ~0b00000001;
+   return tm1640_flush(display, frame);
 }
 
 void tm1640_displayClear(tm1640_display* display) {
-   char buffer[16];
-   memset( buffer, 0x00, 16 );
-   tm1640_send(display, 0xC0, buffer, 16);
+   char buffer[TM1640_GRIDS];
+   memset( buffer, 0x00, TM1640_GRIDS );
+   // force a full rewrite, the IC may hold anything
+   display->ramValid = false;
+   tm1640_flush(display, buffer);
+}
+
+int tm1640_flush(tm1640_display* display, const char * frame) {
+   char dirty[TM1640_GRIDS];
+   int start[TM1640_GRIDS], len[TM1640_GRIDS];
+   int grid, runs = 0, changed = 0;
+   int autoCost, fixedCost, sent;
+
+   // Mark grids that differ from the shadow RAM
+   for(grid = 0; grid < TM1640_GRIDS; grid++) {
+      dirty[grid] = (!display->ramValid || frame[grid] != display->ram[grid]);
+      if(dirty[grid]) changed++;
+   }
+   if(changed == 0) {
+      display->bytesSaved += TM1640_FULL_WRITE;
+      return 0;
+   }
+
+   // Collect auto-increment runs. A single unchanged grid between two
+   // runs costs the same as a new address byte, so it is bridged to save
+   // a start/stop sequence.
+   for(grid = 0; grid < TM1640_GRIDS; grid++) {
+      if(!dirty[grid]) continue;
+      if(runs > 0 && grid - (start[runs-1] + len[runs-1]) <= 1) {
+         len[runs-1] = grid - start[runs-1] + 1;
+      } else {
+         start[runs] = grid;
+         len[runs] = 1;
+         runs++;
+      }
+   }
+
+   // Each run needs an address byte, each fixed write an address and a
+   // data byte. The data command is only needed if the mode changes.
+   autoCost = (display->addrMode != TM1640_MODE_AUTO);
+   for(grid = 0; grid < runs; grid++) autoCost += 1 + len[grid];
+   fixedCost = (display->addrMode != TM1640_MODE_FIXED) + 2 * changed;
+
+   if(fixedCost < autoCost) {
+      if(display->addrMode != TM1640_MODE_FIXED) {
+         tm1640_send(display, 0x44, NULL, 0);
+         display->addrMode = TM1640_MODE_FIXED;
+      }
+      for(grid = 0; grid < TM1640_GRIDS; grid++) {
+         if(dirty[grid]) tm1640_send(display, 0xC0 + grid, (char *) &frame[grid], 1);
+      }
+      sent = fixedCost;
+   } else {
+      if(display->addrMode != TM1640_MODE_AUTO) {
+         tm1640_send(display, 0x40, NULL, 0);
+         display->addrMode = TM1640_MODE_AUTO;
+      }
+      for(grid = 0; grid < runs; grid++) {
+         tm1640_send(display, 0xC0 + start[grid], (char *) &frame[start[grid]], len[grid]);
+      }
+      sent = autoCost;
+   }
+
+   memcpy(display->ram, frame, TM1640_GRIDS);
+   display->ramValid = true;
+   display->bytesSent += sent;
+   if(sent < TM1640_FULL_WRITE) display->bytesSaved += TM1640_FULL_WRITE - sent;
+   return sent;
+}
+
+void tm1640_printStats(tm1640_display* display, FILE * out) {
+   fprintf(out, "TM1640 bytes sent: %lu, bytes saved: %lu\n",
+           display->bytesSent, display->bytesSaved);
 }
 
 void tm1640_displayOn(tm1640_display* display, char brightness) {
@@ -123,46 +264,104 @@ void tm1640_displayOff(tm1640_display* display) {
    tm1640_sendCmd(display, 0x80);
 }
 
+/**
+ * Transport backends compiled into the driver, the first one is the
+ * default. TM1640_TRANSPORT=<name> in the environment selects another.
+ */
+static const tm1640_transport* tm1640_transports[] = {
+   &tm1640_gpiomem,
+#ifdef TM1640_WIRINGPI
+   &tm1640_wiringpi,
+#endif
+   &tm1640_mock,
+   &tm1640_tap,
+   NULL
+};
+
+const tm1640_transport* tm1640_getTransport(int index) {
+   int i;
+   for(i = 0; i < index; i++) {
+      if(tm1640_transports[i] == NULL) return NULL;
+   }
+   return tm1640_transports[index];
+}
+
+const tm1640_transport* tm1640_findTransport(const char * name) {
+   int i;
+   if(name == NULL) name = getenv("TM1640_TRANSPORT");
+   if(name == NULL) return tm1640_transports[0];
+   for(i = 0; tm1640_transports[i] != NULL; i++) {
+      if(strcmp(tm1640_transports[i]->name, name) == 0) return tm1640_transports[i];
+   }
+   return NULL;
+}
+
 tm1640_display* tm1640_init(int clockPin, int dataPin) {
-   if(wiringPiSetup() == -1) {
-     printf("Error WiringPi\n");
+   const tm1640_transport* transport = tm1640_findTransport(NULL);
+   if(transport == NULL) {
+     printf("Error unknown TM1640_TRANSPORT %s\n", getenv("TM1640_TRANSPORT"));
+     return NULL;
+   }
+   return tm1640_initTransport(transport, clockPin, dataPin);
+}
+
+tm1640_display* tm1640_initTransport(const tm1640_transport* transport, int clockPin, int dataPin) {
+   void *ctx = transport->open(clockPin, dataPin);
+   if(ctx == NULL) {
+     printf("Error %s transport\n", transport->name);
      return NULL;
    }
-   pinMode(clockPin, OUTPUT);
-   pinMode(dataPin, OUTPUT);
-   digitalWrite(clockPin, HIGH);
-   digitalWrite(dataPin, HIGH);
    tm1640_display* display = malloc(sizeof(tm1640_display));
    // clear for good measure
    memset(display, 0, sizeof(tm1640_display));
    display->clockPin = clockPin;
    display->dataPin = dataPin;
+   display->transport = transport;
+   display->ctx = ctx;
+   display->delayNs = TM1640_DELAY_NS;
+   if(getenv("TM1640_DELAY_NS") != NULL) display->delayNs = atoi(getenv("TM1640_DELAY_NS"));
    return display;
 }
 
 void tm1640_destroy(tm1640_display* display) {
+   display->transport->close(display->ctx);
    free(display);
 }
 
+// pin and delay shortcuts through the transport backend
+static void tm1640_clock(tm1640_display* display, int level) {
+   display->transport->setClock(display->ctx, level);
+}
+
+static void tm1640_data(tm1640_display* display, int level) {
+   display->transport->setData(display->ctx, level);
+}
+
+static void tm1640_wait(tm1640_display* display) {
+   display->transport->delay(display->ctx, display->delayNs);
+}
+
 // send one byte to IC. CLK=L after start 
+// DIN changes right after the falling edge, and is stable for one delay
+// before the rising edge (setup) and during clock high (hold).
 void tm1640_sendRaw(tm1640_display* display, char out) {
    int i;
    for(i = 0; i < 8; i++) {
-      digitalWrite(display->dataPin, out & (1 << i));
-      digitalWrite(display->clockPin, HIGH);
-      delayMicroseconds(1);
-      digitalWrite(display->clockPin, LOW);
-      delayMicroseconds(1);
+      tm1640_data(display, (out >> i) & 1);
+      tm1640_wait(display);
+      tm1640_clock(display, 1);
+      tm1640_wait(display);
+      tm1640_clock(display, 0);
    }
 }
 
 void tm1640_send(tm1640_display* display, char cmd, char * data, int len) {
    //Issue start command
    //CLK=H, Data changes from H->L
-   digitalWrite(display->dataPin, LOW);
-   delayMicroseconds(1);
-   digitalWrite(display->clockPin, LOW);
-   delayMicroseconds(1);
+   tm1640_data(display, 0);
+   tm1640_wait(display);
+   tm1640_clock(display, 0);
+   tm1640_wait(display);
 
    tm1640_sendRaw(display, cmd);
    if(data != NULL) {
@@ -174,18 +373,16 @@ void tm1640_send(tm1640_display* display, char cmd, char * data, int len) {
 
    //Issue stop command
    //When CLK=H, Data changes from L->H
-   digitalWrite(display->clockPin, HIGH);
-   delayMicroseconds(1);
-   digitalWrite(display->dataPin, HIGH);
-   delayMicroseconds(1);
+   tm1640_data(display, 0);
+   tm1640_wait(display);
+   tm1640_clock(display, 1);
+   tm1640_wait(display);
+   tm1640_data(display, 1);
+   tm1640_wait(display);
 }
 
 void tm1640_sendCmd(tm1640_display* display, char cmd ) {
    tm1640_send(display, 0x40, 0 ,0);
+   display->addrMode = TM1640_MODE_AUTO;
    tm1640_send(display, cmd, 0, 0);
-   digitalWrite(display->dataPin, LOW);
-   digitalWrite( display->clockPin, LOW);
-   delayMicroseconds(1);
-   digitalWrite( display->clockPin, HIGH);
-   digitalWrite( display->dataPin, HIGH);
 }
@@ -25,7 +25,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
-#include <wiringPi.h>
+#include <stdatomic.h>
+#include <pthread.h>
 
 /**
  * Default data GPIO pin to use.
@@ -55,6 +56,197 @@
  */
 #define INVERT_MODE_VERTICAL 1
 
+/**
+ * Number of grids (digit positions) in the TM1640 display RAM.
+ */
+#define TM1640_GRIDS 16
+
+/**
+ * Used by tm1640_flush
+ *
+ * Address modes set by the TM1640 data command. The IC keeps the last mode
+ * until it receives a new data command, so it is only resent on a change.
+ */
+#define TM1640_MODE_UNKNOWN 0
+#define TM1640_MODE_AUTO    1
+#define TM1640_MODE_FIXED   2
+
+/**
+ * Used by tm1640_flush
+ *
+ * Bytes needed to rewrite the full display RAM in auto-increment mode:
+ * data command, address command and 16 grid bytes. This is the reference
+ * for the bytesSaved counter.
+ */
+#define TM1640_FULL_WRITE (2 + TM1640_GRIDS)
+
+/**
+ * Default delay in nanoseconds between clock edges. The IC allows up to
+ * 1MHz clock, bitbanging the output pins faster creates unpredictable
+ * results. TM1640_DELAY_NS=<ns> in the environment overrides it, see
+ * tm1640-tune for finding the fastest safe value.
+ */
+#define TM1640_DELAY_NS 1000
+
+/**
+ * Used by tm1640_decode
+ *
+ * Minimum timings from the TM1640 datasheet, in nanoseconds: clock pulse
+ * width (high and low), data setup before and data hold after the
+ * rising clock edge. Start and stop conditions use setup and hold too.
+ */
+#define TM1640_MIN_PULSE_NS 400
+#define TM1640_MIN_SETUP_NS 100
+#define TM1640_MIN_HOLD_NS  100
+
+/**
+ * Used by tm1640_decode
+ *
+ * Maximum number of transactions decoded from one recording.
+ */
+#define TM1640_DECODE_MAX 64
+
+/**
+ * Transport backend that drives the clock and data pins.
+ *
+ * Pins are given as WiringPi pin identifiers for all backends, levels
+ * are 0 (low) and 1 (high). Available backends are tm1640_gpiomem
+ * (direct register access through /dev/gpiomem), tm1640_wiringpi (if
+ * built with WIRINGPI=1) and tm1640_mock (records pin transitions).
+ */
+typedef struct {
+	/**
+	 * Backend name, as used by tm1640_findTransport.
+	 */
+	const char *name;
+
+	/**
+	 * Sets up both pins as outputs driven high.
+	 *
+	 * @return backend context, or NULL on failure.
+	 */
+	void* (*open)(int clockPin, int dataPin);
+
+	/**
+	 * Drives the clock (SCLK) pin to the given level.
+	 */
+	void (*setClock)(void *ctx, int level);
+
+	/**
+	 * Drives the data (DIN) pin to the given level.
+	 */
+	void (*setData)(void *ctx, int level);
+
+	/**
+	 * Waits at least ns nanoseconds.
+	 */
+	void (*delay)(void *ctx, unsigned int ns);
+
+	/**
+	 * Releases the backend context.
+	 */
+	void (*close)(void *ctx);
+
+	/**
+	 * Used by tm1640_group, NULL if the backend has no group support.
+	 *
+	 * Sets up one shared clock pin and count data pins as outputs driven
+	 * high. The context works with setClock, setLines, delay and close.
+	 *
+	 * @return backend context, or NULL on failure.
+	 */
+	void* (*openGroup)(int clockPin, const int *dataPins, int count);
+
+	/**
+	 * Used by tm1640_group: drives data pin i to bit i of lines, for all
+	 * data pins of the group at once.
+	 */
+	void (*setLines)(void *ctx, unsigned int lines);
+} tm1640_transport;
+
+extern const tm1640_transport tm1640_gpiomem;
+extern const tm1640_transport tm1640_wiringpi;
+extern const tm1640_transport tm1640_mock;
+extern const tm1640_transport tm1640_tap;
+
+/**
+ * Backend driven by the tm1640_tap transport. The tap passes all pin
+ * changes and delays on to this backend, and records the transitions
+ * with real CLOCK_MONOTONIC timestamps. Defaults to tm1640_gpiomem.
+ */
+extern const tm1640_transport* tm1640_tapTarget;
+
+/**
+ * One pin transition recorded by the tm1640_mock transport.
+ */
+typedef struct {
+	/**
+	 * Virtual time in nanoseconds, advanced by the transport delays.
+	 */
+	unsigned long long time;
+
+	/**
+	 * Clock (SCLK) level after the transition.
+	 */
+	char clock;
+
+	/**
+	 * Data (DIN) level after the transition.
+	 */
+	char data;
+} tm1640_mock_sample;
+
+/**
+ * One bus transaction (start to stop condition) rebuilt by tm1640_decode.
+ */
+typedef struct {
+	/**
+	 * Command byte followed by the data bytes.
+	 */
+	unsigned char data[TM1640_GRIDS + 1];
+
+	/**
+	 * Number of complete bytes received.
+	 */
+	int length;
+
+	/**
+	 * Bits of an incomplete last byte, 0 if the transaction ended on a
+	 * byte boundary.
+	 */
+	int bits;
+} tm1640_transaction;
+
+/**
+ * Result of tm1640_decode, with the measured minimum timings.
+ */
+typedef struct {
+	tm1640_transaction tr[TM1640_DECODE_MAX];
+	int count;
+
+	/**
+	 * Number of protocol errors and timing constraint violations.
+	 */
+	int violations;
+
+	/**
+	 * Shortest timings seen in the recording, in nanoseconds.
+	 */
+	unsigned long long minSetup;
+	unsigned long long minHold;
+	unsigned long long minClockHigh;
+	unsigned long long minClockLow;
+} tm1640_decode_result;
+
+/**
+ * A complete frame of TM1640 display RAM, one byte of segments per grid.
+ *
+ * Compose it with the tm1640_frame* functions, then send it with
+ * tm1640_frameCommit in a single bus transaction.
+ */
+typedef struct {
+	char grid[TM1640_GRIDS];
+} tm1640_frame;
 
 /**
  * Structure that defines a connection to a TM1640 IC.
@@ -72,19 +264,296 @@ typedef struct {
 	 * WiringPi GPIO pin for display data (DIN).
 	 */
 	int dataPin;
+
+	/**
+	 * Transport backend driving the pins.
+	 */
+	const tm1640_transport *transport;
+
+	/**
+	 * Backend context returned by transport->open.
+	 */
+	void *ctx;
+
+	/**
+	 * Delay between clock edges in nanoseconds, TM1640_DELAY_NS unless
+	 * overridden in the environment.
+	 */
+	unsigned int delayNs;
+
+	/**
+	 * Shadow copy of the display RAM, as last sent to the IC.
+	 */
+	char ram[TM1640_GRIDS];
+
+	/**
+	 * Set once the shadow RAM is known to match the IC. Until then
+	 * tm1640_flush rewrites all grids.
+	 */
+	bool ramValid;
+
+	/**
+	 * Address mode of the last data command sent (TM1640_MODE_*).
+	 */
+	int addrMode;
+
+	/**
+	 * Number of bytes shifted out by tm1640_flush.
+	 */
+	unsigned long bytesSent;
+
+	/**
+	 * Number of bytes tm1640_flush saved against TM1640_FULL_WRITE.
+	 */
+	unsigned long bytesSaved;
 } tm1640_display;
 
+/**
+ * Used by tm1640_anim
+ *
+ * Capacity of a compiled animation: segment cells of all texts and
+ * pages, and playback steps.
+ */
+#define TM1640_ANIM_CELLS 256
+#define TM1640_ANIM_STEPS 256
+
+/**
+ * One playback step of a tm1640_anim: width cells starting at start,
+ * shown for hold milliseconds.
+ */
+typedef struct {
+	short start;
+	unsigned short hold;
+} tm1640_anim_step;
+
+/**
+ * Precompiled animation for the 7-segment digits, e.g. a marquee of a
+ * text longer than the display.
+ *
+ * tm1640_animText translates the text once, with decimal point merging
+ * and inversion, into a strip of segment cells. Each step is a window
+ * into the strip, so playback copies segments and does no translation
+ * or allocation.
+ */
+typedef struct {
+	/**
+	 * Number of digits shown, and first grid they are written to.
+	 */
+	int width;
+	int offset;
+
+	/**
+	 * Compiled segment strip.
+	 */
+	char cells[TM1640_ANIM_CELLS];
+	int ncells;
+
+	/**
+	 * Playback steps, in order.
+	 */
+	tm1640_anim_step step[TM1640_ANIM_STEPS];
+	int count;
+} tm1640_anim;
+
+/**
+ * Maximum number of TM1640 chips in a tm1640_group.
+ */
+#define TM1640_GROUP_MAX 8
+
+/**
+ * Group of TM1640 chips sharing one clock pin, each with its own data pin.
+ *
+ * All chips are clocked together. Each bit period drives the data pins of
+ * all chips with one register write, so refreshing N displays takes the
+ * bus time of one. Create instances with tm1640_initGroup.
+ */
+typedef struct {
+	/**
+	 * WiringPi GPIO pin for the shared clock (SCLK).
+	 */
+	int clockPin;
+
+	/**
+	 * WiringPi GPIO pins for data (DIN), one per chip.
+	 */
+	int dataPins[TM1640_GROUP_MAX];
+
+	/**
+	 * Number of chips in the group.
+	 */
+	int count;
+
+	/**
+	 * Transport backend driving the pins, with group support.
+	 */
+	const tm1640_transport *transport;
+
+	/**
+	 * Backend context returned by transport->openGroup.
+	 */
+	void *ctx;
+
+	/**
+	 * Delay between clock edges in nanoseconds.
+	 */
+	unsigned int delayNs;
+
+	/**
+	 * Shadow copies of the display RAM, one per chip.
+	 */
+	char ram[TM1640_GROUP_MAX][TM1640_GRIDS];
+
+	/**
+	 * Set once the shadow RAM is known to match the chips.
+	 */
+	bool ramValid;
+
+	/**
+	 * Address mode of the last data command sent (TM1640_MODE_*).
+	 */
+	int addrMode;
+
+	/**
+	 * Number of bytes shifted out, counted once for all chips since
+	 * they are sent in parallel.
+	 */
+	unsigned long bytesSent;
+
+	/**
+	 * Number of bytes saved against sending TM1640_FULL_WRITE to each
+	 * chip in turn.
+	 */
+	unsigned long bytesSaved;
+} tm1640_group;
+
+/**
+ * Used by tm1640_refresh
+ *
+ * Flag in tm1640_refresh.middle, set when the producer has published a
+ * frame the refresh thread has not picked up yet.
+ */
+#define TM1640_REFRESH_NEW 4
+
+/**
+ * Background refresh service for a TM1640 display.
+ *
+ * Producers publish complete frames with tm1640_refreshPublish, and never
+ * wait for the bus. A thread started by tm1640_refreshStart wakes at the
+ * refresh rate and commits the latest frame, if a new one was published.
+ *
+ * The frames are exchanged lock-free: the producer owns the back buffer,
+ * the thread owns the front buffer, and a third (middle) buffer is
+ * swapped in with an atomic exchange on either side.
+ */
+typedef struct {
+	/**
+	 * Display owned by the refresh thread. Do not write to it directly
+	 * while the thread runs.
+	 */
+	tm1640_display *display;
+
+	/**
+	 * Frame buffers, indexed by back, front and middle.
+	 */
+	tm1640_frame buffer[3];
+
+	/**
+	 * Index of the producer (back) and the thread (front) buffer.
+	 */
+	int back;
+	int front;
+
+	/**
+	 * Index of the exchange buffer, or'ed with TM1640_REFRESH_NEW.
+	 */
+	atomic_int middle;
+
+	/**
+	 * Display control command (on/brightness, off) to send at the next
+	 * wakeup, -1 if none. Only the latest command is kept.
+	 */
+	atomic_int control;
+
+	/**
+	 * Cleared by tm1640_refreshStop to end the thread.
+	 */
+	atomic_int running;
+
+	/**
+	 * Wakeup period of the refresh thread in nanoseconds.
+	 */
+	long periodNs;
+
+	/**
+	 * Number of frames published, and committed to the display.
+	 */
+	atomic_ulong published;
+	atomic_ulong committed;
+
+	pthread_t thread;
+} tm1640_refresh;
+
 /**
  * Initialises the display.
  *
+ * Uses the transport backend named in the TM1640_TRANSPORT environment
+ * variable, or the default backend (gpiomem).
+ *
  * @param clockPin WiringPi pin identifier to use for clock (SCLK)
  * @param dataPin WiringPi pin identifier to use for data (DIN)
  *
- * @return NULL if wiringPiSetup() fails (permission error)
+ * @return NULL if the transport fails to open (permission error)
  * @return pointer to tm1640_display on successful initialisation.
  */
 tm1640_display* tm1640_init(int clockPin, int dataPin);
 
+/**
+ * Initialises the display on the given transport backend.
+ *
+ * @param transport backend to drive the pins with
+ * @param clockPin WiringPi pin identifier to use for clock (SCLK)
+ * @param dataPin WiringPi pin identifier to use for data (DIN)
+ *
+ * @return NULL if the transport fails to open
+ * @return pointer to tm1640_display on successful initialisation.
+ */
+tm1640_display* tm1640_initTransport(const tm1640_transport* transport, int clockPin, int dataPin);
+
+/**
+ * Looks up a transport backend by name.
+ *
+ * @param name backend name, or NULL for TM1640_TRANSPORT / the default
+ *
+ * @return NULL if no backend with this name was built in.
+ */
+const tm1640_transport* tm1640_findTransport(const char * name);
+
+/**
+ * Lists the transport backends built into the driver.
+ *
+ * @param index 0 for the first (default) backend
+ *
+ * @return NULL if index is past the last backend.
+ */
+const tm1640_transport* tm1640_getTransport(int index);
+
+/**
+ * Returns the pin transitions recorded by the tm1640_mock transport.
+ *
+ * @param display TM1640 display opened on the mock transport
+ * @param samples set to the recorded transitions
+ *
+ * @return number of recorded transitions, -EINVAL for other transports.
+ */
+int tm1640_mockSamples(tm1640_display* display, const tm1640_mock_sample ** samples);
+
+/**
+ * Drops the transitions recorded by the tm1640_mock transport.
+ *
+ * @param display TM1640 display opened on the mock transport
+ */
+void tm1640_mockReset(tm1640_display* display);
+
 /**
  * Destroys (frees) the structure associated with the connection to the TM1640.
  *
@@ -116,14 +585,123 @@ char tm1640_invertVertical(char input);
  */
 int tm1640_displayWrite(tm1640_display* display, int offset, const char * string, char length, int invertMode);
 
+/**
+ * displayWriteRaw
+ *
+ * Writes segment bitmasks to the display without ASCII translation.
+ *
+ * @param display TM1640 display to write to
+ * @param offset grid on the display to start writing from
+ * @param segments segment bitmasks to write, one per grid
+ * @param length number of grids to write
+ *
+ * @return -EINVAL if offset + length > 16
+ * @return 0 on success.
+ */
+int tm1640_displayWriteRaw(tm1640_display* display, int offset, const char * segments, int length);
+
+/**
+ * frameClear
+ *
+ * @param frame frame to zero out, all segments off
+ */
+void tm1640_frameClear(tm1640_frame* frame);
+
+/**
+ * frameText
+ *
+ * Translates a string into the frame, merging decimal points with the
+ * previous digit as tm1640_displayWrite does.
+ *
+ * @param frame frame to write to
+ * @param offset grid to start writing from
+ * @param string string to translate
+ * @param length length of the string
+ * @param invertMode invert mode to apply to the text
+ *
+ * @return -EINVAL if invertMode is invalid or the text does not fit
+ * @return 0 on success.
+ */
+int tm1640_frameText(tm1640_frame* frame, int offset, const char * string, char length, int invertMode);
+
+/**
+ * Translates a string into segment bitmasks, merging decimal points with
+ * the previous digit. Used by tm1640_frameText and tm1640_animText.
+ *
+ * @param string string to translate
+ * @param length length of the string
+ * @param segments receives one bitmask per digit
+ * @param max size of segments
+ * @param invertMode invert mode to apply to the text
+ *
+ * @return -EINVAL if invertMode is invalid or the text needs more than max digits
+ * @return number of digits on success.
+ */
+int tm1640_textSegments(const char * string, int length, char * segments, int max, int invertMode);
+
+/**
+ * frameSegments
+ *
+ * Copies raw segment bitmasks into the frame.
+ *
+ * @param frame frame to write to
+ * @param offset grid to start writing from
+ * @param segments segment bitmasks, one per grid
+ * @param length number of grids to write
+ *
+ * @return -EINVAL if offset + length > 16
+ * @return 0 on success.
+ */
+int tm1640_frameSegments(tm1640_frame* frame, int offset, const char * segments, int length);
+
+/**
+ * frameColon
+ *
+ * @param frame frame to modify
+ * @param num 0 = fist display colon, 1 = 2nd display colon
+ * @param state 1 = On, 0 = off
+ *
+ * @return -EINVAL if num is not 0..7
+ * @return 0 on success.
+ */
+int tm1640_frameColon(tm1640_frame* frame, int num, int state);
+
+/**
+ * frameDegree
+ *
+ * @param frame frame to modify
+ * @param num 0 = fist display degree, 1 = 2nd display degree
+ * @param state 1 = On, 0 = off
+ *
+ * @return -EINVAL if num is not 0..7
+ * @return 0 on success.
+ */
+int tm1640_frameDegree(tm1640_frame* frame, int num, int state);
+
+/**
+ * frameCommit
+ *
+ * Sends the frame to the display in one auto-increment burst, covering
+ * the span of grids that differ from the shadow RAM.
+ *
+ * @param display TM1640 display to write to
+ * @param frame frame to send
+ *
+ * @return number of bytes sent to the IC, 0 if nothing changed.
+ */
+int tm1640_frameCommit(tm1640_display* display, const tm1640_frame* frame);
+
 /**
  * setColon
  *
  * @param display TM1640 display to write to
  * @param num 0 = fist display colon, 1 = 2nd display colon
  * @param state 1 = On, 0 = off
+ *
+ * @return -EINVAL if num is not 0..7
+ * @return number of bytes sent to the IC, 0 if nothing changed.
  */
-void tm1640_setColon(tm1640_display* display, int num, int state);
+int tm1640_setColon(tm1640_display* display, int num, int state);
 
 /**
  * setDegree
@@ -131,8 +709,218 @@ void tm1640_setColon(tm1640_display* display, int num, int state);
  * @param display TM1640 display to write to
  * @param num 0 = fist display degree, 1 = 2nd display degree
  * @param state 1 = On, 0 = off
+ *
+ * @return -EINVAL if num is not 0..7
+ * @return number of bytes sent to the IC, 0 if nothing changed.
+ */
+int tm1640_setDegree(tm1640_display* display, int num, int state);
+
+/**
+ * Writes a complete frame of display RAM, sending only the grids that
+ * differ from the shadow RAM. Changed grids are sent either as
+ * auto-increment runs or as fixed-address writes, whichever needs fewer
+ * bytes. The shadow RAM is updated afterwards.
+ *
+ * @param display TM1640 display to write to
+ * @param frame TM1640_GRIDS bytes of segment data, one per grid
+ *
+ * @return number of bytes sent to the IC, 0 if nothing changed.
+ */
+int tm1640_flush(tm1640_display* display, const char * frame);
+
+/**
+ * Prints the bytesSent and bytesSaved counters of the display.
+ *
+ * @param display TM1640 display to report on
+ * @param out stream to print to, e.g. stdout
+ */
+void tm1640_printStats(tm1640_display* display, FILE * out);
+
+/**
+ * Starts an empty animation.
+ *
+ * @param width number of digits to animate, 1..8
+ * @param offset first grid, offset + width <= 8
+ *
+ * @return -EINVAL if the digits are out of range, 0 on success.
+ */
+int tm1640_animInit(tm1640_anim* anim, int width, int offset);
+
+/**
+ * Appends a text to the animation. Text that fits is one step shown for
+ * pause ms. Longer text scrolls left one digit each hold ms, and stays
+ * pause ms on the first and last position.
+ *
+ * @return -ENOSPC if the animation is full, -EINVAL on invalid text
+ * @return 0 on success.
+ */
+int tm1640_animText(tm1640_anim* anim, const char * string, int invertMode, int hold, int pause);
+
+/**
+ * Appends one page of raw segments, width bytes, shown for hold ms.
+ *
+ * @return -ENOSPC if the animation is full, 0 on success.
+ */
+int tm1640_animSegments(tm1640_anim* anim, const char * segments, int hold);
+
+/**
+ * Writes step index of the animation into the frame.
+ *
+ * @return hold time of the step in ms, -EINVAL if index is out of range.
+ */
+int tm1640_animStep(const tm1640_anim* anim, int index, tm1640_frame* frame);
+
+/**
+ * Plays the animation on the display, loops times (0 = forever), on
+ * absolute step times that do not drift. Grids outside the animated
+ * digits keep their shadow RAM content.
+ *
+ * @return 0 when done, -1 if the sleep was interrupted.
+ */
+int tm1640_animPlay(tm1640_display* display, const tm1640_anim* anim, int loops);
+
+/**
+ * Initialises a group of displays on a shared clock pin.
+ *
+ * Uses the transport backend named in the TM1640_TRANSPORT environment
+ * variable, or the default backend (gpiomem).
+ *
+ * @param clockPin WiringPi pin identifier of the shared clock (SCLK)
+ * @param dataPins WiringPi pin identifiers for data (DIN), one per chip
+ * @param count number of chips, 1..TM1640_GROUP_MAX
+ *
+ * @return NULL if the transport has no group support or fails to open
+ * @return pointer to tm1640_group on successful initialisation.
+ */
+tm1640_group* tm1640_initGroup(int clockPin, const int * dataPins, int count);
+
+/**
+ * Initialises a group of displays with the given transport backend.
+ *
+ * @see tm1640_initGroup
+ */
+tm1640_group* tm1640_initGroupTransport(const tm1640_transport* transport, int clockPin, const int * dataPins, int count);
+
+/**
+ * Releases the group and its transport context.
+ */
+void tm1640_groupDestroy(tm1640_group* group);
+
+/**
+ * Sends one frame to each chip of the group, in a single parallel bus
+ * transaction. The span sent covers the changed grids of all chips.
+ *
+ * @param frames array of group->count frames, frames[i] for chip i
+ *
+ * @return number of bytes sent per data line, 0 if nothing changed.
+ */
+int tm1640_groupCommit(tm1640_group* group, const tm1640_frame * frames);
+
+/**
+ * Turns all displays of the group on, with brightness 1..7.
+ */
+void tm1640_groupOn(tm1640_group* group, char brightness);
+
+/**
+ * Turns all displays of the group off, preserving data.
+ */
+void tm1640_groupOff(tm1640_group* group);
+
+/**
+ * Prints the group bytesSent and bytesSaved counters.
+ */
+void tm1640_groupStats(tm1640_group* group, FILE * out);
+
+/**
+ * Gets the transitions recorded by a group on the mock transport.
+ *
+ * @return number of recorded transitions, -EINVAL for other transports.
+ */
+int tm1640_groupSamples(tm1640_group* group, const tm1640_mock_sample ** samples);
+
+/**
+ * Clears the group recording of the mock transport.
+ */
+void tm1640_groupReset(tm1640_group* group);
+
+/**
+ * Extracts the signal of one data line from a group recording of the
+ * mock transport, for use with tm1640_decode.
+ *
+ * @param samples group recording, data holds one bit per line
+ * @param out receives the samples of line, at most count
+ *
+ * @return number of samples in out.
+ */
+int tm1640_groupLine(const tm1640_mock_sample * samples, int count, int line, tm1640_mock_sample * out);
+
+/**
+ * Starts the background refresh thread for the display.
+ *
+ * @param display TM1640 display, owned by the thread until it is stopped
+ * @param hz refresh rate, e.g. 50..100
+ *
+ * @return NULL if the thread could not be started.
+ */
+tm1640_refresh* tm1640_refreshStart(tm1640_display* display, int hz);
+
+/**
+ * Publishes a new frame to the refresh thread. This only copies the frame
+ * and never waits for the bus. Frames published faster than the refresh
+ * rate are coalesced, only the latest one is sent.
+ *
+ * @param refresh refresh service to publish to
+ * @param frame frame to display
+ */
+void tm1640_refreshPublish(tm1640_refresh* refresh, const tm1640_frame* frame);
+
+/**
+ * Queues a display control command for the refresh thread, which owns
+ * the bus. Like frames, only the latest command is sent.
+ *
+ * @param refresh refresh service to send the command through
+ * @param cmd 0x80 for display off, 0x88 + brightness (1..7) for on
+ */
+void tm1640_refreshControl(tm1640_refresh* refresh, char cmd);
+
+/**
+ * Stops the refresh thread after a last commit, and frees the service.
+ * The display is left open.
+ *
+ * @param refresh refresh service to stop
+ */
+void tm1640_refreshStop(tm1640_refresh* refresh);
+
+/**
+ * Decodes recorded pin transitions (tm1640_mock or tm1640_tap transport)
+ * back into bus transactions, and checks them against the datasheet
+ * timings TM1640_MIN_PULSE_NS, TM1640_MIN_SETUP_NS and TM1640_MIN_HOLD_NS.
+ * A violation is logged to stderr if verbose is set.
+ *
+ * @param samples recorded transitions, see tm1640_mockSamples
+ * @param count number of recorded transitions
+ * @param result decoded transactions and timing statistics
+ * @param verbose 1 = print each violation
+ *
+ * @return number of violations, 0 if the recording is clean.
+ */
+int tm1640_decode(const tm1640_mock_sample * samples, int count, tm1640_decode_result * result, int verbose);
+
+/**
+ * Calibrates the busy-wait loop of tm1640_delayNs against
+ * CLOCK_MONOTONIC. Called once by the gpiomem transport, calling it
+ * again recalibrates e.g. after a CPU frequency change.
+ */
+void tm1640_calibrate(void);
+
+/**
+ * Busy-waits for ns nanoseconds using the calibrated loop count. Short
+ * delays are not possible with nanosleep, and clock_gettime polling is
+ * too coarse below a microsecond on the Pi Zero.
+ *
+ * @param ns nanoseconds to wait
  */
-void tm1640_setDegree(tm1640_display* display, int num, int state);
+void tm1640_delayNs(unsigned int ns);
 
 /**
  * @private
@@ -168,7 +956,8 @@ void tm1640_displayOff(tm1640_display* display);
 
 /**
  * @private
- * Sends a cmd followed by len amount of data. Includes delay from wiringPi.
+ * Sends a cmd followed by len amount of data, with TM1640_DELAY_NS
+ * between clock edges.
  *
  * Bitbanging the output pins too fast creates unpredictable results.
  *
@@ -183,7 +972,7 @@ void tm1640_send(tm1640_display* display, char cmd, char * data, int len);
  * @private
  * Shifts out the byte on the port.
  *
- * Implementing this with WiringPi directly is too fast for the IC.
+ * Driving the pins without delay is too fast for the IC.
  *
  * @param display TM1640 display structure to use this for this operation.
  * @param out Byte to send
@@ -0,0 +1,78 @@
+/* ------------------------------------------------------------ *
+ * file:        tm1640d-client.c                                *
+ * purpose:     Client functions for the tm1640d display daemon *
+ *              Each call is one non-blocking datagram send.    *
+ *                                                              *
+ * requires:    tm1640d.h                                       *
+ *                                                              *
+ * author:      10/17/2026 Frank4DD                             *
+ * ------------------------------------------------------------ */
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "tm1640d.h"
+
+int tm1640d_connect(void) {
+   struct sockaddr_un addr;
+   const char *path = getenv("TM1640D_SOCKET");
+   int fd;
+
+   if(path == NULL) path = TM1640D_SOCKET;
+   if((fd = socket(AF_UNIX, SOCK_DGRAM, 0)) == -1) return -1;
+   memset(&addr, 0, sizeof(addr));
+   addr.sun_family = AF_UNIX;
+   strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+   if(connect(fd, (struct sockaddr *) &addr, sizeof(addr)) == -1) {
+      close(fd);
+      return -1;
+   }
+   return fd;
+}
+
+/* ------------------------------------------------------------ *
+ * tm1640d_send() sends one command without waiting. A full     *
+ * socket queue means the daemon lags, the command is dropped.  *
+ * ------------------------------------------------------------ */
+static int tm1640d_send(int fd, const tm1640d_msg *msg) {
+   if(send(fd, msg, sizeof(tm1640d_msg), MSG_DONTWAIT) != sizeof(tm1640d_msg)) return -1;
+   return 0;
+}
+
+int tm1640d_frame(int fd, const tm1640_frame* frame) {
+   tm1640d_msg msg;
+   memset(&msg, 0, sizeof(msg));
+   msg.cmd = TM1640D_FRAME;
+   msg.length = TM1640_GRIDS;
+   memcpy(msg.grid, frame->grid, TM1640_GRIDS);
+   return tm1640d_send(fd, &msg);
+}
+
+int tm1640d_segments(int fd, int offset, const char* segments, int length) {
+   tm1640d_msg msg;
+   if(offset < 0 || length < 0 || offset + length > TM1640_GRIDS) return -EINVAL;
+   memset(&msg, 0, sizeof(msg));
+   msg.cmd = TM1640D_SEGMENTS;
+   msg.offset = offset;
+   msg.length = length;
+   memcpy(msg.grid, segments, length);
+   return tm1640d_send(fd, &msg);
+}
+
+int tm1640d_clear(int fd) {
+   tm1640d_msg msg;
+   memset(&msg, 0, sizeof(msg));
+   msg.cmd = TM1640D_CLEAR;
+   return tm1640d_send(fd, &msg);
+}
+
+int tm1640d_brightness(int fd, int brightness) {
+   tm1640d_msg msg;
+   memset(&msg, 0, sizeof(msg));
+   msg.cmd = (brightness > 0) ? TM1640D_ON : TM1640D_OFF;
+   msg.offset = brightness;
+   return tm1640d_send(fd, &msg);
+}
+
+void tm1640d_close(int fd) {
+   close(fd);
+}
@@ -0,0 +1,149 @@
+/* ------------------------------------------------------------ *
+ * file:        tm1640d.c                                       *
+ * purpose:     Display daemon that owns the TM1640 pins. It    *
+ *              receives tm1640d_msg commands on a Unix datagram*
+ *              socket, and hands the resulting frame to the    *
+ *              background refresh thread. All commands queued  *
+ *              in the socket are applied before the frame is   *
+ *              published, so only the latest state is sent.    *
+ *                                                              *
+ * return:      0 on success, and -1 on errors.                 *
+ *                                                              *
+ * requires:    tm1640.c/.h, tm1640d.h                          *
+ *                                                              *
+ * compile:     see Makefile                                    *
+ *                                                              *
+ * example:     sudo ./tm1640d -r 100 -b 2 &                    *
+ *              ./tm1640-ctl write 12345678                     *
+ *                                                              *
+ * author:      10/17/2026 Frank4DD                             *
+ * ------------------------------------------------------------ */
+#include <unistd.h>
+#include <signal.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "tm1640d.h"
+
+volatile sig_atomic_t running = 1;        // cleared by SIGINT/SIGTERM
+
+void Handler(int signo) {
+   running = 0;
+}
+
+/* ------------------------------------------------------------ *
+ * apply() executes one client command. Returns 1 if the frame  *
+ * changed and needs to be published.                           *
+ * ------------------------------------------------------------ */
+static int apply(tm1640_refresh *r1, tm1640_frame *frame, const tm1640d_msg *msg) {
+   switch(msg->cmd) {
+      case TM1640D_FRAME:
+         memcpy(frame->grid, msg->grid, TM1640_GRIDS);
+         return 1;
+      case TM1640D_SEGMENTS:
+         return (tm1640_frameSegments(frame, msg->offset, (const char *) msg->grid, msg->length) == 0);
+      case TM1640D_CLEAR:
+         tm1640_frameClear(frame);
+         return 1;
+      case TM1640D_ON:
+         if(msg->offset < 1 || msg->offset > 7) return 0;
+         tm1640_refreshControl(r1, 0x88 + msg->offset);
+         return 0;
+      case TM1640D_OFF:
+         tm1640_refreshControl(r1, 0x80);
+         return 0;
+   }
+   return 0;
+}
+
+int main(int argc, char *argv[]) {
+   struct sockaddr_un addr;
+   struct sigaction sa;
+   sigset_t block, orig;
+   fd_set rfds;
+   tm1640_frame frame;
+   tm1640d_msg msg;
+   const char *path = getenv("TM1640D_SOCKET");
+   int hz = 100;                            // refresh rate
+   int brightness = 2;                      // initial brightness
+   int arg, sock, dirty;
+   ssize_t n;
+
+   while ((arg = getopt(argc, argv, "r:b:s:h")) != -1) {
+      switch (arg) {
+         case 'r': hz = atoi(optarg); break;
+         case 'b': brightness = atoi(optarg); break;
+         case 's': path = optarg; break;
+         default:
+            printf("Usage: ./tm1640d [-r refresh Hz] [-b brightness 1..7] [-s socket]\n");
+            return -1;
+      }
+   }
+   if(path == NULL) path = TM1640D_SOCKET;
+
+   /* --------------------------------------------------------- *
+    * bind the socket, clients run as any user                  *
+    * --------------------------------------------------------- */
+   if((sock = socket(AF_UNIX, SOCK_DGRAM, 0)) == -1) return -1;
+   memset(&addr, 0, sizeof(addr));
+   addr.sun_family = AF_UNIX;
+   strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+   unlink(path);
+   if(bind(sock, (struct sockaddr *) &addr, sizeof(addr)) == -1) {
+      printf("Error binding socket %s\n", path);
+      return -1;
+   }
+   chmod(path, 0666);
+
+   /* --------------------------------------------------------- *
+    * take over the display, and start the refresh thread       *
+    * --------------------------------------------------------- */
+   tm1640_display *d1 = tm1640_init(3,2);   // tm1640 clock and data pins
+   if(d1 == NULL) {
+      unlink(path);
+      return -1;
+   }
+   tm1640_displayOn(d1, brightness);
+   tm1640_displayClear(d1);
+   tm1640_frameClear(&frame);
+
+   /* --------------------------------------------------------- *
+    * SIGINT/SIGTERM stay blocked except inside pselect(), so a *
+    * signal between the running check and the wait is not     *
+    * lost. Blocked before the refresh thread starts, it then   *
+    * inherits the mask and the main thread gets the signals.   *
+    * --------------------------------------------------------- */
+   memset(&sa, 0, sizeof(sa));
+   sa.sa_handler = Handler;
+   sigaction(SIGINT, &sa, NULL);
+   sigaction(SIGTERM, &sa, NULL);
+   sigemptyset(&block);
+   sigaddset(&block, SIGINT);
+   sigaddset(&block, SIGTERM);
+   sigprocmask(SIG_BLOCK, &block, &orig);
+
+   tm1640_refresh *r1 = tm1640_refreshStart(d1, hz);
+
+   while(running) {
+      FD_ZERO(&rfds);
+      FD_SET(sock, &rfds);
+      if(pselect(sock + 1, &rfds, NULL, NULL, NULL, &orig) <= 0) continue; // EINTR
+      dirty = 0;
+
+      /* ------------------------------------------------------ *
+       * coalesce: apply everything already queued              *
+       * ------------------------------------------------------ */
+      while((n = recv(sock, &msg, sizeof(msg), MSG_DONTWAIT)) > 0) {
+         if(n == sizeof(msg)) dirty |= apply(r1, &frame, &msg);
+      }
+      if(dirty) tm1640_refreshPublish(r1, &frame);
+   }
+
+   tm1640_refreshStop(r1);
+   tm1640_printStats(d1, stdout);
+   tm1640_destroy(d1);
+   close(sock);
+   unlink(path);
+   return 0;
+}
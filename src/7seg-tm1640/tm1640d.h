@@ -0,0 +1,78 @@
+/* ------------------------------------------------------------ *
+ * file:        tm1640d.h                                       *
+ * purpose:     Client protocol of the tm1640d display daemon.  *
+ *              tm1640d owns the display pins, clients send it  *
+ *              fixed-size binary commands as datagrams over a  *
+ *              Unix socket. Sending never waits for the bus.   *
+ *                                                              *
+ * author:      10/17/2026 Frank4DD                             *
+ * ------------------------------------------------------------ */
+#ifndef TM1640D_H
+#define TM1640D_H
+
+#include <stdint.h>
+#include "tm1640.h"
+
+/**
+ * Default socket path of the daemon, TM1640D_SOCKET=<path> in the
+ * environment overrides it for both daemon and clients.
+ */
+#define TM1640D_SOCKET "/run/tm1640d.sock"
+
+/**
+ * Command codes in tm1640d_msg.cmd
+ */
+#define TM1640D_FRAME      1   // replace all 16 grids with msg.grid
+#define TM1640D_SEGMENTS   2   // write msg.length grids from msg.offset
+#define TM1640D_CLEAR      3   // all segments off
+#define TM1640D_ON         4   // display on, brightness in msg.offset
+#define TM1640D_OFF        5   // display off, preserving data
+
+/**
+ * One client command, sent as a single datagram.
+ */
+typedef struct {
+	uint8_t cmd;
+	uint8_t offset;
+	uint8_t length;
+	uint8_t reserved;
+	uint8_t grid[TM1640_GRIDS];
+} tm1640d_msg;
+
+/**
+ * Connects to the daemon socket.
+ *
+ * @return socket fd, or -1 if the daemon is not running.
+ */
+int tm1640d_connect(void);
+
+/**
+ * Sends a complete frame.
+ *
+ * @return 0 on success, -1 if the datagram could not be sent.
+ */
+int tm1640d_frame(int fd, const tm1640_frame* frame);
+
+/**
+ * Sends raw segments for length grids, starting at grid offset.
+ *
+ * @return -EINVAL if offset + length > 16, -1 on send errors, 0 on success.
+ */
+int tm1640d_segments(int fd, int offset, const char* segments, int length);
+
+/**
+ * Clears the display.
+ */
+int tm1640d_clear(int fd);
+
+/**
+ * Turns the display on with brightness 1..7, or off with 0.
+ */
+int tm1640d_brightness(int fd, int brightness);
+
+/**
+ * Closes the daemon connection.
+ */
+void tm1640d_close(int fd);
+
+#endif
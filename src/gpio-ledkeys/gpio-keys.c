@@ -4,33 +4,51 @@
  *              We have 4 buttons UP - DOWN - MODE - ENTER:     *
  *              UP = RPI1 LED ON, DOWN = RPI1 LED OFF           *
  *              MODE = RPI2 LED ON, ENTER = RPI2 LED OFF        *
+ *              It prints the button events: press, release,    *
+ *              long-press, repeat and chords (two buttons).    *
  *                                                              *
  * requires:    WiringPi: sudo apt-get install wiringpi         *
+ *              buttons.c/.h, gpio-sim.c/.h                     *
  *                                                              *
  * compile:     see Makefile, needs -lWiringPi -lm              *
  *                                                              *
  * example:     ./gpio-keys                                     *
+ *              GPIO_SIM=../gpio-sim/traces/keys.trace          *
+ *              GPIO_SIM_LOG=keys.log ./gpio-keys               *
  *                                                              *
  * author:      05/30/2020 Frank4DD                             *
  * ------------------------------------------------------------ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
 #include <wiringPi.h>
+#include "buttons.h"
+
+void sigint_handler(int sig) {
+  exit(0);                // flushes the GPIO_SIM_LOG
+}
 
 int main (void) {
+  btn_event ev;
+
+  signal(SIGINT, sigint_handler);
   wiringPiSetup ();
-  pinMode (21, INPUT);  // SW1 Up
-  pinMode (22, INPUT);  // SW2 Mode
-  pinMode (23, INPUT);  // SW3 Down
-  pinMode (24, INPUT);  // SW4 Enter
+  if(btn_open(BTN_DEBOUNCE) == -1) return -1;
 
   pinMode (26, OUTPUT); // LED D2 RPI1 (green)
   pinMode (4, OUTPUT);  // LED D3 RPI2 (orange)
 
-  for (;;) {
-    if(digitalRead(21) == LOW) digitalWrite (26, HIGH);
-    if(digitalRead(23) == LOW) digitalWrite (26, LOW);
-    if(digitalRead(22) == LOW) digitalWrite (4, HIGH);
-    if(digitalRead(24) == LOW) digitalWrite (4, LOW);
-    delay (200);
+  while(btn_wait(-1) >= 0) {
+    while(btn_read(&ev) == 1) {
+      printf("%-5s %-7s", btn_name[ev.button], btn_type[ev.type]);
+      if(ev.type == BTN_CHORD) printf(" + %-5s", btn_name[ev.button2]);
+      printf(" at %lld.%03lld s\n", ev.time / 1000000000LL, (ev.time / 1000000LL) % 1000);
+      if(ev.type != BTN_PRESS) continue;
+      if(ev.button == BTN_UP)    digitalWrite (26, HIGH);
+      if(ev.button == BTN_DOWN)  digitalWrite (26, LOW);
+      if(ev.button == BTN_MODE)  digitalWrite (4, HIGH);
+      if(ev.button == BTN_ENTER) digitalWrite (4, LOW);
+    }
   }
   return 0;
 }
@@ -0,0 +1,36 @@
+/* ------------------------------------------------------------ *
+ * file:        gpio-sim.h                                      *
+ * purpose:     Headless GPIO simulator. Replays scripted input *
+ *              traces with exact timestamps, and records every *
+ *              output pin change, so GPIO programs run on any  *
+ *              Linux machine.                                  *
+ *                                                              *
+ * author:      10/17/2026 Frank4DD                             *
+ * ------------------------------------------------------------ */
+#ifndef GPIO_SIM_H
+#define GPIO_SIM_H
+
+#define GPIOSIM_TRACE   "GPIO_SIM"       // env: input trace file
+#define GPIOSIM_LOG     "GPIO_SIM_LOG"   // env: pin change log, "-" = stdout
+#define GPIOSIM_MAX     4096             // max trace lines
+#define GPIOSIM_END     -1               // pin of the trace END line
+
+typedef struct {
+  long long time;                        // ns from simulation start
+  int pin;                               // BCM GPIO, or GPIOSIM_END
+  int level;                             // 0 = low, 1 = high
+} gpiosim_edge;
+
+extern gpiosim_edge gpiosim_trace[GPIOSIM_MAX];
+extern int gpiosim_count;                // number of trace lines
+extern long long gpiosim_start;          // simulation start, MONOTONIC ns
+
+extern int gpiosim_open(void);
+extern long long gpiosim_clock(void);
+extern long long gpiosim_end(void);
+extern int gpiosim_level(int pin, long long time);
+extern int gpiosim_wpi(int wpi);
+extern void gpiosim_input(int pin, int level, long long time);
+extern void gpiosim_output(int pin, int level);
+
+#endif
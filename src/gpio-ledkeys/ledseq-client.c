@@ -0,0 +1,44 @@
+/* ------------------------------------------------------------ *
+ * file:        ledseq-client.c                                 *
+ * purpose:     Posts LED patterns to the ledseqd daemon. Each  *
+ *              post is one non-blocking datagram, programs     *
+ *              spend no thread or timer on the LEDs.           *
+ *                                                              *
+ * requires:    ledseq.h                                        *
+ *                                                              *
+ * author:      10/17/2026 Frank4DD                             *
+ * ------------------------------------------------------------ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "ledseq.h"
+
+/* ------------------------------------------------------------ *
+ * ledseq_post() sends a pattern spec for led to the daemon.    *
+ * Returns 0 on success, -1 if the daemon is not running or     *
+ * its queue is full. The daemon ignores invalid specs.         *
+ * ------------------------------------------------------------ */
+int ledseq_post(int led, const char *spec) {
+  struct sockaddr_un addr;
+  const char *path = getenv("LEDSEQ_SOCKET");
+  ledseq_msg msg;
+  int fd, ret = 0;
+
+  if(led < 0 || led >= LEDSEQ_COUNT || strlen(spec) >= LEDSEQ_SPECLEN) return -1;
+  if(path == NULL) path = LEDSEQ_SOCKET;
+  if((fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0)) == -1) return -1;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+
+  memset(&msg, 0, sizeof(msg));
+  msg.led = led;
+  strcpy(msg.spec, spec);
+  if(sendto(fd, &msg, sizeof(msg), MSG_DONTWAIT, (struct sockaddr *) &addr,
+            sizeof(addr)) != sizeof(msg)) ret = -1;
+  close(fd);
+  return ret;
+}
@@ -0,0 +1,84 @@
+/* ------------------------------------------------------------ *
+ * file:        ledseq-ctl.c                                    *
+ * purpose:     Sets an LED pattern. The pattern goes to the    *
+ *              ledseqd daemon if it is running. Otherwise the  *
+ *              program runs the sequencer itself, until ctrl+c *
+ *              or the -t run time in ms ends.                  *
+ *                                                              *
+ * requires:    ledseq.c/.h, gpio-sim.c/.h                      *
+ *                                                              *
+ * example:     ./ledseq-ctl 1 breathe:2000                     *
+ *              ./ledseq-ctl -t 5000 2 morse:SOS,100            *
+ *                                                              *
+ * author:      10/17/2026 Frank4DD                             *
+ * ------------------------------------------------------------ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+#include <poll.h>
+#include "ledseq.h"
+
+volatile sig_atomic_t running = 1;        // cleared by SIGINT/SIGTERM
+
+void Handler(int signo) {
+  running = 0;
+}
+
+void usage() {
+  printf("Usage: ledseq-ctl [-t ms] <1|2> <pattern>\n");
+  printf("   patterns: on, off, dim:<0..255>, blink:<on ms>[,<off ms>],\n");
+  printf("             breathe:<period ms>, morse:<text>[,<unit ms>]\n");
+  printf("   -t   run time if ledseqd is not running, default until ctrl+c\n");
+  exit(-1);
+}
+
+int main(int argc, char *argv[]) {
+  struct sigaction sa;
+  struct pollfd fds[1];
+  ledseq_pattern pat;
+  struct timespec end, now;
+  int runtime = -1, timeout, led, arg, tfd;
+
+  while ((arg = getopt(argc, argv, "t:h")) != -1) {
+    if(arg == 't') runtime = atoi(optarg);
+    else usage();
+  }
+  if(argc - optind != 2) usage();
+  led = atoi(argv[optind]) - 1;
+  if(led < 0 || led >= LEDSEQ_COUNT) usage();
+  if(ledseq_compile(argv[optind+1], &pat) == -1) {
+    printf("Error invalid pattern %s\n", argv[optind+1]);
+    return -1;
+  }
+  if(ledseq_post(led, argv[optind+1]) == 0) return 0;
+
+  /* --------------------------------------------------------- *
+   * no daemon: run the pattern here                           *
+   * --------------------------------------------------------- */
+  if((tfd = ledseq_open(0)) == -1) return -1;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = Handler;
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+  ledseq_set(led, &pat);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  end.tv_sec += runtime / 1000;
+  end.tv_nsec += (runtime % 1000) * 1000000L;
+
+  fds[0].fd = tfd;
+  fds[0].events = POLLIN;
+  while(running) {
+    timeout = -1;
+    if(runtime > 0) {
+      clock_gettime(CLOCK_MONOTONIC, &now);
+      timeout = (end.tv_sec - now.tv_sec) * 1000 + (end.tv_nsec - now.tv_nsec) / 1000000;
+      if(timeout <= 0) break;
+    }
+    if(poll(fds, 1, timeout) > 0) ledseq_run();
+  }
+  ledseq_close();
+  return 0;
+}
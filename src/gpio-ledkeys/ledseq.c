@@ -0,0 +1,392 @@
+/* ------------------------------------------------------------ *
+ * file:        ledseq.c                                        *
+ * purpose:     LED pattern sequencer. A pattern spec compiles  *
+ *              into a table of brightness steps:               *
+ *                                                              *
+ *                on, off, dim:<level 0..255>                   *
+ *                blink:<on ms>[,<off ms>]                      *
+ *                breathe:<period ms>                           *
+ *                morse:<text>[,<unit ms>]                      *
+ *                                                              *
+ *              Tables repeat in a loop. One timerfd, armed on  *
+ *              the next absolute deadline of both LEDs, runs   *
+ *              the steps and the software PWM edges for dimmed *
+ *              levels. All times derive from the step start,   *
+ *              so a late wakeup never shifts the pattern.      *
+ *              LED1 (BCM 12) can use the hardware PWM0 through *
+ *              sysfs instead, this needs the device tree       *
+ *              overlay dtoverlay=pwm,pin=12,func=4.            *
+ *              With GPIO_SIM or GPIO_SIM_LOG set, no pins are  *
+ *              driven, the LED changes go to the gpio-sim log. *
+ *                                                              *
+ * requires:    Linux GPIO chardev, gpio-sim.c/.h, -lpthread    *
+ *                                                              *
+ * author:      10/17/2026 Frank4DD                             *
+ * ------------------------------------------------------------ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/timerfd.h>
+#include <linux/gpio.h>
+#include "ledseq.h"
+#include "gpio-sim.h"
+
+/* ------------------------------------------------------------ *
+ * LEDs are active high, BCM GPIO numbers = gpiochip0 offsets   *
+ * ------------------------------------------------------------ */
+static const int ledseq_line[LEDSEQ_COUNT] = { 12, 23 };
+static const char *ledseq_name[LEDSEQ_COUNT] = { "LED1", "LED2" };
+
+typedef struct {
+  ledseq_pattern pat;
+  int index;                               // current step
+  long long start;                         // step start in ns
+  long long end;                           // step end in ns, -1 = hold
+  long long pwmnext;                       // next PWM edge, -1 = none
+  int out;                                 // pin level, -1 = unknown
+  int fd;                                  // line handle, -1 = none
+  int pwmfd;                               // sysfs duty_cycle, -1 = none
+} ledseq_led;
+
+static ledseq_led ledseq[LEDSEQ_COUNT];
+static int ledseq_tfd = -1;
+static int ledseq_sim = 0;
+
+/* ------------------------------------------------------------ *
+ * Morse code of A..Z and 0..9                                  *
+ * ------------------------------------------------------------ */
+static const char *ledseq_morse[36] = {
+  ".-", "-...", "-.-.", "-..", ".", "..-.", "--.", "....", "..", ".---",
+  "-.-", ".-..", "--", "-.", "---", ".--.", "--.-", ".-.", "...", "-",
+  "..-", "...-", ".--", "-..-", "-.--", "--..",
+  "-----", ".----", "..---", "...--", "....-", ".....", "-....", "--...",
+  "---..", "----."
+};
+
+static long long ledseq_clock(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* ------------------------------------------------------------ *
+ * ledseq_add() appends a step, merging it with an equal level  *
+ * ------------------------------------------------------------ */
+static int ledseq_add(ledseq_pattern *p, int level, int ms) {
+  if(p->count > 0 && p->step[p->count-1].level == level
+     && p->step[p->count-1].ms + ms < 65536) {
+    p->step[p->count-1].ms += ms;
+    return 0;
+  }
+  if(p->count >= LEDSEQ_STEPS || ms > 65535) return -1;
+  p->step[p->count].level = level;
+  p->step[p->count].ms = ms;
+  p->count++;
+  return 0;
+}
+
+/* ------------------------------------------------------------ *
+ * ledseq_compile() translates a pattern spec into a step table *
+ * Returns the number of steps, or -1 if the spec is invalid.   *
+ * ------------------------------------------------------------ */
+int ledseq_compile(const char *spec, ledseq_pattern *p) {
+  const char *arg = strchr(spec, ':');
+  const char *code, *c;
+  char text[LEDSEQ_SPECLEN];
+  int a = 0, b = 0, n, i, lin, ret = 0;
+
+  memset(p, 0, sizeof(ledseq_pattern));
+  if(arg != NULL) arg++;
+  if(strcmp(spec, "on") == 0) return ledseq_add(p, LEDSEQ_MAX, 0) + 1;
+  if(strcmp(spec, "off") == 0) return ledseq_add(p, 0, 0) + 1;
+
+  if(strncmp(spec, "dim:", 4) == 0) {
+    a = atoi(arg);
+    if(a < 0 || a > LEDSEQ_MAX) return -1;
+    return ledseq_add(p, a, 0) + 1;
+  }
+  if(strncmp(spec, "blink:", 6) == 0) {
+    n = sscanf(arg, "%d,%d", &a, &b);
+    if(n < 2) b = a;
+    if(n < 1 || a < 1 || b < 1) return -1;
+    ret |= ledseq_add(p, LEDSEQ_MAX, a);
+    ret |= ledseq_add(p, 0, b);
+    return (ret == 0) ? p->count : -1;
+  }
+  /* ---------------------------------------------------------- *
+   * breathe: a triangle of LEDSEQ_BREATHE ms steps, squared to *
+   * look linear to the eye                                     *
+   * ---------------------------------------------------------- */
+  if(strncmp(spec, "breathe:", 8) == 0) {
+    a = atoi(arg);
+    n = a / LEDSEQ_BREATHE;
+    if(n > LEDSEQ_STEPS) n = LEDSEQ_STEPS;
+    if(n < 2) return -1;
+    for(i = 0; i < n; i++) {
+      lin = LEDSEQ_MAX - abs(2 * i * LEDSEQ_MAX / n - LEDSEQ_MAX);
+      ret |= ledseq_add(p, lin * lin / LEDSEQ_MAX, a / n);
+    }
+    return (ret == 0) ? p->count : -1;
+  }
+  /* ---------------------------------------------------------- *
+   * morse: dot 1 unit, dash 3, gap 1 between symbols, 3 between *
+   * letters, 7 between words and before the repeat             *
+   * ---------------------------------------------------------- */
+  if(strncmp(spec, "morse:", 6) == 0) {
+    b = LEDSEQ_MORSE;
+    snprintf(text, sizeof(text), "%s", arg);
+    if((code = strchr(text, ',')) != NULL) {
+      b = atoi(code + 1);
+      text[code - text] = '\0';
+    }
+    if(b < 1 || text[0] == '\0') return -1;
+    for(c = text; *c != '\0'; c++) {
+      if(*c == ' ') {
+        ret |= ledseq_add(p, 0, 4 * b);    // 3 after the letter + 4
+        continue;
+      }
+      if(isalpha((unsigned char) *c)) code = ledseq_morse[toupper((unsigned char) *c) - 'A'];
+      else if(isdigit((unsigned char) *c)) code = ledseq_morse[26 + *c - '0'];
+      else return -1;
+      for(i = 0; code[i] != '\0'; i++) {
+        ret |= ledseq_add(p, LEDSEQ_MAX, (code[i] == '-') ? 3 * b : b);
+        ret |= ledseq_add(p, 0, (code[i+1] == '\0') ? 3 * b : b);
+      }
+    }
+    ret |= ledseq_add(p, 0, 4 * b);
+    return (ret == 0) ? p->count : -1;
+  }
+  return -1;
+}
+
+/* ------------------------------------------------------------ *
+ * ledseq_pin() sets the LED pin, only if the level changed     *
+ * ------------------------------------------------------------ */
+static void ledseq_pin(int led, int level) {
+  struct gpiohandle_data data;
+
+  if(ledseq[led].out == level) return;
+  ledseq[led].out = level;
+  gpiosim_output(ledseq_line[led], level);
+  if(ledseq[led].fd == -1) return;
+  memset(&data, 0, sizeof(data));
+  data.values[0] = level;
+  ioctl(ledseq[led].fd, GPIOHANDLE_SET_LINE_VALUES_IOCTL, &data);
+}
+
+/* ------------------------------------------------------------ *
+ * ledseq_output() drives the level of the current step at now. *
+ * Dimmed levels on a GPIO pin run software PWM cycles counted  *
+ * from the step start, pwmnext is the next edge.               *
+ * ------------------------------------------------------------ */
+static void ledseq_output(int led, long long now) {
+  ledseq_led *l = &ledseq[led];
+  int level = l->pat.step[l->index].level;
+  long long period = 1000000000LL / LEDSEQ_PWMHZ;
+  long long on = level * period / LEDSEQ_MAX;
+  long long cycle;
+  char duty[16];
+
+  l->pwmnext = -1;
+  if(l->pwmfd != -1) {                     // hardware PWM, 1ms period
+    snprintf(duty, sizeof(duty), "%d", level * 1000000 / LEDSEQ_MAX);
+    if(pwrite(l->pwmfd, duty, strlen(duty), 0) == -1) return;
+    gpiosim_output(ledseq_line[led], level > 0);
+    return;
+  }
+  if(level == 0 || level == LEDSEQ_MAX) {
+    ledseq_pin(led, level > 0);
+    return;
+  }
+  cycle = l->start + (now - l->start) / period * period;
+  if(now < cycle + on) {
+    ledseq_pin(led, 1);
+    l->pwmnext = cycle + on;
+  }
+  else {
+    ledseq_pin(led, 0);
+    l->pwmnext = cycle + period;
+  }
+}
+
+/* ------------------------------------------------------------ *
+ * ledseq_arm() sets the timerfd to the earliest deadline       *
+ * ------------------------------------------------------------ */
+static void ledseq_arm(void) {
+  struct itimerspec its;
+  long long next = -1;
+  int i;
+
+  for(i = 0; i < LEDSEQ_COUNT; i++) {
+    if(ledseq[i].end != -1 && (next == -1 || ledseq[i].end < next)) next = ledseq[i].end;
+    if(ledseq[i].pwmnext != -1 && (next == -1 || ledseq[i].pwmnext < next)) next = ledseq[i].pwmnext;
+  }
+  memset(&its, 0, sizeof(its));
+  if(next != -1) {                         // all zero disarms the timer
+    its.it_value.tv_sec = next / 1000000000LL;
+    its.it_value.tv_nsec = next % 1000000000LL;
+  }
+  timerfd_settime(ledseq_tfd, TFD_TIMER_ABSTIME, &its, NULL);
+}
+
+/* ------------------------------------------------------------ *
+ * ledseq_request() gets a GPIO line handle for an LED output   *
+ * ------------------------------------------------------------ */
+static int ledseq_request(int led) {
+  struct gpiohandle_request req;
+  const char *chip = getenv("LEDSEQ_GPIOCHIP");
+  int fd;
+
+  if(chip == NULL) chip = LEDSEQ_CHIP;
+  if((fd = open(chip, O_RDONLY | O_CLOEXEC)) == -1) {
+    printf("Error open %s\n", chip);
+    return -1;
+  }
+  memset(&req, 0, sizeof(req));
+  req.lineoffsets[0] = ledseq_line[led];
+  req.lines = 1;
+  req.flags = GPIOHANDLE_REQUEST_OUTPUT;
+  snprintf(req.consumer_label, sizeof(req.consumer_label), "picon-%s", ledseq_name[led]);
+  if(ioctl(fd, GPIO_GET_LINEHANDLE_IOCTL, &req) == -1) {
+    printf("Error request GPIO %d for %s\n", ledseq_line[led], ledseq_name[led]);
+    close(fd);
+    return -1;
+  }
+  close(fd);
+  ledseq[led].fd = req.fd;
+  return 0;
+}
+
+/* ------------------------------------------------------------ *
+ * ledseq_pwm() sets up the sysfs hardware PWM0 for LED1        *
+ * ------------------------------------------------------------ */
+static int ledseq_pwm(void) {
+  const char *setup[3][2] = {
+    { LEDSEQ_PWMCHIP "/pwm0/period", "1000000" },
+    { LEDSEQ_PWMCHIP "/pwm0/duty_cycle", "0" },
+    { LEDSEQ_PWMCHIP "/pwm0/enable", "1" }
+  };
+  int fd, i;
+
+  if(access(LEDSEQ_PWMCHIP "/pwm0", F_OK) == -1) {
+    if((fd = open(LEDSEQ_PWMCHIP "/export", O_WRONLY)) == -1) return -1;
+    i = write(fd, "0", 1);
+    close(fd);
+    if(i != 1) return -1;
+  }
+  for(i = 0; i < 3; i++) {
+    if((fd = open(setup[i][0], O_WRONLY)) == -1) return -1;
+    if(write(fd, setup[i][1], strlen(setup[i][1])) == -1) {
+      close(fd);
+      return -1;
+    }
+    close(fd);
+  }
+  if((fd = open(LEDSEQ_PWMCHIP "/pwm0/duty_cycle", O_WRONLY | O_CLOEXEC)) == -1) return -1;
+  ledseq[LEDSEQ_LED1].pwmfd = fd;
+  return 0;
+}
+
+/* ------------------------------------------------------------ *
+ * ledseq_open() takes over the LED pins, and returns the timer *
+ * fd to poll. hwpwm = 1 drives LED1 by the hardware PWM0, and  *
+ * falls back to software PWM if sysfs has no pwmchip0.         *
+ * ------------------------------------------------------------ */
+int ledseq_open(int hwpwm) {
+  int i;
+
+  for(i = 0; i < LEDSEQ_COUNT; i++) {
+    memset(&ledseq[i], 0, sizeof(ledseq_led));
+    ledseq[i].pat.count = 1;               // off, hold
+    ledseq[i].end = -1;
+    ledseq[i].pwmnext = -1;
+    ledseq[i].out = -1;
+    ledseq[i].fd = -1;
+    ledseq[i].pwmfd = -1;
+  }
+  if((ledseq_sim = gpiosim_open()) == -1) return -1;
+  if(getenv(GPIOSIM_LOG) != NULL) ledseq_sim = 1;
+  if(!ledseq_sim) {
+    if(hwpwm && ledseq_pwm() == -1) printf("No hardware PWM, LED1 uses software PWM\n");
+    for(i = 0; i < LEDSEQ_COUNT; i++) {
+      if(ledseq[i].pwmfd != -1) continue;
+      if(ledseq_request(i) == -1) {
+        ledseq_close();
+        return -1;
+      }
+    }
+  }
+  if((ledseq_tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) == -1) {
+    ledseq_close();
+    return -1;
+  }
+  for(i = 0; i < LEDSEQ_COUNT; i++) ledseq_output(i, ledseq_clock());
+  return ledseq_tfd;
+}
+
+/* ------------------------------------------------------------ *
+ * ledseq_set() starts a compiled pattern on an LED, now        *
+ * ------------------------------------------------------------ */
+int ledseq_set(int led, const ledseq_pattern *p) {
+  long long now = ledseq_clock();
+
+  if(led < 0 || led >= LEDSEQ_COUNT || p->count < 1) return -1;
+  ledseq[led].pat = *p;
+  ledseq[led].index = 0;
+  ledseq[led].start = now;
+  ledseq[led].end = (p->step[0].ms > 0) ? now + p->step[0].ms * 1000000LL : -1;
+  ledseq_output(led, now);
+  ledseq_arm();
+  return 0;
+}
+
+/* ------------------------------------------------------------ *
+ * ledseq_run() advances steps and PWM edges that are due, and  *
+ * re-arms the timer. Call it when the timer fd is readable.    *
+ * Returns the number of timer expirations, 0 if none.          *
+ * ------------------------------------------------------------ */
+int ledseq_run(void) {
+  unsigned long long expired = 0;
+  long long now = ledseq_clock();
+  ledseq_led *l;
+  int i;
+
+  if(read(ledseq_tfd, &expired, sizeof(expired)) != sizeof(expired)) expired = 0;
+  for(i = 0; i < LEDSEQ_COUNT; i++) {
+    l = &ledseq[i];
+    if(l->end != -1 && l->end <= now) {
+      while(l->end != -1 && l->end <= now) {
+        l->index = (l->index + 1) % l->pat.count;
+        l->start = l->end;
+        l->end = (l->pat.step[l->index].ms > 0) ? l->start + l->pat.step[l->index].ms * 1000000LL : -1;
+      }
+      ledseq_output(i, now);
+    }
+    else if(l->pwmnext != -1 && l->pwmnext <= now) ledseq_output(i, now);
+  }
+  ledseq_arm();
+  return expired;
+}
+
+/* ------------------------------------------------------------ *
+ * ledseq_close() turns the LEDs off and releases them          *
+ * ------------------------------------------------------------ */
+void ledseq_close(void) {
+  int i;
+
+  for(i = 0; i < LEDSEQ_COUNT; i++) {
+    ledseq[i].pat.step[ledseq[i].index].level = 0;
+    ledseq_output(i, 0);
+    if(ledseq[i].fd != -1) close(ledseq[i].fd);
+    if(ledseq[i].pwmfd != -1) close(ledseq[i].pwmfd);
+    ledseq[i].fd = -1;
+    ledseq[i].pwmfd = -1;
+  }
+  if(ledseq_tfd != -1) close(ledseq_tfd);
+  ledseq_tfd = -1;
+}
@@ -0,0 +1,50 @@
+/* ------------------------------------------------------------ *
+ * file:        ledseq.h                                        *
+ * purpose:     LED pattern sequencer for the two PiCon One     *
+ *              status LEDs. Patterns are compiled once into    *
+ *              step tables, one timerfd schedules all steps    *
+ *              and software PWM edges of both LEDs.            *
+ *                                                              *
+ * author:      10/17/2026 Frank4DD                             *
+ * ------------------------------------------------------------ */
+#ifndef LEDSEQ_H
+#define LEDSEQ_H
+
+#define LEDSEQ_CHIP     "/dev/gpiochip0" // LEDSEQ_GPIOCHIP=<path> overrides
+#define LEDSEQ_PWMCHIP  "/sys/class/pwm/pwmchip0"
+#define LEDSEQ_SOCKET   "/run/ledseqd.sock" // LEDSEQ_SOCKET=<path> overrides
+#define LEDSEQ_COUNT    2
+#define LEDSEQ_STEPS    256              // max steps per pattern
+#define LEDSEQ_SPECLEN  64               // max pattern spec length
+#define LEDSEQ_MAX      255              // full brightness
+#define LEDSEQ_PWMHZ    200              // software PWM frequency
+#define LEDSEQ_BREATHE  20               // breathe step in ms
+#define LEDSEQ_MORSE    150              // default morse unit in ms
+
+#define LEDSEQ_LED1     0                // D2 green, BCM GPIO 12 (PWM0)
+#define LEDSEQ_LED2     1                // D3 orange, BCM GPIO 23
+
+typedef struct {
+  unsigned char level;                   // brightness 0..LEDSEQ_MAX
+  unsigned short ms;                     // step time, 0 = hold
+} ledseq_step;
+
+typedef struct {
+  ledseq_step step[LEDSEQ_STEPS];
+  int count;                             // steps, repeated in a loop
+} ledseq_pattern;
+
+typedef struct {
+  unsigned char led;                     // LEDSEQ_LED1 .. LEDSEQ_LED2
+  char spec[LEDSEQ_SPECLEN];             // pattern, '\0' terminated
+} ledseq_msg;
+
+extern int ledseq_compile(const char *spec, ledseq_pattern *p);
+extern int ledseq_open(int hwpwm);
+extern int ledseq_set(int led, const ledseq_pattern *p);
+extern int ledseq_run(void);
+extern void ledseq_close(void);
+
+extern int ledseq_post(int led, const char *spec);
+
+#endif
@@ -0,0 +1,105 @@
+/* ------------------------------------------------------------ *
+ * file:        ledseqd.c                                       *
+ * purpose:     LED sequencer daemon. It owns the two status    *
+ *              LEDs, and receives ledseq_msg patterns from any *
+ *              PiCon program on a Unix datagram socket. One    *
+ *              poll() waits on the socket and the sequencer    *
+ *              timerfd, the daemon runs no threads and sleeps  *
+ *              between LED steps.                              *
+ *                                                              *
+ * return:      0 on success, and -1 on errors.                 *
+ *                                                              *
+ * requires:    ledseq.c/.h, gpio-sim.c/.h                      *
+ *                                                              *
+ * compile:     see Makefile                                    *
+ *                                                              *
+ * example:     sudo ./ledseqd -p &                             *
+ *              ./ledseq-ctl 2 morse:SOS                        *
+ *                                                              *
+ * author:      10/17/2026 Frank4DD                             *
+ * ------------------------------------------------------------ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "ledseq.h"
+
+volatile sig_atomic_t running = 1;        // cleared by SIGINT/SIGTERM
+
+void Handler(int signo) {
+  running = 0;
+}
+
+int main(int argc, char *argv[]) {
+  struct sockaddr_un addr;
+  struct sigaction sa;
+  struct pollfd fds[2];
+  ledseq_pattern pat;
+  ledseq_msg msg;
+  const char *path = getenv("LEDSEQ_SOCKET");
+  int hwpwm = 0;                          // 1 = LED1 on PWM0
+  int arg, sock, tfd;
+
+  while ((arg = getopt(argc, argv, "ps:h")) != -1) {
+    switch (arg) {
+      case 'p': hwpwm = 1; break;
+      case 's': path = optarg; break;
+      default:
+        printf("Usage: ./ledseqd [-p] [-s socket]\n");
+        printf("   -p   LED1 uses hardware PWM0 (dtoverlay=pwm,pin=12,func=4)\n");
+        return -1;
+    }
+  }
+  if(path == NULL) path = LEDSEQ_SOCKET;
+
+  /* --------------------------------------------------------- *
+   * bind the socket, clients run as any user                  *
+   * --------------------------------------------------------- */
+  if((sock = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0)) == -1) return -1;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+  unlink(path);
+  if(bind(sock, (struct sockaddr *) &addr, sizeof(addr)) == -1) {
+    printf("Error binding socket %s\n", path);
+    return -1;
+  }
+  chmod(path, 0666);
+
+  if((tfd = ledseq_open(hwpwm)) == -1) {
+    unlink(path);
+    return -1;
+  }
+
+  // no SA_RESTART, poll() returns EINTR on a signal
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = Handler;
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+
+  fds[0].fd = sock;
+  fds[0].events = POLLIN;
+  fds[1].fd = tfd;
+  fds[1].events = POLLIN;
+  while(running) {
+    if(poll(fds, 2, -1) == -1) continue;
+    if(fds[1].revents & POLLIN) ledseq_run();
+    if(fds[0].revents & POLLIN) {
+      while(recv(sock, &msg, sizeof(msg), MSG_DONTWAIT) == sizeof(msg)) {
+        msg.spec[LEDSEQ_SPECLEN-1] = '\0';
+        if(ledseq_compile(msg.spec, &pat) == -1 || ledseq_set(msg.led, &pat) == -1)
+          printf("Invalid pattern for LED%d: %s\n", msg.led + 1, msg.spec);
+      }
+    }
+  }
+
+  ledseq_close();
+  close(sock);
+  unlink(path);
+  return 0;
+}
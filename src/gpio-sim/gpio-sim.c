@@ -0,0 +1,201 @@
+/* ------------------------------------------------------------ *
+ * file:        gpio-sim.c                                      *
+ * purpose:     Headless GPIO simulator, enabled at run time by *
+ *              GPIO_SIM=<trace file> in the environment. The   *
+ *              trace lists input level changes in ms from the  *
+ *              program start, one per line:                    *
+ *                                                              *
+ *                # ms    pin     level                         *
+ *                100     MODE    0                             *
+ *                180     MODE    1                             *
+ *                2000    END                                   *
+ *                                                              *
+ *              Pins are BCM GPIO numbers, or the PiCon One     *
+ *              names UP MODE DOWN ENTER LED1 LED2 SCLK DIN.    *
+ *              END stops the program (SIGINT). Inputs not in   *
+ *              the trace read high. GPIO_SIM_LOG=<file> logs   *
+ *              the replayed inputs and all output changes as   *
+ *              "<ns> in|out <pin> <level>", for regression and *
+ *              input-to-output latency checks.                 *
+ *                                                              *
+ * author:      10/17/2026 Frank4DD                             *
+ * ------------------------------------------------------------ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <pthread.h>
+#include "gpio-sim.h"
+
+gpiosim_edge gpiosim_trace[GPIOSIM_MAX];
+int gpiosim_count = 0;
+long long gpiosim_start = 0;
+
+static int gpiosim_state = 0;              // 0 = unknown, 1 = on, -1 = off, -2 = bad
+static FILE *gpiosim_logfile = NULL;
+static int gpiosim_out[64];                // last output levels, -1 = none
+static pthread_mutex_t gpiosim_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* ------------------------------------------------------------ *
+ * PiCon One pin names, BCM GPIO numbers                        *
+ * ------------------------------------------------------------ */
+static const struct { const char *name; int pin; } gpiosim_names[] = {
+  { "UP", 5 }, { "MODE", 6 }, { "DOWN", 13 }, { "ENTER", 19 },
+  { "LED1", 12 }, { "LED2", 23 }, { "SCLK", 22 }, { "DIN", 27 },
+};
+
+/* ------------------------------------------------------------ *
+ * WiringPi pin number to BCM GPIO number (board rev 2 and up)  *
+ * ------------------------------------------------------------ */
+static const int gpiosim_wpi_bcm[32] = {
+   17, 18, 27, 22, 23, 24, 25,  4,  2,  3,  8,  7, 10,  9, 11, 14,
+   15, -1, -1, -1, -1,  5,  6, 13, 19, 26, 12, 16, 20, 21,  0,  1
+};
+
+long long gpiosim_clock(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+int gpiosim_wpi(int wpi) {
+  if(wpi < 0 || wpi > 31) return -1;
+  return gpiosim_wpi_bcm[wpi];
+}
+
+/* ------------------------------------------------------------ *
+ * gpiosim_pin() converts a pin name or BCM number, -1 if bad   *
+ * ------------------------------------------------------------ */
+static int gpiosim_pin(const char *name) {
+  unsigned int i;
+  char *end;
+  long pin;
+
+  for(i = 0; i < sizeof(gpiosim_names) / sizeof(gpiosim_names[0]); i++) {
+    if(strcasecmp(name, gpiosim_names[i].name) == 0) return gpiosim_names[i].pin;
+  }
+  pin = strtol(name, &end, 10);
+  if(*end != '\0' || pin < 0 || pin > 53) return -1;
+  return pin;
+}
+
+/* ------------------------------------------------------------ *
+ * gpiosim_open() loads the trace and opens the log on first    *
+ * call. Returns 1 if a trace is loaded, 0 if GPIO_SIM is not   *
+ * set (outputs are still logged), -1 if the trace is bad, on   *
+ * every call. Trace times must not go backwards.               *
+ * ------------------------------------------------------------ */
+int gpiosim_open(void) {
+  const char *path = getenv(GPIOSIM_TRACE);
+  const char *log = getenv(GPIOSIM_LOG);
+  char line[128], pin[32];
+  double ms;
+  int level, n, ret;
+  FILE *fp;
+
+  pthread_mutex_lock(&gpiosim_lock);
+  if(gpiosim_state != 0) {
+    ret = gpiosim_state;
+    pthread_mutex_unlock(&gpiosim_lock);
+    if(ret == -2) return -1;
+    return (ret == 1) ? 1 : 0;
+  }
+  if(log != NULL) {
+    if(strcmp(log, "-") == 0) gpiosim_logfile = stdout;
+    else gpiosim_logfile = fopen(log, "w");
+  }
+  memset(gpiosim_out, -1, sizeof(gpiosim_out));
+  gpiosim_start = gpiosim_clock();
+  gpiosim_state = -1;
+  if(path == NULL) {
+    pthread_mutex_unlock(&gpiosim_lock);
+    return 0;
+  }
+  gpiosim_state = -2;
+  if((fp = fopen(path, "r")) == NULL) {
+    printf("Error open GPIO_SIM trace %s\n", path);
+    pthread_mutex_unlock(&gpiosim_lock);
+    return -1;
+  }
+  while(fgets(line, sizeof(line), fp) != NULL && gpiosim_count < GPIOSIM_MAX) {
+    if(line[0] == '#') continue;
+    n = sscanf(line, "%lf %31s %d", &ms, pin, &level);
+    if(n < 2) continue;
+    gpiosim_trace[gpiosim_count].time = (long long) (ms * 1000000.0);
+    if(gpiosim_count > 0 && gpiosim_trace[gpiosim_count].time < gpiosim_trace[gpiosim_count - 1].time) {
+      printf("Error GPIO_SIM trace time goes backwards: %s", line);
+      fclose(fp);
+      gpiosim_count = 0;
+      pthread_mutex_unlock(&gpiosim_lock);
+      return -1;
+    }
+    if(strcasecmp(pin, "END") == 0) {
+      gpiosim_trace[gpiosim_count].pin = GPIOSIM_END;
+      gpiosim_trace[gpiosim_count].level = 0;
+    }
+    else {
+      if(n < 3 || gpiosim_pin(pin) < 0) {
+        printf("Error GPIO_SIM trace line: %s", line);
+        continue;
+      }
+      gpiosim_trace[gpiosim_count].pin = gpiosim_pin(pin);
+      gpiosim_trace[gpiosim_count].level = (level != 0);
+    }
+    gpiosim_count++;
+  }
+  fclose(fp);
+  gpiosim_state = 1;
+  pthread_mutex_unlock(&gpiosim_lock);
+  return 1;
+}
+
+/* ------------------------------------------------------------ *
+ * gpiosim_end() returns the END time of the trace in ns, or -1 *
+ * ------------------------------------------------------------ */
+long long gpiosim_end(void) {
+  int i;
+  for(i = 0; i < gpiosim_count; i++) {
+    if(gpiosim_trace[i].pin == GPIOSIM_END) return gpiosim_trace[i].time;
+  }
+  return -1;
+}
+
+/* ------------------------------------------------------------ *
+ * gpiosim_level() returns the scripted level of an input pin   *
+ * at time ns from the simulation start                         *
+ * ------------------------------------------------------------ */
+int gpiosim_level(int pin, long long time) {
+  int i, level = 1;
+  for(i = 0; i < gpiosim_count && gpiosim_trace[i].time <= time; i++) {
+    if(gpiosim_trace[i].pin == pin) level = gpiosim_trace[i].level;
+  }
+  return level;
+}
+
+/* ------------------------------------------------------------ *
+ * gpiosim_input() logs a replayed input change at its trace    *
+ * time, the reference for latency measurements.                *
+ * ------------------------------------------------------------ */
+void gpiosim_input(int pin, int level, long long time) {
+  if(gpiosim_logfile == NULL) return;
+  pthread_mutex_lock(&gpiosim_lock);
+  fprintf(gpiosim_logfile, "%lld in %d %d\n", time, pin, level);
+  fflush(gpiosim_logfile);
+  pthread_mutex_unlock(&gpiosim_lock);
+}
+
+/* ------------------------------------------------------------ *
+ * gpiosim_output() logs an output pin change, at the current   *
+ * time from the simulation start. Repeated levels are skipped. *
+ * ------------------------------------------------------------ */
+void gpiosim_output(int pin, int level) {
+  if(gpiosim_logfile == NULL || pin < 0 || pin > 63) return;
+  level = (level != 0);
+  pthread_mutex_lock(&gpiosim_lock);
+  if(gpiosim_out[pin] != level) {
+    gpiosim_out[pin] = level;
+    fprintf(gpiosim_logfile, "%lld out %d %d\n", gpiosim_clock() - gpiosim_start, pin, level);
+  }
+  pthread_mutex_unlock(&gpiosim_lock);
+}
@@ -0,0 +1,109 @@
+/* ------------------------------------------------------------ *
+ * file:        gpio-simlat.c                                   *
+ * purpose:     Reads a GPIO_SIM_LOG file and reports, for each *
+ *              replayed input change, the time until the next  *
+ *              output pin change: the input-to-output latency  *
+ *              of the program under test. An input without an  *
+ *              output change before the next input counts as   *
+ *              no output. The log is sorted by time once, then *
+ *              walked with forward indexes for the next input  *
+ *              and the next output change.                     *
+ *                                                              *
+ * requires:    a log written by gpio-sim.c                     *
+ *                                                              *
+ * example:     ./gpio-simlat -p 12 keys.log                    *
+ *                                                              *
+ * author:      10/17/2026 Frank4DD                             *
+ * ------------------------------------------------------------ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define MAXLINES 65536
+
+typedef struct {
+  long long time;
+  int in;                                  // 1 = input, 0 = output
+  int pin;
+  int level;
+  int seq;                                 // line number, keeps ties stable
+} logline;
+
+static logline lines[MAXLINES];
+
+/* ------------------------------------------------------------ *
+ * bytime() orders log lines by time, an input before an output *
+ * of the same time. Input lines carry the trace time and are   *
+ * written a bit later, so the file is only nearly sorted.      *
+ * ------------------------------------------------------------ */
+static int bytime(const void *a, const void *b) {
+  const logline *x = a, *y = b;
+  if(x->time != y->time) return (x->time < y->time) ? -1 : 1;
+  if(x->in != y->in) return y->in - x->in;
+  return x->seq - y->seq;
+}
+
+void usage() {
+  printf("Usage: gpio-simlat [-p pin] [-v] <logfile>\n");
+  printf("   -p   only count changes of this output pin (BCM)\n");
+  printf("   -v   print the latency of each input change\n");
+  exit(-1);
+}
+
+int main(int argc, char *argv[]) {
+  char dir[8];
+  int count = 0, pin = -1, verbose = 0;
+  int i, j = 0, k = 0, n = 0, missed = 0, opt;
+  long long best, end, min = 0, max = 0, sum = 0;
+  FILE *fp;
+
+  while((opt = getopt(argc, argv, "p:v")) != -1) {
+    if(opt == 'p') pin = atoi(optarg);
+    else if(opt == 'v') verbose = 1;
+    else usage();
+  }
+  if(optind >= argc) usage();
+  if((fp = fopen(argv[optind], "r")) == NULL) {
+    printf("Error open %s\n", argv[optind]);
+    exit(-1);
+  }
+  while(count < MAXLINES && fscanf(fp, "%lld %7s %d %d", &lines[count].time,
+        dir, &lines[count].pin, &lines[count].level) == 4) {
+    lines[count].in = (strcmp(dir, "in") == 0);
+    lines[count].seq = count;
+    count++;
+  }
+  fclose(fp);
+  qsort(lines, count, sizeof(logline), bytime);
+
+  /* ---------------------------------------------------------- *
+   * j: next counted output change, k: next later input. Both   *
+   * only move forward, one pass over the log.                  *
+   * ---------------------------------------------------------- */
+  for(i = 0; i < count; i++) {
+    if(!lines[i].in) continue;
+    if(k <= i) k = i + 1;
+    while(k < count && (!lines[k].in || lines[k].time <= lines[i].time)) k++;
+    end = (k < count) ? lines[k].time : -1;
+    if(j <= i) j = i + 1;
+    while(j < count && (lines[j].in || (pin != -1 && lines[j].pin != pin))) j++;
+    best = -1;
+    if(j < count && (end == -1 || lines[j].time < end)) best = lines[j].time - lines[i].time;
+    if(best == -1) {
+      missed++;
+      if(verbose) printf("in  %lld.%06lld ms pin %d=%d: no output\n", lines[i].time / 1000000,
+                         lines[i].time % 1000000, lines[i].pin, lines[i].level);
+      continue;
+    }
+    if(verbose) printf("in  %lld.%06lld ms pin %d=%d: %lld us\n", lines[i].time / 1000000,
+                       lines[i].time % 1000000, lines[i].pin, lines[i].level, best / 1000);
+    if(n == 0 || best < min) min = best;
+    if(n == 0 || best > max) max = best;
+    sum += best;
+    n++;
+  }
+  printf("inputs %d, with output %d, latency us min %lld avg %lld max %lld\n",
+         n + missed, n, min / 1000, n ? sum / n / 1000 : 0, max / 1000);
+  return 0;
+}
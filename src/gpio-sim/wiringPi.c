@@ -0,0 +1,82 @@
+/* ------------------------------------------------------------ *
+ * file:        wiringPi.c                                      *
+ * purpose:     Link time GPIO simulator: a libwiringPi.a that  *
+ *              drives no pins. digitalRead() returns the level *
+ *              from the GPIO_SIM trace at the current time,    *
+ *              digitalWrite() logs output changes to the       *
+ *              GPIO_SIM_LOG file. The program exits when the   *
+ *              trace END time has passed in delay().           *
+ *              Without GPIO_SIM, all inputs read high.         *
+ *                                                              *
+ * requires:    gpio-sim.c/.h                                   *
+ *                                                              *
+ * author:      10/17/2026 Frank4DD                             *
+ * ------------------------------------------------------------ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <errno.h>
+#include "wiringPi.h"
+#include "gpio-sim.h"
+
+static int wpi_bcm = 0;                    // 1 = pins are BCM numbers
+static long long wpi_end = -1;             // trace END in ns, -1 = none
+
+/* ------------------------------------------------------------ *
+ * wpi_pin() returns the BCM GPIO number of a program pin       *
+ * ------------------------------------------------------------ */
+static int wpi_pin(int pin) {
+  return wpi_bcm ? pin : gpiosim_wpi(pin);
+}
+
+int wiringPiSetup(void) {
+  if(gpiosim_open() == -1) return -1;
+  wpi_end = gpiosim_end();
+  return 0;
+}
+
+int wiringPiSetupGpio(void) {
+  wpi_bcm = 1;
+  return wiringPiSetup();
+}
+
+void pinMode(int pin, int mode) {
+}
+
+void pullUpDnControl(int pin, int pud) {
+}
+
+void digitalWrite(int pin, int value) {
+  gpiosim_output(wpi_pin(pin), value);
+}
+
+int digitalRead(int pin) {
+  return gpiosim_level(wpi_pin(pin), gpiosim_clock() - gpiosim_start);
+}
+
+/* ------------------------------------------------------------ *
+ * wpi_sleep() sleeps ns, and ends the program after trace END  *
+ * ------------------------------------------------------------ */
+static void wpi_sleep(long long ns) {
+  struct timespec ts;
+  ts.tv_sec = ns / 1000000000LL;
+  ts.tv_nsec = ns % 1000000000LL;
+  while(nanosleep(&ts, &ts) == -1 && errno == EINTR);
+  if(wpi_end != -1 && gpiosim_clock() - gpiosim_start >= wpi_end) exit(0);
+}
+
+void delay(unsigned int howLong) {
+  wpi_sleep(howLong * 1000000LL);
+}
+
+void delayMicroseconds(unsigned int howLong) {
+  wpi_sleep(howLong * 1000LL);
+}
+
+unsigned int millis(void) {
+  return (gpiosim_clock() - gpiosim_start) / 1000000LL;
+}
+
+unsigned int micros(void) {
+  return (gpiosim_clock() - gpiosim_start) / 1000LL;
+}
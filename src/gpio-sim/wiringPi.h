@@ -0,0 +1,43 @@
+/* ------------------------------------------------------------ *
+ * file:        wiringPi.h                                      *
+ * purpose:     Simulated subset of the WiringPi API, see       *
+ *              wiringPi.c. Programs build against it with      *
+ *              make SIM=1, which puts this directory first on  *
+ *              the include and library paths.                  *
+ *                                                              *
+ * author:      10/17/2026 Frank4DD                             *
+ * ------------------------------------------------------------ */
+#ifndef WIRINGPI_SIM_H
+#define WIRINGPI_SIM_H
+
+#define INPUT           0
+#define OUTPUT          1
+#define PWM_OUTPUT      2
+
+#define LOW             0
+#define HIGH            1
+
+#define PUD_OFF         0
+#define PUD_DOWN        1
+#define PUD_UP          2
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int wiringPiSetup(void);
+extern int wiringPiSetupGpio(void);
+extern void pinMode(int pin, int mode);
+extern void pullUpDnControl(int pin, int pud);
+extern void digitalWrite(int pin, int value);
+extern int digitalRead(int pin);
+extern void delay(unsigned int howLong);
+extern void delayMicroseconds(unsigned int howLong);
+extern unsigned int millis(void);
+extern unsigned int micros(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
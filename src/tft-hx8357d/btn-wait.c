@@ -0,0 +1,45 @@
+/* ------------------------------------------------------------ *
+ * file:        btn-wait.c                                      *
+ * purpose:     Waits for a push button press, for use in shell *
+ *              scripts. It sleeps on the button edge events,   *
+ *              and uses no CPU while waiting.                  *
+ *                                                              *
+ * return:      0 on button press, and -1 on errors.            *
+ *                                                              *
+ * requires:    buttons.c/.h                                    *
+ *                                                              *
+ * compile:     see Makefile                                    *
+ *                                                              *
+ * example:     ./btn-wait down && echo "down pressed"          *
+ *                                                              *
+ * author:      10/17/2026 Frank4DD                             *
+ * ------------------------------------------------------------ */
+#include <stdio.h>
+#include <strings.h>
+#include "buttons.h"
+
+int main(int argc, char *argv[]) {
+   btn_event ev;
+   int button = -1, i;
+
+   if(argc == 2) {
+      for(i = 0; i < BTN_COUNT; i++)
+         if(strcasecmp(argv[1], btn_name[i]) == 0) button = i;
+   }
+   if(button == -1) {
+      printf("Usage: ./btn-wait <up|mode|down|enter>\n");
+      return -1;
+   }
+   if(btn_open(BTN_DEBOUNCE) == -1) return -1;
+
+   while(btn_wait(-1) >= 0) {
+      while(btn_read(&ev) == 1) {
+         if(ev.button == button && ev.type == BTN_PRESS) {
+            btn_close();
+            return 0;
+         }
+      }
+   }
+   btn_close();
+   return -1;
+}
@@ -0,0 +1,462 @@
+/* ------------------------------------------------------------ *
+ * file:        buttons.c                                       *
+ * purpose:     PiCon One push buttons through the GPIO char    *
+ *              device (/dev/gpiochip0). Each button line is    *
+ *              requested for both edge events, the kernel then *
+ *              queues every press and release with a timestamp.*
+ *              A background thread debounces the edges, and    *
+ *              classifies them into press, release, long-press,*
+ *              auto-repeat and two-button chord events. Events *
+ *              go into a single-producer single-consumer ring, *
+ *              so no press is lost while the program renders   *
+ *              a slow frame or waits on a blocking call.       *
+ *              With GPIO_SIM=<trace> set, the thread replays   *
+ *              the trace edges at their exact times instead,   *
+ *              see gpio-sim.c.                                 *
+ *                                                              *
+ * requires:    Linux GPIO chardev (kernel 4.8+), -lpthread     *
+ *                                                              *
+ * author:      10/17/2026 Frank4DD                             *
+ * ------------------------------------------------------------ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/ioctl.h>
+#include <sys/eventfd.h>
+#include <linux/gpio.h>
+#include "buttons.h"
+#include "gpio-sim.h"
+
+const char *btn_name[BTN_COUNT] = { "UP", "MODE", "DOWN", "ENTER" };
+const char *btn_type[BTN_CHORD + 1] = { "", "press", "release", "long", "repeat", "chord" };
+unsigned long btn_overrun = 0;             // events dropped, ring full
+
+/* ------------------------------------------------------------ *
+ * Buttons are active low, BCM GPIO numbers = gpiochip0 offsets *
+ * ------------------------------------------------------------ */
+static const int btn_line[BTN_COUNT] = { 5, 6, 13, 19 };
+
+static int btn_fd[BTN_COUNT] = { -1, -1, -1, -1 };
+static atomic_int btn_pressed[BTN_COUNT];  // debounced state
+static long long btn_last[BTN_COUNT];      // last accepted edge in ns
+static int btn_dropped[BTN_COUNT];         // edges dropped as bounce
+static long long btn_down[BTN_COUNT];      // press time in ns
+static long long btn_next[BTN_COUNT];      // next long/repeat time
+static int btn_chorded[BTN_COUNT];         // part of a chord
+static long long btn_debounce;             // debounce time in ns
+static long long btn_offset;               // kernel to MONOTONIC ns
+static int btn_sim = 0;                    // 1 = replay GPIO_SIM trace
+static long long btn_simfrom;              // trace time of btn_open()
+
+/* ------------------------------------------------------------ *
+ * Event ring: the thread writes at head, the program reads at  *
+ * tail. Each side only stores its own index, so the ring needs *
+ * no lock. efd wakes a program that polls for events.          *
+ * ------------------------------------------------------------ */
+static btn_event btn_ring[BTN_RING];
+static atomic_uint btn_head;
+static atomic_uint btn_tail;
+static int btn_efd = -1;
+static int btn_stopfd = -1;                // wakes the thread to exit
+static pthread_t btn_tid;
+static int btn_running = 0;
+
+static long long btn_clock(clockid_t clock) {
+  struct timespec ts;
+  clock_gettime(clock, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* ------------------------------------------------------------ *
+ * btn_push() queues an event, called by the thread only        *
+ * ------------------------------------------------------------ */
+static void btn_push(int type, int button, int button2, long long t) {
+  unsigned int head = atomic_load_explicit(&btn_head, memory_order_relaxed);
+  unsigned int tail = atomic_load_explicit(&btn_tail, memory_order_acquire);
+  uint64_t one = 1;
+
+  if(head - tail >= BTN_RING) {
+    btn_overrun++;
+    return;
+  }
+  btn_ring[head & (BTN_RING - 1)].type = type;
+  btn_ring[head & (BTN_RING - 1)].button = button;
+  btn_ring[head & (BTN_RING - 1)].button2 = button2;
+  btn_ring[head & (BTN_RING - 1)].time = t;
+  atomic_store_explicit(&btn_head, head + 1, memory_order_release);
+  if(write(btn_efd, &one, sizeof(one)) != sizeof(one)) btn_overrun++;
+}
+
+/* ------------------------------------------------------------ *
+ * btn_pop() takes the oldest event, called by the program only *
+ * ------------------------------------------------------------ */
+static int btn_pop(btn_event *ev) {
+  unsigned int tail = atomic_load_explicit(&btn_tail, memory_order_relaxed);
+  unsigned int head = atomic_load_explicit(&btn_head, memory_order_acquire);
+
+  if(tail == head) return 0;
+  *ev = btn_ring[tail & (BTN_RING - 1)];
+  atomic_store_explicit(&btn_tail, tail + 1, memory_order_release);
+  return 1;
+}
+
+/* ------------------------------------------------------------ *
+ * btn_change() classifies a debounced state change: press and  *
+ * release, and a chord if another button went down less than   *
+ * BTN_CHORDTIME ms before this one.                            *
+ * ------------------------------------------------------------ */
+static void btn_change(int i, int pressed, long long t) {
+  int j;
+
+  btn_last[i] = t;
+  atomic_store(&btn_pressed[i], pressed);
+  if(!pressed) {
+    btn_chorded[i] = 0;
+    btn_push(BTN_RELEASE, i, -1, t);
+    return;
+  }
+  btn_down[i] = t;
+  btn_next[i] = t + BTN_LONGPRESS * 1000000LL;
+  btn_chorded[i] = 0;
+  btn_push(BTN_PRESS, i, -1, t);
+
+  for(j = 0; j < BTN_COUNT; j++) {
+    if(j == i || !atomic_load(&btn_pressed[j]) || btn_chorded[j]) continue;
+    if(t - btn_down[j] > BTN_CHORDTIME * 1000000LL) continue;
+    btn_chorded[i] = btn_chorded[j] = 1;  // no long-press for chords
+    btn_push(BTN_CHORD, j, i, t);
+    break;
+  }
+}
+
+/* ------------------------------------------------------------ *
+ * btn_edge() debounces one edge of button i at time t          *
+ * ------------------------------------------------------------ */
+static void btn_edge(int i, int pressed, long long t) {
+  // bounce: too close to the last edge, or no state change
+  if(t - btn_last[i] < btn_debounce) {
+    btn_dropped[i] = 1;
+    return;
+  }
+  if(pressed == atomic_load(&btn_pressed[i])) return;
+  btn_change(i, pressed, t);
+}
+
+/* ------------------------------------------------------------ *
+ * btn_level() returns the line level of button i, 0 = pressed, *
+ * or -1 on error                                               *
+ * ------------------------------------------------------------ */
+static int btn_level(int i, long long now) {
+  struct gpiohandle_data data;
+
+  if(btn_sim) return gpiosim_level(btn_line[i], now - gpiosim_start);
+  if(ioctl(btn_fd[i], GPIOHANDLE_GET_LINE_VALUES_IOCTL, &data) == -1) return -1;
+  return data.values[0];
+}
+
+/* ------------------------------------------------------------ *
+ * btn_edges() reads the kernel edge events of button i         *
+ * ------------------------------------------------------------ */
+static void btn_edges(int i, long long now) {
+  struct gpioevent_data data;
+  long long t;
+
+  while(read(btn_fd[i], &data, sizeof(data)) == sizeof(data)) {
+    /* -------------------------------------------------------- *
+     * Kernels before 5.7 stamp events with CLOCK_REALTIME,     *
+     * later ones with CLOCK_MONOTONIC. A stamp more than a day *
+     * off the monotonic clock is realtime, add the offset.     *
+     * -------------------------------------------------------- */
+    t = (long long) data.timestamp;
+    if(t - now > 86400000000000LL || now - t > 86400000000000LL) t += btn_offset;
+    btn_edge(i, data.id == GPIOEVENT_EVENT_FALLING_EDGE, t);
+  }
+}
+
+/* ------------------------------------------------------------ *
+ * btn_timers() handles the time based events at now: settling  *
+ * dropped edges, long-press and auto-repeat. Returns the next  *
+ * deadline in ns, or -1 if there is none.                      *
+ * ------------------------------------------------------------ */
+static long long btn_timers(long long now) {
+  long long next = -1, due;
+  int i, level;
+
+  for(i = 0; i < BTN_COUNT; i++) {
+    /* -------------------------------------------------------- *
+     * A press shorter than debounce can drop its release edge, *
+     * the line level then tells the settled state.             *
+     * -------------------------------------------------------- */
+    if(btn_dropped[i]) {
+      due = btn_last[i] + btn_debounce;
+      if(now >= due) {
+        btn_dropped[i] = 0;
+        level = btn_level(i, now);
+        if(level != -1 && (level == 0) != atomic_load(&btn_pressed[i]))
+          btn_change(i, level == 0, now);
+      }
+      else if(next == -1 || due < next) next = due;
+    }
+    if(!atomic_load(&btn_pressed[i]) || btn_chorded[i]) continue;
+
+    // held: long-press once, then auto-repeat on exact multiples
+    while(now >= btn_next[i]) {
+      if(btn_next[i] == btn_down[i] + BTN_LONGPRESS * 1000000LL)
+        btn_push(BTN_LONG, i, -1, btn_next[i]);
+      else btn_push(BTN_AUTOREPEAT, i, -1, btn_next[i]);
+      btn_next[i] += BTN_REPEAT * 1000000LL;
+    }
+    if(next == -1 || btn_next[i] < next) next = btn_next[i];
+  }
+  return next;
+}
+
+/* ------------------------------------------------------------ *
+ * btn_thread() waits for edges or the next deadline            *
+ * ------------------------------------------------------------ */
+static void *btn_thread(void *arg) {
+  struct pollfd fds[BTN_COUNT + 1];
+  long long now, next;
+  int i, timeout;
+
+  for(i = 0; i < BTN_COUNT; i++) {
+    fds[i].fd = btn_fd[i];
+    fds[i].events = POLLIN;
+  }
+  fds[BTN_COUNT].fd = btn_stopfd;
+  fds[BTN_COUNT].events = POLLIN;
+  next = -1;
+  while(1) {
+    timeout = -1;
+    if(next != -1) {
+      now = btn_clock(CLOCK_MONOTONIC);
+      timeout = (next > now) ? (next - now + 999999) / 1000000 : 0;
+    }
+    if(poll(fds, BTN_COUNT + 1, timeout) == -1) continue;
+    if(fds[BTN_COUNT].revents & POLLIN) break;     // btn_close()
+    now = btn_clock(CLOCK_MONOTONIC);
+    for(i = 0; i < BTN_COUNT; i++) {
+      if(fds[i].revents & POLLIN) btn_edges(i, now);
+    }
+    next = btn_timers(now);
+  }
+  return NULL;
+}
+
+/* ------------------------------------------------------------ *
+ * btn_sleep() waits until the MONOTONIC time due in ns, or for *
+ * ever with due -1. Returns 1 if btn_close() stops the thread. *
+ * poll() wakes up to 1 ms early, clock_nanosleep() the rest.   *
+ * ------------------------------------------------------------ */
+static int btn_sleep(long long due) {
+  struct pollfd fds[1];
+  struct timespec ts;
+  long long now;
+  int timeout = -1;
+
+  fds[0].fd = btn_stopfd;
+  fds[0].events = POLLIN;
+  if(due != -1) {
+    now = btn_clock(CLOCK_MONOTONIC);
+    timeout = (due > now) ? (due - now) / 1000000 : 0;
+  }
+  if(poll(fds, 1, timeout) > 0) return 1;
+  if(due == -1) return 0;
+  ts.tv_sec = due / 1000000000LL;
+  ts.tv_nsec = due % 1000000000LL;
+  while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR);
+  return 0;
+}
+
+/* ------------------------------------------------------------ *
+ * btn_simthread() replays the GPIO_SIM trace. Edges and timers *
+ * run at their exact trace times, not at the wakeup time, so a *
+ * trace always gives the same events. END sends SIGINT. After  *
+ * a reopen, lines up to the open time are already in the state *
+ * and are not replayed again.                                  *
+ * ------------------------------------------------------------ */
+static void *btn_simthread(void *arg) {
+  long long next = -1, due, edge;
+  int k = 0, i = 0, pin = 0;
+
+  while(k < gpiosim_count && gpiosim_trace[k].time <= btn_simfrom) k++;
+  while(1) {
+    // next trace line for a button line, or END
+    edge = -1;
+    for(; k < gpiosim_count; k++) {
+      pin = gpiosim_trace[k].pin;
+      for(i = 0; i < BTN_COUNT && btn_line[i] != pin; i++);
+      if(i < BTN_COUNT || pin == GPIOSIM_END) {
+        edge = gpiosim_start + gpiosim_trace[k].time;
+        break;
+      }
+    }
+    due = edge;
+    if(next != -1 && (due == -1 || next < due)) due = next;
+    if(btn_sleep(due)) break;              // btn_close()
+    if(due == -1) continue;                // trace done, nothing pending
+
+    if(due == edge) {
+      if(pin == GPIOSIM_END) {
+        kill(getpid(), SIGINT);
+        k = gpiosim_count;
+      }
+      else {
+        gpiosim_input(pin, gpiosim_trace[k].level, gpiosim_trace[k].time);
+        btn_edge(i, gpiosim_trace[k].level == 0, due);
+        k++;
+      }
+    }
+    next = btn_timers(due);
+  }
+  return NULL;
+}
+
+/* ------------------------------------------------------------ *
+ * btn_request() requests the button lines for edge events      *
+ * ------------------------------------------------------------ */
+static int btn_request(void) {
+  struct gpioevent_request req;
+  struct gpiohandle_data data;
+  const char *chip = getenv("BTN_GPIOCHIP");
+  int fd, i;
+
+  if(chip == NULL) chip = BTN_CHIP;
+  if((fd = open(chip, O_RDONLY | O_CLOEXEC)) == -1) {
+    printf("Error open %s\n", chip);
+    return -1;
+  }
+  for(i = 0; i < BTN_COUNT; i++) {
+    memset(&req, 0, sizeof(req));
+    req.lineoffset = btn_line[i];
+    req.handleflags = GPIOHANDLE_REQUEST_INPUT;
+    req.eventflags = GPIOEVENT_REQUEST_BOTH_EDGES;
+    snprintf(req.consumer_label, sizeof(req.consumer_label), "picon-%s", btn_name[i]);
+    if(ioctl(fd, GPIO_GET_LINEEVENT_IOCTL, &req) == -1) {
+      printf("Error request GPIO %d for button %s\n", btn_line[i], btn_name[i]);
+      close(fd);
+      return -1;
+    }
+    btn_fd[i] = req.fd;
+    fcntl(btn_fd[i], F_SETFL, O_NONBLOCK);
+    if(ioctl(btn_fd[i], GPIOHANDLE_GET_LINE_VALUES_IOCTL, &data) == 0)
+      atomic_store(&btn_pressed[i], data.values[0] == 0);
+  }
+  close(fd);
+  return 0;
+}
+
+/* ------------------------------------------------------------ *
+ * btn_open() gets the button lines, from the GPIO chardev or   *
+ * the GPIO_SIM trace, and starts the thread. Edges closer than *
+ * debounce ms to the last accepted one are noise.              *
+ * ------------------------------------------------------------ */
+int btn_open(int debounce) {
+  int i;
+
+  if((btn_sim = gpiosim_open()) == -1) return -1;
+  if(btn_sim) {
+    btn_simfrom = gpiosim_clock() - gpiosim_start;
+    for(i = 0; i < BTN_COUNT; i++)
+      atomic_store(&btn_pressed[i], gpiosim_level(btn_line[i], btn_simfrom) == 0);
+  }
+  else if(btn_request() == -1) {
+    btn_close();
+    return -1;
+  }
+  for(i = 0; i < BTN_COUNT; i++) {
+    btn_last[i] = 0;
+    btn_dropped[i] = 0;
+    btn_chorded[i] = 1;                    // held at start, no long-press
+  }
+  btn_debounce = debounce * 1000000LL;
+  btn_offset = btn_clock(CLOCK_MONOTONIC) - btn_clock(CLOCK_REALTIME);
+
+  atomic_store(&btn_head, 0);
+  atomic_store(&btn_tail, 0);
+  if((btn_efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1
+     || (btn_stopfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1
+     || pthread_create(&btn_tid, NULL, btn_sim ? btn_simthread : btn_thread, NULL) != 0) {
+    btn_close();
+    return -1;
+  }
+  btn_running = 1;
+  return 0;
+}
+
+/* ------------------------------------------------------------ *
+ * btn_pollfds() fills a pollfd that is readable when events    *
+ * are queued, to wait on buttons in a program's own poll()     *
+ * loop. Call btn_read() until it returns 0 before polling.     *
+ * ------------------------------------------------------------ */
+int btn_pollfds(struct pollfd *fds) {
+  fds[0].fd = btn_efd;
+  fds[0].events = POLLIN;
+  fds[0].revents = 0;
+  return 1;
+}
+
+/* ------------------------------------------------------------ *
+ * btn_read() returns the oldest queued button event. Returns   *
+ * 1 with ev set, or 0 if no event is queued. Never blocks.     *
+ * ------------------------------------------------------------ */
+int btn_read(btn_event *ev) {
+  uint64_t count;
+
+  if(btn_pop(ev)) return 1;
+  // ring empty: clear the wakeup, then catch a push in between
+  if(read(btn_efd, &count, sizeof(count)) != sizeof(count)) return 0;
+  return btn_pop(ev);
+}
+
+/* ------------------------------------------------------------ *
+ * btn_wait() sleeps until a button event is queued, or timeout *
+ * ms passed (-1 = forever). Returns 1 on an event, 0 timeout.  *
+ * ------------------------------------------------------------ */
+int btn_wait(int timeout) {
+  struct pollfd fds[1];
+
+  if(atomic_load(&btn_head) != atomic_load(&btn_tail)) return 1;
+  btn_pollfds(fds);
+  return (poll(fds, 1, timeout) > 0);
+}
+
+/* ------------------------------------------------------------ *
+ * btn_state() returns the debounced state, 1 = pressed         *
+ * ------------------------------------------------------------ */
+int btn_state(int button) {
+  if(button < 0 || button >= BTN_COUNT) return 0;
+  return atomic_load(&btn_pressed[button]);
+}
+
+/* ------------------------------------------------------------ *
+ * btn_close() stops the thread and releases the button lines.  *
+ * Events still queued are discarded. The thread is woken by    *
+ * btn_stopfd and exits between edges, never cancelled inside   *
+ * gpiosim_input() while it holds the simulator lock.           *
+ * ------------------------------------------------------------ */
+void btn_close(void) {
+  uint64_t one = 1;
+  int i;
+  if(btn_running) {
+    if(write(btn_stopfd, &one, sizeof(one)) != sizeof(one)) return;
+    pthread_join(btn_tid, NULL);
+    btn_running = 0;
+  }
+  for(i = 0; i < BTN_COUNT; i++) {
+    if(btn_fd[i] != -1) close(btn_fd[i]);
+    btn_fd[i] = -1;
+  }
+  if(btn_efd != -1) close(btn_efd);
+  btn_efd = -1;
+  if(btn_stopfd != -1) close(btn_stopfd);
+  btn_stopfd = -1;
+}
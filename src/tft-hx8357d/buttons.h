@@ -0,0 +1,51 @@
+/* ------------------------------------------------------------ *
+ * file:        buttons.h                                       *
+ * purpose:     PiCon One push buttons through the GPIO char    *
+ *              device. A background thread turns the kernel    *
+ *              edge events into timestamped button events, and *
+ *              queues them in a lock-free ring for the program. *
+ *                                                              *
+ * author:      10/17/2026 Frank4DD                             *
+ * ------------------------------------------------------------ */
+#ifndef BUTTONS_H
+#define BUTTONS_H
+
+#include <poll.h>
+
+#define BTN_CHIP        "/dev/gpiochip0" // BTN_GPIOCHIP=<path> overrides
+#define BTN_DEBOUNCE    20               // default debounce in ms
+#define BTN_LONGPRESS   800              // held this long = BTN_LONG
+#define BTN_REPEAT      150              // then BTN_AUTOREPEAT each ms
+#define BTN_CHORDTIME   100              // max ms between chord presses
+#define BTN_RING        64               // queued events, power of 2
+#define BTN_COUNT       4
+
+#define BTN_UP          0                // SW1, BCM GPIO 5
+#define BTN_MODE        1                // SW2, BCM GPIO 6
+#define BTN_DOWN        2                // SW3, BCM GPIO 13
+#define BTN_ENTER       3                // SW4, BCM GPIO 19
+
+#define BTN_PRESS       1                // button went down
+#define BTN_RELEASE     2                // button went up
+#define BTN_LONG        3                // held for BTN_LONGPRESS ms
+#define BTN_AUTOREPEAT  4                // still held, every BTN_REPEAT ms
+#define BTN_CHORD       5                // button2 pressed while button held
+
+typedef struct {
+  int type;                              // BTN_PRESS .. BTN_CHORD
+  int button;                            // BTN_UP .. BTN_ENTER
+  int button2;                           // BTN_CHORD: second button
+  long long time;                        // event time, CLOCK_MONOTONIC ns
+} btn_event;
+
+extern const char *btn_name[BTN_COUNT];
+extern const char *btn_type[BTN_CHORD + 1];
+extern unsigned long btn_overrun;
+extern int btn_open(int debounce);
+extern int btn_pollfds(struct pollfd *fds);
+extern int btn_read(btn_event *ev);
+extern int btn_wait(int timeout);
+extern int btn_state(int button);
+extern void btn_close(void);
+
+#endif
@@ -1,2 +1,3 @@
 #!/bin/bash
-while(true); do DOWN=$(gpio read 23); if [ $DOWN -eq "0" ]; then echo "down pressed"; sudo killall -s INT gpsmon; exit; fi; done
+# btn-wait sleeps on the DOWN button edge event, no polling
+/home/pi/picon-one-sw/src/tft-hx8357d/btn-wait down && echo "down pressed" && sudo killall -s INT gpsmon
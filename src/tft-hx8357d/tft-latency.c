@@ -0,0 +1,218 @@
+/* ------------------------------------------------------------ *
+ * file:        tft-latency.c                                   *
+ * purpose:     Button-to-photon latency instrumentation. The   *
+ *              button edge time comes from buttons.c, sw_detect*
+ *              calls lat_input() when the app consumes a press,*
+ *              End() calls lat_drawn() before and lat_swapped()*
+ *              after eglSwapBuffers(). Inputs consumed before  *
+ *              a frame complete with that frame. Each stage    *
+ *              goes into a log-linear histogram, 8 buckets per *
+ *              power of two (12% resolution), max is exact.    *
+ *                                                              *
+ *              With TFT_LATENCY=<path> set, the p50/p99/max    *
+ *              report and the total histogram are written to   *
+ *              <path>.<program> at most once per second and at *
+ *              exit, so apps started by tft-startmenu keep own *
+ *              files. If path is a Unix datagram socket, the   *
+ *              report is sent there instead.                   *
+ *                                                              *
+ * author:      10/17/2026 Frank4DD                             *
+ * ------------------------------------------------------------ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "tft-latency.h"
+
+static const char *lat_name[LAT_STAGES] = { "consume", "draw", "swap", "total" };
+static lat_hist lat[LAT_STAGES];
+
+static struct {
+   long long edge;                       // GPIO edge, CLOCK_MONOTONIC ns
+   long long consumed;                   // sw_detect() took it
+   long long drawn;                      // End() called, 0 = not yet
+} lat_pend[LAT_PENDING];
+static int lat_npend = 0;
+static long long lat_last = 0;           // last export time
+static int lat_init = 0;
+
+static long long lat_clock(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* ------------------------------------------------------------ *
+ * lat_bucket() returns the histogram bucket of ns, bucket b    *
+ * covers [lat_lower(b), lat_lower(b+1)) microseconds           *
+ * ------------------------------------------------------------ */
+static int lat_bucket(long long ns) {
+   unsigned long long us = (ns > 0) ? ns / 1000 : 0;
+   int octave = 0;
+
+   if(us < LAT_SUB) return us;
+   while((us >> octave) >= 2 * LAT_SUB) octave++;
+   if(octave + 1 >= LAT_BUCKETS / LAT_SUB) return LAT_BUCKETS - 1;
+   return (octave + 1) * LAT_SUB + (us >> octave) - LAT_SUB;
+}
+
+static long long lat_lower(int b) {
+   if(b < LAT_SUB) return b;
+   return (long long) (LAT_SUB + b % LAT_SUB) << (b / LAT_SUB - 1);
+}
+
+static void lat_add(lat_hist *h, long long ns) {
+   h->bucket[lat_bucket(ns)]++;
+   h->count++;
+   if(ns > h->max) h->max = ns;
+}
+
+/* ------------------------------------------------------------ *
+ * lat_percentile() returns the upper bound of the bucket that  *
+ * holds percentile p (0..100) in ns, capped at the exact max.  *
+ * ------------------------------------------------------------ */
+long long lat_percentile(const lat_hist *h, double p) {
+   unsigned long rank, sum = 0;
+   long long ns;
+   int b;
+
+   if(h->count == 0) return 0;
+   rank = (unsigned long) (h->count * p / 100.0 + 0.5);
+   if(rank < 1) rank = 1;
+   for(b = 0; b < LAT_BUCKETS; b++) {
+      sum += h->bucket[b];
+      if(sum >= rank) break;
+   }
+   ns = (b + 1 < LAT_BUCKETS) ? lat_lower(b + 1) * 1000 : h->max;
+   return (ns < h->max) ? ns : h->max;
+}
+
+static void lat_atexit(void) {
+   lat_export();
+}
+
+/* ------------------------------------------------------------ *
+ * lat_input() records a consumed press with its edge time      *
+ * ------------------------------------------------------------ */
+void lat_input(long long edge) {
+   if(!lat_init) {
+      lat_init = 1;
+      if(getenv(LAT_ENV) != NULL) atexit(lat_atexit);
+   }
+   if(lat_npend >= LAT_PENDING) return;  // no frame for a while
+   lat_pend[lat_npend].edge = edge;
+   lat_pend[lat_npend].consumed = lat_clock();
+   lat_pend[lat_npend].drawn = 0;
+   lat_npend++;
+}
+
+/* ------------------------------------------------------------ *
+ * lat_discard() drops the pending inputs, e.g. before the app  *
+ * runs another program, their frame would count its run time.  *
+ * ------------------------------------------------------------ */
+void lat_discard(void) {
+   lat_npend = 0;
+}
+
+/* ------------------------------------------------------------ *
+ * lat_drawn() marks the end of drawing, End() before the swap  *
+ * ------------------------------------------------------------ */
+void lat_drawn(void) {
+   long long now;
+   int i;
+
+   if(lat_npend == 0) return;
+   now = lat_clock();
+   for(i = 0; i < lat_npend; i++) {
+      if(lat_pend[i].drawn == 0) lat_pend[i].drawn = now;
+   }
+}
+
+/* ------------------------------------------------------------ *
+ * lat_swapped() completes the inputs shown by this frame       *
+ * ------------------------------------------------------------ */
+void lat_swapped(void) {
+   long long now;
+   int i, n = 0;
+
+   if(lat_npend == 0) return;
+   now = lat_clock();
+   for(i = 0; i < lat_npend; i++) {
+      if(lat_pend[i].drawn == 0) {       // consumed during the swap
+         lat_pend[n++] = lat_pend[i];
+         continue;
+      }
+      lat_add(&lat[LAT_CONSUME], lat_pend[i].consumed - lat_pend[i].edge);
+      lat_add(&lat[LAT_DRAW], lat_pend[i].drawn - lat_pend[i].consumed);
+      lat_add(&lat[LAT_SWAP], now - lat_pend[i].drawn);
+      lat_add(&lat[LAT_TOTAL], now - lat_pend[i].edge);
+   }
+   lat_npend = n;
+   if(getenv(LAT_ENV) != NULL && now - lat_last >= LAT_EXPORT * 1000000LL) {
+      lat_last = now;
+      lat_export();
+   }
+}
+
+/* ------------------------------------------------------------ *
+ * lat_report() prints p50/p99/max per stage in microseconds,   *
+ * and the non-empty buckets of the total histogram             *
+ * ------------------------------------------------------------ */
+void lat_report(FILE *fp) {
+   int s, b;
+
+   fprintf(fp, "# %s button-to-photon latency, %lu inputs\n",
+           program_invocation_short_name, lat[LAT_TOTAL].count);
+   fprintf(fp, "stage        p50us    p99us    maxus\n");
+   for(s = 0; s < LAT_STAGES; s++) {
+      fprintf(fp, "%-8s %8lld %8lld %8lld\n", lat_name[s],
+              lat_percentile(&lat[s], 50) / 1000, lat_percentile(&lat[s], 99) / 1000,
+              lat[s].max / 1000);
+   }
+   fprintf(fp, "# total histogram: from_us count\n");
+   for(b = 0; b < LAT_BUCKETS; b++) {
+      if(lat[LAT_TOTAL].bucket[b] > 0)
+         fprintf(fp, "%lld %lu\n", lat_lower(b), lat[LAT_TOTAL].bucket[b]);
+   }
+}
+
+/* ------------------------------------------------------------ *
+ * lat_export() writes the report to the TFT_LATENCY target,    *
+ * a socket, or the file with the program name appended         *
+ * ------------------------------------------------------------ */
+void lat_export(void) {
+   const char *path = getenv(LAT_ENV);
+   struct sockaddr_un addr;
+   struct stat st;
+   char file[256];
+   char *buf = NULL;
+   size_t len = 0;
+   FILE *fp;
+   int fd;
+
+   if(path == NULL) return;
+   if(stat(path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+      if((fp = open_memstream(&buf, &len)) == NULL) return;
+      lat_report(fp);
+      fclose(fp);
+      if((fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0)) != -1) {
+         memset(&addr, 0, sizeof(addr));
+         addr.sun_family = AF_UNIX;
+         strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+         sendto(fd, buf, len, MSG_DONTWAIT, (struct sockaddr *) &addr, sizeof(addr));
+         close(fd);
+      }
+      free(buf);
+      return;
+   }
+   snprintf(file, sizeof(file), "%s.%s", path, program_invocation_short_name);
+   if((fp = fopen(file, "w")) == NULL) return;
+   lat_report(fp);
+   fclose(fp);
+}
@@ -0,0 +1,39 @@
+/* ------------------------------------------------------------ *
+ * file:        tft-latency.h                                   *
+ * purpose:     Button-to-photon latency of the TFT apps. Each  *
+ *              button press is timed from the GPIO edge to the *
+ *              app consuming it, to the end of drawing, and to *
+ *              the return of eglSwapBuffers().                 *
+ *                                                              *
+ * author:      10/17/2026 Frank4DD                             *
+ * ------------------------------------------------------------ */
+#ifndef TFT_LATENCY_H
+#define TFT_LATENCY_H
+
+#define LAT_ENV        "TFT_LATENCY"    // env: report file prefix or socket
+#define LAT_PENDING    16               // inputs waiting for a frame
+#define LAT_SUB        8                // histogram buckets per octave
+#define LAT_BUCKETS    (32 * LAT_SUB)   // covers 1us .. 4000s
+#define LAT_EXPORT     1000             // min ms between report exports
+
+#define LAT_CONSUME    0                // edge -> app consumed the press
+#define LAT_DRAW       1                // consumed -> drawing done
+#define LAT_SWAP       2                // drawing done -> swap returned
+#define LAT_TOTAL      3                // edge -> swap returned
+#define LAT_STAGES     4
+
+typedef struct {
+   unsigned long count;
+   unsigned long bucket[LAT_BUCKETS];
+   long long max;                        // ns
+} lat_hist;
+
+void lat_input(long long edge);
+void lat_discard(void);
+void lat_drawn(void);
+void lat_swapped(void);
+long long lat_percentile(const lat_hist *h, double p);
+void lat_report(FILE *fp);
+void lat_export(void);
+
+#endif
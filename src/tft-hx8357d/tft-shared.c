@@ -12,16 +12,12 @@
 #include <VG/openvg.h>
 #include <VG/vgu.h>
 #include <stdbool.h>
-#include <wiringPi.h>
+#include "buttons.h"
+#include "tft-latency.h"
 #include "fontinfo.h"
 #include "shapes.h"
 #include "ip.h"
 
-#define SW1_UP		21
-#define SW2_MODE	22
-#define SW3_DOWN	23
-#define SW4_ENTER	24
-
 #define RPILOGO         "/home/pi/picon-one-sw/src/tft-hx8357d/images/rpi-logo64.jpg"
 
 extern bool detect_up;
@@ -143,40 +139,29 @@ void tftbottom(const char *addr, const char *mask){
 }
 
 /* --------------------------------------------------------- *
- * sw_detect: detects button press and set button flag       *
+ * sw_detect: takes the next button press from the event     *
+ * queue, sets its button flag, and returns the button 1..4. *
+ * Auto-repeat of a held button counts as another press. One *
+ * press per call: presses during a slow frame stay queued   *
+ * for the next ones. Returns 0 if no press is queued, and   *
+ * never blocks. Needs btn_open() at program start. Each     *
+ * press starts a latency sample, see tft-latency.c.         *
  * --------------------------------------------------------- */
 uint8_t sw_detect() {
-   /* ----------------------------------------------------- *
-    * Check button press UP                                 *
-    * ----------------------------------------------------- */
-   if((digitalRead(SW1_UP) == LOW) && (detect_up == FALSE)) {
-      detect_up = TRUE;
-      snprintf(statestr, sizeof(statestr), "UP");
-      return 1;
-   }
-   /* ----------------------------------------------------- *
-    * Check button press MODE                               *
-    * ----------------------------------------------------- */
-   if((digitalRead(SW2_MODE) == LOW) && (detect_mode == FALSE)) {
-      detect_mode = TRUE;
-      snprintf(statestr, sizeof(statestr), "MODE");
-      return 2;
-   }
-   /* ----------------------------------------------------- *
-    * Check button press DOWN                               *
-    * ----------------------------------------------------- */
-   if((digitalRead(SW3_DOWN) == LOW) && (detect_down == FALSE)) {
-      detect_down = TRUE;
-      snprintf(statestr, sizeof(statestr), "DOWN");
-      return 3;
-   }
-   /* ----------------------------------------------------- *
-    * Check button press ENTER                              *
-    * ----------------------------------------------------- */
-   if((digitalRead(SW4_ENTER) == LOW) && (detect_enter == FALSE)) {
-      detect_enter = TRUE;
-      snprintf(statestr, sizeof(statestr), "ENTER %d", prgsel);
-      return 4;
+   btn_event ev;
+
+   while(btn_read(&ev) == 1) {
+      if(ev.type != BTN_PRESS && ev.type != BTN_AUTOREPEAT) continue;
+      lat_input(ev.time);                // edge to photon timing
+      switch(ev.button) {
+         case BTN_UP:    detect_up = TRUE;    break;
+         case BTN_MODE:  detect_mode = TRUE;  break;
+         case BTN_DOWN:  detect_down = TRUE;  break;
+         case BTN_ENTER: detect_enter = TRUE; break;
+      }
+      if(ev.button == BTN_ENTER) snprintf(statestr, sizeof(statestr), "ENTER %d", prgsel);
+      else snprintf(statestr, sizeof(statestr), "%s", btn_name[ev.button]);
+      return ev.button + 1;
    }
    return 0;
 }
@@ -19,11 +19,11 @@
 #include <VG/openvg.h>
 #include <VG/vgu.h>
 #include <stdbool.h>
-#include <wiringPi.h>
 #include "fontinfo.h"
 #include "shapes.h"
 #include "ip.h"
 #include "tft-shared.h"
+#include "tft-latency.h"
 
 int main() {
    int width, height;
@@ -45,13 +45,9 @@ int main() {
    //sleep.tv_nsec = 500000000;            // to 0.5 seconds
 
    /* --------------------------------------------------------- *
-    * Setup GPIO pins for button control                        *
+    * Setup button edge events                                  *
     * --------------------------------------------------------- */
-   wiringPiSetup ();
-   pinMode (SW1_UP,    INPUT);  // SW1 Up
-   pinMode (SW2_MODE,  INPUT);  // SW2 Mode
-   pinMode (SW3_DOWN,  INPUT);  // SW3 Down
-   pinMode (SW4_ENTER, INPUT);  // SW4 Enter
+   if(btn_open(BTN_DEBOUNCE) == -1) exit(-1);
 
    /* --------------------------------------------------------- *
     * Setup display control. Get IP and Netmask.                *
@@ -64,12 +60,15 @@ int main() {
    while(1) {
       Background(0, 0, 0);                 // set background black
       tftheader();
+      /* ----------------------------------------------------- *
+       * Button presses are queued by the kernel, take them on *
+       * every pass. The key name stays up for swi_interval ms *
+       * ----------------------------------------------------- */
+      swstate = sw_detect();
       ms_elapsed = time_elapsed(refts);
-      if(ms_elapsed >= swi_interval) {
+      if(swstate > 0 || ms_elapsed >= swi_interval) {
 
-         if(statestr[0] != 'W') snprintf(statestr, sizeof(statestr), "WAIT-4-KEY");
-         if(swstate>0) swstate = 0;
-         swstate = sw_detect();
+         if(swstate == 0 && statestr[0] != 'W') snprintf(statestr, sizeof(statestr), "WAIT-4-KEY");
          if(detect_down == TRUE) {
             if(prgsel < 5) prgsel++;
             else prgsel = 0;
@@ -84,6 +83,10 @@ int main() {
 
          if(detect_enter == TRUE) {
             detect_enter = FALSE;
+            if(prgsel >= 1 && prgsel <= 4) {
+               btn_close();                 // hand the buttons over
+               lat_discard();               // the press is not drawn here
+            }
             switch(prgsel) {
                case 0: break; // select 0 frame
                case 1: system("/home/pi/picon-one-sw/src/tft-hx8357d/tft-stopwatch");
@@ -102,6 +105,10 @@ int main() {
                        system("/usr/bin/sudo /home/pi/picon-one-sw/src/tft-hx8357d/system_shutdown.sh &");
                        exit(0); // select 5 frame
             }
+            if(prgsel >= 1 && prgsel <= 4) {
+               btn_open(BTN_DEBOUNCE);
+               lat_discard();
+            }
          }
          //if(detect_enter == TRUE) detect_enter = FALSE;
          //printf("Debug: %d ms prgsel %d\n", ms_elapsed, prgsel);
@@ -147,7 +154,7 @@ int main() {
       tftaction(swstate);
       tftbottom(addr, mask);
       End();                               // End the picture
-      nanosleep(&sleep, NULL);             // sleep 0.1 seconds
+      btn_wait(sleep.tv_sec * 1000);       // sleep, wake on button
    }
    finish();                               // Graphics cleanup
    exit(0);
@@ -17,7 +17,6 @@
 #include <VG/openvg.h>
 #include <VG/vgu.h>
 #include <stdbool.h>
-#include <wiringPi.h>
 #include "fontinfo.h"
 #include "shapes.h"
 #include "ip.h"
@@ -40,13 +39,9 @@ int main() {
    tp4.tv_nsec = 0;
 
    /* --------------------------------------------------------- *
-    * Setup GPIO pins for button control                        *
+    * Setup button edge events                                  *
     * --------------------------------------------------------- */
-   wiringPiSetup ();
-   pinMode (SW1_UP,    INPUT);  // SW1 Up
-   pinMode (SW2_MODE,  INPUT);  // SW2 Mode
-   pinMode (SW3_DOWN,  INPUT);  // SW3 Down
-   pinMode (SW4_ENTER, INPUT);  // SW4 Enter
+   if(btn_open(BTN_DEBOUNCE) == -1) exit(-1);
    bool runstate = FALSE;
    char statestr[12] = "Stop";
    char timestr[22] = "00:00:00.000";
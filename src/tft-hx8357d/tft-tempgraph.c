@@ -18,7 +18,6 @@
 #include <VG/openvg.h>
 #include <VG/vgu.h>
 #include "fontinfo.h"
-#include <wiringPi.h>
 #include "shapes.h"
 #include "ip.h"
 #include "tft-shared.h"
@@ -54,13 +53,9 @@ int main() {
    int xcount = 0;
 
    /* --------------------------------------------------------- *
-    * Setup GPIO pins for button control                        *
+    * Setup button edge events                                  *
     * --------------------------------------------------------- */
-   wiringPiSetup ();
-   pinMode (SW1_UP,    INPUT);  // SW1 Up
-   pinMode (SW2_MODE,  INPUT);  // SW2 Mode
-   pinMode (SW3_DOWN,  INPUT);  // SW3 Down
-   pinMode (SW4_ENTER, INPUT);  // SW4 Enter
+   if(btn_open(BTN_DEBOUNCE) == -1) exit(-1);
 
    /* --------------------------------------------------------- *
     * Setup display control. Get IP and Netmask.                *
@@ -83,7 +78,8 @@ int main() {
       /* ----------------------------------------------------- *
        * Check button press DOWN for program exit              *
        * ----------------------------------------------------- */
-      if(digitalRead(SW3_DOWN) == LOW) {
+      sw_detect();
+      if(detect_down == TRUE) {
          exit(0);
       }
      /* ------------------------------------------------------ *
@@ -166,7 +162,7 @@ int main() {
 
       tftbottom(addr, mask);
       End();                                    // End the picture
-      nanosleep(&sleep, NULL);                  // sleep 0.5 seconds
+      btn_wait(sleep.tv_sec * 1000);            // sleep, wake on button
    }
       
    finish();					// Graphics cleanup
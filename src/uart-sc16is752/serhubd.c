@@ -0,0 +1,667 @@
+/* ------------------------------------------------------------ *
+ * file:        serhubd.c                                       *
+ * purpose:     Serial hub daemon. It owns the SC16IS752 ports  *
+ *              and shares them with several local programs.    *
+ *              Each port gets a Unix stream socket, e.g.       *
+ *              /run/serhub/ttySC1.sock, and with -p also a pty *
+ *              linked as /run/serhub/ttySC1.pty for tools that *
+ *              need a tty (xbee-term). Received data goes out  *
+ *              to all clients of the port. Client writes are   *
+ *              serialized, a chunk read from one client goes   *
+ *              to the port in one piece. One epoll loop serves *
+ *              all ports and clients, slow clients lose data   *
+ *              (counted) instead of stalling the others.       *
+ *              getserial() attaches to the hub automatically.  *
+ *              Command mode (e.g. XBee +++ and AT commands)    *
+ *              needs the port to itself: <name>.lock is a 2nd  *
+ *              socket per port, a client sends its lease in ms *
+ *              as uint32 and gets 'L' when it holds the lock,  *
+ *              'W' when another one waits. While held, only    *
+ *              the sockets of the lock holder's process are    *
+ *              read, the others (and the pty) wait. Closing    *
+ *              the lock socket or an expired lease releases    *
+ *              it to the next waiter. Not in scope: the hub    *
+ *              does not run the AT session itself, so each     *
+ *              program still pays its own +++ guard times.     *
+ *              SIGUSR1 prints the per-client statistics.       *
+ *                                                              *
+ * return:      0 on success, and -1 on errors.                 *
+ *                                                              *
+ * requires:    serial.c/.h                                     *
+ *                                                              *
+ * compile:     see Makefile                                    *
+ *                                                              *
+ * example:     sudo ./serhubd -p &                             *
+ *              ./xbee-ping                                     *
+ *              sudo pkill -USR1 serhubd                        *
+ *                                                              *
+ * author:      10/17/2026 Frank4DD                             *
+ * ------------------------------------------------------------ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include "serial.h"
+
+#define UART1         "/dev/ttySC0"
+#define UART2         "/dev/ttySC1"
+#define SPEED         115200
+#define HUB_MAXPORTS  4
+#define HUB_MAXCLIENT 32
+#define HUB_CLIENTBUF 16384     // port -> client queue, power of 2
+#define HUB_CHUNK     1024      // client -> port write unit
+#define HUB_PORT      0         // epoll tags: type << 16 | index
+#define HUB_LISTEN    1
+#define HUB_CLIENT    2
+#define HUB_LOCKLISTEN 3
+#define HUB_LOCK      4
+
+typedef struct {
+  const char *device;
+  const char *name;             // device basename
+  int fd;
+  int sock;                     // listening socket
+  int lsock;                    // lock listening socket
+  int ptyslave;                 // held open, pty stays usable
+  char sockpath[108];
+  char ptylink[108];
+  char lockpath[108];
+  int busy;                     // client with a partial write, -1
+  int owner;                    // lock holder slot, -1 = unlocked
+  pid_t ownerpid;               // its process, only it is read
+  unsigned int until;           // msec() when the lease expires
+  long long rxbytes, txbytes;
+} hub_port;
+
+typedef struct {
+  int fd;                       // -1 = slot free
+  int port;
+  int pty;                      // 1 = pty master, never closes
+  unsigned char out[HUB_CLIENTBUF];
+  unsigned int head, tail;      // free-running ring counters
+  unsigned char in[HUB_CHUNK];
+  int inoff, inlen;             // rest of a partial port write
+  long long rxbytes;            // port data delivered to client
+  long long txbytes;            // client data sent to the port
+  long long dropped;            // port data lost, client too slow
+  unsigned int since;           // msec() at connect
+  int id;
+  pid_t pid;                    // peer process, 0 for the pty
+  int hup;                      // peer closed while port locked
+  int parked;                   // 1 = removed from epoll
+} hub_client;
+
+typedef struct {
+  int fd;                       // -1 = slot free
+  int port;
+  pid_t pid;
+  unsigned int lease;           // ms, 0 = not requested yet
+  int seq;                      // request order, first one wins
+  unsigned char msg[4];         // partial lease message
+  int msglen;
+} hub_lock;
+
+hub_port ports[HUB_MAXPORTS];
+hub_client clients[HUB_MAXCLIENT];
+hub_lock locks[HUB_MAXCLIENT];
+int nports = 0;
+int epfd;
+int nextid = 1;
+int nextseq = 1;
+volatile sig_atomic_t running = 1;      // cleared by SIGINT/SIGTERM
+volatile sig_atomic_t stats = 0;        // set by SIGUSR1
+
+void Handler(int signo) {
+  if(signo == SIGUSR1) stats = 1;
+  else running = 0;
+}
+
+/* ------------------------------------------------------------ *
+ * watch() adds or updates the epoll events of fd               *
+ * ------------------------------------------------------------ */
+static void watch(int fd, unsigned int events, int type, int index, int add) {
+  struct epoll_event ev;
+  ev.events = events;
+  ev.data.u32 = type << 16 | index;
+  epoll_ctl(epfd, add ? EPOLL_CTL_ADD : EPOLL_CTL_MOD, fd, &ev);
+}
+
+/* ------------------------------------------------------------ *
+ * peerpid() returns the process on the other end of a socket   *
+ * ------------------------------------------------------------ */
+static pid_t peerpid(int fd) {
+  struct ucred cred;
+  socklen_t len = sizeof(cred);
+  if(getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) == -1) return 0;
+  return cred.pid;
+}
+
+/* ------------------------------------------------------------ *
+ * held() returns 1 if another process holds the client's port  *
+ * ------------------------------------------------------------ */
+static int held(hub_client *c) {
+  hub_port *p = &ports[c->port];
+  return p->owner != -1 && (c->pty || c->pid != p->ownerpid);
+}
+
+/* ------------------------------------------------------------ *
+ * clientwatch() reads from a client only while its port has no *
+ * partial write pending and no other process holds the lock,   *
+ * writes while its queue has data. A closed client waiting for *
+ * the lock leaves epoll, its EPOLLHUP would wake it each loop. *
+ * ------------------------------------------------------------ */
+static void clientwatch(int i) {
+  hub_client *c = &clients[i];
+  unsigned int events = 0;
+  if(c->hup && held(c)) {
+    if(!c->parked) epoll_ctl(epfd, EPOLL_CTL_DEL, c->fd, NULL);
+    c->parked = 1;
+    return;
+  }
+  if(ports[c->port].busy == -1 && !held(c)) events |= EPOLLIN;
+  if(c->tail != c->head) events |= EPOLLOUT;
+  watch(c->fd, events, HUB_CLIENT, i, c->parked);
+  c->parked = 0;
+}
+
+/* ------------------------------------------------------------ *
+ * portclients() updates the epoll events of all port clients   *
+ * ------------------------------------------------------------ */
+static void portclients(int n) {
+  int i;
+  for(i = 0; i < HUB_MAXCLIENT; i++)
+    if(clients[i].fd != -1 && clients[i].port == n) clientwatch(i);
+}
+
+/* ------------------------------------------------------------ *
+ * portwatch() waits for POLLOUT while port data is queued      *
+ * ------------------------------------------------------------ */
+static void portwatch(int n) {
+  hub_port *p = &ports[n];
+  unsigned int events = EPOLLIN;
+  if(pushserial(p->fd) > 0 || p->busy != -1) events |= EPOLLOUT;
+  watch(p->fd, events, HUB_PORT, n, 0);
+}
+
+/* ------------------------------------------------------------ *
+ * printstats() prints one line per port and client             *
+ * ------------------------------------------------------------ */
+static void printstats(void) {
+  int i;
+  for(i = 0; i < nports; i++) {
+    printf("port %-8s rx %10lld tx %10lld", ports[i].name, ports[i].rxbytes, ports[i].txbytes);
+    if(ports[i].owner != -1) printf(" locked by pid %d", (int) ports[i].ownerpid);
+    printf("\n");
+  }
+  for(i = 0; i < HUB_MAXCLIENT; i++) {
+    if(clients[i].fd == -1) continue;
+    printf("client %3d %-8s %-6s %6us rx %10lld tx %10lld dropped %lld\n",
+           clients[i].id, ports[clients[i].port].name, clients[i].pty ? "pty" : "socket",
+           (msec() - clients[i].since) / 1000, clients[i].rxbytes,
+           clients[i].txbytes, clients[i].dropped);
+  }
+  fflush(stdout);
+}
+
+/* ------------------------------------------------------------ *
+ * addclient() takes a free slot for fd. Returns the slot, or   *
+ * -1 if all are in use.                                        *
+ * ------------------------------------------------------------ */
+static int addclient(int fd, int port, int pty) {
+  hub_client *c;
+  int i;
+
+  for(i = 0; i < HUB_MAXCLIENT; i++) if(clients[i].fd == -1) break;
+  if(i == HUB_MAXCLIENT) return -1;
+  c = &clients[i];
+  memset(c, 0, sizeof(hub_client));
+  c->fd = fd;
+  c->port = port;
+  c->pty = pty;
+  c->since = msec();
+  c->id = nextid++;
+  c->pid = pty ? 0 : peerpid(fd);
+  watch(fd, 0, HUB_CLIENT, i, 1);
+  clientwatch(i);
+  return i;
+}
+
+/* ------------------------------------------------------------ *
+ * dropclient() prints the client statistics and frees it. A    *
+ * partial write it left on the port is finished first.         *
+ * ------------------------------------------------------------ */
+static void dropclient(int i) {
+  hub_client *c = &clients[i];
+  int j;
+
+  printf("client %d %s closed, rx %lld tx %lld dropped %lld\n", c->id,
+         ports[c->port].name, c->rxbytes, c->txbytes, c->dropped);
+  fflush(stdout);
+  if(ports[c->port].busy == i) {
+    sendserial(ports[c->port].fd, c->in + c->inoff, c->inlen - c->inoff, msec() + SERIAL_TXWAIT);
+    ports[c->port].busy = -1;
+    for(j = 0; j < HUB_MAXCLIENT; j++)
+      if(clients[j].fd != -1 && j != i && clients[j].port == c->port) clientwatch(j);
+  }
+  if(!c->parked) epoll_ctl(epfd, EPOLL_CTL_DEL, c->fd, NULL);
+  close(c->fd);
+  c->fd = -1;
+}
+
+/* ------------------------------------------------------------ *
+ * grant() gives the free port lock to the oldest request, or   *
+ * tells the holder with 'W' that a request waits               *
+ * ------------------------------------------------------------ */
+static void grant(int n) {
+  hub_port *p = &ports[n];
+  int i, next = -1;
+
+  for(i = 0; i < HUB_MAXCLIENT; i++) {
+    if(locks[i].fd == -1 || locks[i].port != n || i == p->owner || locks[i].lease == 0) continue;
+    if(next == -1 || locks[i].seq < locks[next].seq) next = i;
+  }
+  if(next == -1) return;
+  if(p->owner != -1) {
+    send(locks[p->owner].fd, "W", 1, MSG_NOSIGNAL);
+    return;
+  }
+  p->owner = next;
+  p->ownerpid = locks[next].pid;
+  p->until = msec() + locks[next].lease;
+  send(locks[next].fd, "L", 1, MSG_NOSIGNAL);
+  portclients(n);
+}
+
+/* ------------------------------------------------------------ *
+ * addlock() takes a free lock slot for fd. Returns the slot,   *
+ * or -1 if all are in use.                                     *
+ * ------------------------------------------------------------ */
+static int addlock(int fd, int port) {
+  hub_lock *l;
+  int i;
+
+  for(i = 0; i < HUB_MAXCLIENT; i++) if(locks[i].fd == -1) break;
+  if(i == HUB_MAXCLIENT) return -1;
+  l = &locks[i];
+  memset(l, 0, sizeof(hub_lock));
+  l->fd = fd;
+  l->port = port;
+  l->pid = peerpid(fd);
+  l->seq = nextseq++;
+  watch(fd, EPOLLIN, HUB_LOCK, i, 1);
+  return i;
+}
+
+/* ------------------------------------------------------------ *
+ * droplock() closes a lock connection, if it held the port the *
+ * lock goes to the next request                                *
+ * ------------------------------------------------------------ */
+static void droplock(int i) {
+  hub_lock *l = &locks[i];
+  hub_port *p = &ports[l->port];
+
+  epoll_ctl(epfd, EPOLL_CTL_DEL, l->fd, NULL);
+  close(l->fd);
+  l->fd = -1;
+  if(p->owner == i) {
+    p->owner = -1;
+    p->ownerpid = 0;
+    portclients(l->port);
+    grant(l->port);
+  }
+}
+
+/* ------------------------------------------------------------ *
+ * lockin() reads lease messages: the first one requests the    *
+ * lock, later ones renew the lease of the holder               *
+ * ------------------------------------------------------------ */
+static void lockin(int i) {
+  hub_lock *l = &locks[i];
+  hub_port *p = &ports[l->port];
+  uint32_t lease;
+  int len;
+
+  for(;;) {
+    if((len = read(l->fd, l->msg + l->msglen, sizeof(l->msg) - l->msglen)) <= 0) {
+      if(len == 0 || (errno != EAGAIN && errno != EINTR)) droplock(i);
+      return;
+    }
+    if((l->msglen += len) < (int) sizeof(l->msg)) continue;
+    l->msglen = 0;
+    memcpy(&lease, l->msg, sizeof(lease));
+    if(lease == 0) lease = 1;
+    if(p->owner == i) p->until = msec() + lease;
+    else if(l->lease == 0) {
+      l->lease = lease;
+      grant(l->port);
+    }
+    else l->lease = lease;
+  }
+}
+
+/* ------------------------------------------------------------ *
+ * expire() drops the holders with an expired lease, returns    *
+ * the ms to the next expiry for epoll_wait(), -1 if none       *
+ * ------------------------------------------------------------ */
+static int expire(void) {
+  int i, left, wait = -1;
+
+  for(i = 0; i < nports; i++) {
+    if(ports[i].owner == -1) continue;
+    if((left = (int) (ports[i].until - msec())) <= 0) {
+      printf("port %s lock of pid %d expired\n", ports[i].name, (int) ports[i].ownerpid);
+      fflush(stdout);
+      droplock(ports[i].owner);
+      if(ports[i].owner == -1) continue;
+      left = (int) (ports[i].until - msec());
+    }
+    if(wait == -1 || left < wait) wait = left;
+  }
+  return wait;
+}
+
+/* ------------------------------------------------------------ *
+ * flushclient() writes the client queue without blocking       *
+ * ------------------------------------------------------------ */
+static int flushclient(hub_client *c) {
+  unsigned int off, len;
+  int res;
+
+  while(c->tail != c->head) {
+    off = c->head % HUB_CLIENTBUF;
+    len = c->tail - c->head;
+    if(len > HUB_CLIENTBUF - off) len = HUB_CLIENTBUF - off;
+    if((res = write(c->fd, c->out + off, len)) == -1) {
+      if(errno == EAGAIN || errno == EINTR) return 0;
+      return -1;
+    }
+    c->head += res;
+    c->rxbytes += res;
+  }
+  return 0;
+}
+
+/* ------------------------------------------------------------ *
+ * fanout() queues port data for every client of the port, the  *
+ * part that does not fit into a full queue is dropped          *
+ * ------------------------------------------------------------ */
+static void fanout(int port, const unsigned char *data, int len) {
+  hub_client *c;
+  unsigned int off, chunk;
+  int i, n, done;
+
+  for(i = 0; i < HUB_MAXCLIENT; i++) {
+    c = &clients[i];
+    if(c->fd == -1 || c->port != port || c->parked) continue;
+    n = HUB_CLIENTBUF - (c->tail - c->head);
+    if(n > len) n = len;
+    c->dropped += len - n;
+    for(done = 0; done < n; done += chunk) {
+      off = c->tail % HUB_CLIENTBUF;
+      chunk = HUB_CLIENTBUF - off;
+      if(chunk > (unsigned int) (n - done)) chunk = n - done;
+      memcpy(c->out + off, data + done, chunk);
+      c->tail += chunk;
+    }
+    if(flushclient(c) == -1 && !c->pty) dropclient(i);
+    else clientwatch(i);
+  }
+}
+
+/* ------------------------------------------------------------ *
+ * portin() reads all data the port has, and fans it out        *
+ * ------------------------------------------------------------ */
+static void portin(int n) {
+  unsigned char buf[SERIAL_RXBUF];
+  int len;
+
+  while((len = readserial(ports[n].fd, buf, sizeof(buf), msec())) > 0) {
+    ports[n].rxbytes += len;
+    fanout(n, buf, len);
+    if(len < (int) sizeof(buf)) break;
+  }
+}
+
+/* ------------------------------------------------------------ *
+ * portout() sends queued port data, then the rest of a partial *
+ * client write. Once that is queued, all clients may write.    *
+ * ------------------------------------------------------------ */
+static void portout(int n) {
+  hub_port *p = &ports[n];
+  hub_client *c;
+  int res, i;
+
+  if(p->busy != -1) {
+    c = &clients[p->busy];
+    if((res = sendserial(p->fd, c->in + c->inoff, c->inlen - c->inoff, msec())) > 0) {
+      c->inoff += res;
+      p->txbytes += res;
+    }
+    if(c->inoff == c->inlen) {
+      p->busy = -1;
+      for(i = 0; i < HUB_MAXCLIENT; i++)
+        if(clients[i].fd != -1 && clients[i].port == n) clientwatch(i);
+    }
+  }
+  portwatch(n);
+}
+
+/* ------------------------------------------------------------ *
+ * clientin() reads one chunk from a client and queues it on    *
+ * the port. If the port queue is full, the port is marked busy *
+ * with this client, and no client is read until it is sent.    *
+ * ------------------------------------------------------------ */
+static void clientin(int i) {
+  hub_client *c = &clients[i];
+  hub_port *p = &ports[c->port];
+  int len, res, j;
+
+  if((len = read(c->fd, c->in, HUB_CHUNK)) <= 0) {
+    if(len == 0 || (errno != EAGAIN && errno != EINTR)) {
+      if(!c->pty) dropclient(i);
+    }
+    return;
+  }
+  c->txbytes += len;
+  if((res = sendserial(p->fd, c->in, len, msec())) < 0) res = 0;
+  p->txbytes += res;
+  if(res < len) {
+    c->inoff = res;
+    c->inlen = len;
+    p->busy = i;
+    for(j = 0; j < HUB_MAXCLIENT; j++)
+      if(clients[j].fd != -1 && clients[j].port == c->port) clientwatch(j);
+  }
+  portwatch(c->port);
+}
+
+/* ------------------------------------------------------------ *
+ * listenon() binds a socket at path, clients run as any user.  *
+ * Returns the listening fd, -1 on errors.                      *
+ * ------------------------------------------------------------ */
+static int listenon(const char *path) {
+  struct sockaddr_un addr;
+  int fd;
+
+  if((fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) == -1) return -1;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+  unlink(path);
+  if(bind(fd, (struct sockaddr *) &addr, sizeof(addr)) == -1
+     || listen(fd, 8) == -1) {
+    printf("Error binding socket %s\n", path);
+    close(fd);
+    return -1;
+  }
+  chmod(path, 0666);
+  return fd;
+}
+
+/* ------------------------------------------------------------ *
+ * openport() opens the device, its sockets and optional pty    *
+ * ------------------------------------------------------------ */
+static int openport(int n, const char *device, int baud, int pty, const char *dir) {
+  serial_profile profile = { baud, SERIAL_LATENCY, 0, 1 };
+  struct termios options;
+  hub_port *p = &ports[n];
+  const char *name = strrchr(device, '/');
+  int master;
+
+  memset(p, 0, sizeof(hub_port));
+  p->device = device;
+  p->name = (name != NULL) ? name + 1 : device;
+  p->busy = -1;
+  p->owner = -1;
+  p->ptyslave = -1;
+  if((p->fd = getserial(device, &profile)) < 0) {
+    printf("Error opening port %s %d Baud\n", device, baud);
+    return -1;
+  }
+
+  /* --------------------------------------------------------- *
+   * bind the data socket and the command mode lock socket     *
+   * --------------------------------------------------------- */
+  snprintf(p->sockpath, sizeof(p->sockpath), "%s/%s.sock", dir, p->name);
+  snprintf(p->lockpath, sizeof(p->lockpath), "%s/%s.lock", dir, p->name);
+  if((p->sock = listenon(p->sockpath)) == -1
+     || (p->lsock = listenon(p->lockpath)) == -1) return -1;
+  watch(p->fd, EPOLLIN, HUB_PORT, n, 1);
+  watch(p->sock, EPOLLIN, HUB_LISTEN, n, 1);
+  watch(p->lsock, EPOLLIN, HUB_LOCKLISTEN, n, 1);
+
+  /* --------------------------------------------------------- *
+   * the pty is a raw tty client linked as <dir>/<name>.pty    *
+   * --------------------------------------------------------- */
+  if(pty) {
+    if((master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC)) == -1
+       || grantpt(master) == -1 || unlockpt(master) == -1
+       || (p->ptyslave = open(ptsname(master), O_RDWR | O_NOCTTY | O_CLOEXEC)) == -1) {
+      printf("Error creating pty for %s\n", device);
+      return -1;
+    }
+    tcgetattr(p->ptyslave, &options);
+    cfmakeraw(&options);
+    tcsetattr(p->ptyslave, TCSANOW, &options);
+    snprintf(p->ptylink, sizeof(p->ptylink), "%s/%s.pty", dir, p->name);
+    unlink(p->ptylink);
+    if(symlink(ptsname(master), p->ptylink) == -1) printf("Error linking %s\n", p->ptylink);
+    chmod(ptsname(master), 0666);
+    if(addclient(master, n, 1) == -1) return -1;
+  }
+  printf("%s [%d] on %s%s%s\n", device, baud, p->sockpath,
+         pty ? " and " : "", pty ? p->ptylink : "");
+  return 0;
+}
+
+int main(int argc, char *argv[]) {
+  struct epoll_event evs[32];
+  struct sigaction sa;
+  const char *dir = getenv("SERHUB_DIR");
+  const char *defaults[] = { UART1, UART2 };
+  int baud = SPEED, pty = 0;
+  int arg, i, n, fd, type, index, wait;
+
+  while ((arg = getopt(argc, argv, "s:d:ph")) != -1) {
+    switch (arg) {
+      case 's': baud = atoi(optarg); break;
+      case 'd': dir = optarg; break;
+      case 'p': pty = 1; break;
+      default:
+        printf("Usage: ./serhubd [-s baud] [-d socket dir] [-p] [device ...]\n");
+        printf("   -p   also create a pty per port for tty clients\n");
+        return -1;
+    }
+  }
+  if(dir == NULL) dir = SERIAL_HUBDIR;
+  mkdir(dir, 0755);
+  for(i = 0; i < HUB_MAXCLIENT; i++) clients[i].fd = locks[i].fd = -1;
+  if((epfd = epoll_create1(EPOLL_CLOEXEC)) == -1) return -1;
+
+  if(optind == argc) {
+    for(nports = 0; nports < 2; nports++)
+      if(openport(nports, defaults[nports], baud, pty, dir) == -1) return -1;
+  }
+  for(; optind < argc && nports < HUB_MAXPORTS; optind++, nports++)
+    if(openport(nports, argv[optind], baud, pty, dir) == -1) return -1;
+
+  // no SA_RESTART, epoll_wait() returns EINTR on a signal
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = Handler;
+  sigaction(SIGINT, &sa, NULL);
+  sigaction(SIGTERM, &sa, NULL);
+  sigaction(SIGUSR1, &sa, NULL);
+  signal(SIGPIPE, SIG_IGN);
+
+  while(running) {
+    if(stats) {
+      stats = 0;
+      printstats();
+    }
+    wait = expire();
+    if((n = epoll_wait(epfd, evs, 32, wait)) == -1) continue;
+    for(i = 0; i < n; i++) {
+      type = evs[i].data.u32 >> 16;
+      index = evs[i].data.u32 & 0xFFFF;
+      if(type == HUB_PORT) {
+        if(evs[i].events & EPOLLIN) portin(index);
+        if(evs[i].events & EPOLLOUT) portout(index);
+      }
+      else if(type == HUB_LISTEN) {
+        while((fd = accept4(ports[index].sock, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1) {
+          if(addclient(fd, index, 0) == -1) close(fd);
+        }
+      }
+      else if(type == HUB_LOCKLISTEN) {
+        while((fd = accept4(ports[index].lsock, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1) {
+          if(addlock(fd, index) == -1) close(fd);
+        }
+      }
+      else if(type == HUB_LOCK) {
+        if(locks[index].fd != -1) lockin(index);
+      }
+      else if(clients[index].fd != -1) {
+        if((evs[i].events & EPOLLHUP) && held(&clients[index])) {
+          clients[index].hup = 1;       // its data waits for the unlock
+          clientwatch(index);
+          continue;
+        }
+        if(evs[i].events & (EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+          if(flushclient(&clients[index]) == -1 && !clients[index].pty) {
+            dropclient(index);
+            continue;
+          }
+          clientwatch(index);
+        }
+        if(evs[i].events & (EPOLLIN | EPOLLHUP)) clientin(index);
+      }
+    }
+  }
+
+  printstats();
+  for(i = 0; i < HUB_MAXCLIENT; i++) {
+    if(clients[i].fd != -1) close(clients[i].fd);
+    if(locks[i].fd != -1) close(locks[i].fd);
+  }
+  for(i = 0; i < nports; i++) {
+    closeserial(ports[i].fd);
+    close(ports[i].sock);
+    close(ports[i].lsock);
+    unlink(ports[i].sockpath);
+    unlink(ports[i].lockpath);
+    if(ports[i].ptyslave != -1) {
+      close(ports[i].ptyslave);
+      unlink(ports[i].ptylink);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,309 @@
+/* ------------------------------------------------------------ *
+ * file:        serial-replay.c                                 *
+ * purpose:     Replays a serial capture (SERIAL_CAPTURE=file)  *
+ *              through a pseudo-terminal. The data the port    *
+ *              received (RX) goes to the pty at its original   *
+ *              time, or faster with -x. Before RX data that    *
+ *              answered a write, replay waits for the program  *
+ *              to write the same bytes (TX) and compares them. *
+ *              Delays count from that write, so the program's  *
+ *              own timing does not shift the replay. -f skips  *
+ *              the TX records and replays by time only.        *
+ *              A command after the capture runs with SERIAL_   *
+ *              DEVICE set to the pty, getserial() then opens   *
+ *              it instead of the programmed port. This applies *
+ *              to the first port the command opens only, a     *
+ *              capture of several ports can not be replayed.   *
+ *              -p prints the capture as text.                  *
+ *                                                              *
+ * return:      0 on success, and -1 on errors or mismatches.   *
+ *                                                              *
+ * requires:    serial.h                                        *
+ *                                                              *
+ * compile:     see Makefile                                    *
+ *                                                              *
+ * example:     SERIAL_CAPTURE=ping.cap ./xbee-ping             *
+ *              ./serial-replay -p ping.cap                     *
+ *              ./serial-replay -x 10 ping.cap ./xbee-ping      *
+ *                                                              *
+ * author:      10/17/2026 Frank4DD                             *
+ * ------------------------------------------------------------ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <errno.h>
+#include <signal.h>
+#include <termios.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "serial.h"
+
+#define GOTBUF  65536           // program writes not yet compared
+#define TXWAIT  2000            // min ms to wait for a program write
+
+unsigned char *trace;           // the whole capture file
+long tracelen;
+double speed = 1.0;             // 0 = no delays
+int freerun = 0;                // 1 = ignore TX records
+int firstwait = 30;             // s to wait for the program to start
+int master = -1;
+unsigned char got[GOTBUF];      // bytes the program wrote
+int gotlen = 0;
+long gotdropped = 0;
+pid_t child = 0;
+int childstatus = 0;
+
+/* ------------------------------------------------------------ *
+ * nsec() returns CLOCK_MONOTONIC time in nanoseconds           *
+ * ------------------------------------------------------------ */
+static long long nsec(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* ------------------------------------------------------------ *
+ * load() reads the capture file and checks its header          *
+ * ------------------------------------------------------------ */
+static int load(const char *file) {
+  serial_capheader *hdr;
+  FILE *fp;
+
+  if((fp = fopen(file, "rb")) == NULL) {
+    printf("Error opening capture %s\n", file);
+    return -1;
+  }
+  fseek(fp, 0, SEEK_END);
+  tracelen = ftell(fp);
+  rewind(fp);
+  if((trace = malloc(tracelen + 1)) == NULL
+     || fread(trace, 1, tracelen, fp) != (size_t) tracelen) {
+    fclose(fp);
+    return -1;
+  }
+  fclose(fp);
+  hdr = (serial_capheader *) trace;
+  if(tracelen < (long) sizeof(serial_capheader) || memcmp(hdr->magic, SERIAL_CAPMAGIC, 4) != 0
+     || hdr->version != SERIAL_CAPVERSION) {
+    printf("Error: %s is not a serial capture\n", file);
+    return -1;
+  }
+  return 0;
+}
+
+/* ------------------------------------------------------------ *
+ * nextrec() returns the record at *pos and moves past it, or   *
+ * NULL at the end (or at a record cut short by a crash)        *
+ * ------------------------------------------------------------ */
+static serial_caprec *nextrec(long *pos) {
+  serial_caprec *rec = (serial_caprec *) (trace + *pos);
+  if(*pos + (long) sizeof(serial_caprec) > tracelen) return NULL;
+  if(*pos + (long) sizeof(serial_caprec) + rec->len > tracelen) return NULL;
+  *pos += sizeof(serial_caprec) + rec->len;
+  return rec;
+}
+
+/* ------------------------------------------------------------ *
+ * printtrace() lists the records, non-printable bytes as \xNN  *
+ * ------------------------------------------------------------ */
+static void printtrace(void) {
+  const char *types[] = { "RX", "TX", "OPEN" };
+  serial_caprec *rec;
+  unsigned char *data;
+  long pos = sizeof(serial_capheader);
+  int i;
+
+  while((rec = nextrec(&pos)) != NULL) {
+    data = (unsigned char *) (rec + 1);
+    if(rec->lost > 0) printf("           %u records lost\n", rec->lost);
+    printf("%11.6f %-4s fd %-3d %4d ", rec->time / 1.0e9,
+           (rec->type <= SERIAL_CAP_OPEN) ? types[rec->type] : "?", rec->fd, rec->len);
+    for(i = 0; i < rec->len; i++) {
+      if(data[i] == '\r') printf("\\r");
+      else if(data[i] == '\n') printf("\\n");
+      else if(data[i] >= 32 && data[i] < 127) putchar(data[i]);
+      else printf("\\x%02X", data[i]);
+    }
+    printf("\n");
+  }
+}
+
+/* ------------------------------------------------------------ *
+ * pump() collects program writes until data arrives or until   *
+ * the deadline in ns. Returns -1 if the program has gone.      *
+ * ------------------------------------------------------------ */
+static int pump(long long deadline) {
+  struct pollfd pfd;
+  long long wait;
+  int res;
+
+  pfd.fd = master;
+  pfd.events = POLLIN;
+  wait = (deadline - nsec()) / 1000000;
+  if(wait < 0) wait = 0;
+  if(poll(&pfd, 1, (int) wait) <= 0) return 0;
+  if(gotlen == GOTBUF) {                       // not compared, drop
+    gotdropped += gotlen;
+    gotlen = 0;
+  }
+  res = read(master, got + gotlen, GOTBUF - gotlen);
+  if(res > 0) gotlen += res;
+  if(child > 0 && waitpid(child, &childstatus, WNOHANG) == child) {
+    child = 0;
+    return -1;
+  }
+  return 0;
+}
+
+/* ------------------------------------------------------------ *
+ * replay() runs the records of port fd against the pty.        *
+ * Returns the num mismatches and timeouts.                     *
+ * ------------------------------------------------------------ */
+static int replay(int fd) {
+  serial_caprec *rec;
+  unsigned char *data;
+  long pos = sizeof(serial_capheader);
+  long long start, syncwall, synctrace = 0, due, timeout;
+  long rxbytes = 0, txbytes = 0;
+  int errors = 0, first = 1, off, res;
+
+  start = syncwall = nsec();
+  while((rec = nextrec(&pos)) != NULL) {
+    data = (unsigned char *) (rec + 1);
+    if(rec->fd != fd) continue;
+
+    /* ------------------------------------------------------- *
+     * TX: wait for the program to write the same bytes        *
+     * ------------------------------------------------------- */
+    if(rec->type == SERIAL_CAP_TX && !freerun) {
+      timeout = nsec() + (first ? firstwait * 1000LL : TXWAIT) * 1000000LL;
+      if(speed > 0 && (rec->time - synctrace) / speed * 5 > TXWAIT * 1000000.0)
+        timeout = nsec() + (rec->time - synctrace) / speed * 5;
+      while(gotlen < rec->len && nsec() < timeout) if(pump(timeout) == -1) break;
+      if(gotlen < rec->len) {
+        printf("Error: program did not write at %.6f s, expected %d bytes, got %d\n",
+               rec->time / 1.0e9, rec->len, gotlen);
+        return errors + 1;
+      }
+      if(memcmp(got, data, rec->len) != 0) {
+        printf("Mismatch: program write at %.6f s differs\n", rec->time / 1.0e9);
+        errors++;
+      }
+      gotlen -= rec->len;
+      memmove(got, got + rec->len, gotlen);
+      txbytes += rec->len;
+      syncwall = nsec();
+      synctrace = rec->time;
+      first = 0;
+    }
+
+    /* ------------------------------------------------------- *
+     * RX: send to the program at its (scaled) trace time      *
+     * ------------------------------------------------------- */
+    else if(rec->type == SERIAL_CAP_RX) {
+      due = syncwall + ((speed > 0) ? (long long) ((rec->time - synctrace) / speed) : 0);
+      while(nsec() < due) if(pump(due) == -1) break;
+      for(off = 0; off < rec->len; off += res) {
+        if((res = write(master, data + off, rec->len - off)) == -1) {
+          if(errno != EAGAIN && errno != EINTR) return errors + 1;
+          pump(nsec() + 1000000);
+          res = 0;
+        }
+      }
+      rxbytes += rec->len;
+    }
+  }
+  printf("Replay fd %d: %ld bytes sent, %ld bytes compared in %.3f s\n",
+         fd, rxbytes, txbytes, (nsec() - start) / 1.0e9);
+  if(gotdropped > 0) printf("%ld program bytes not compared\n", gotdropped);
+  return errors;
+}
+
+int main(int argc, char *argv[]) {
+  struct termios options;
+  serial_caprec *rec;
+  char *link = NULL;
+  long pos;
+  int fd = -1, print = 0;
+  int arg, slave, errors;
+
+  while ((arg = getopt(argc, argv, "+x:d:l:w:fph")) != -1) {
+    switch (arg) {
+      case 'x': speed = atof(optarg); break;
+      case 'd': fd = atoi(optarg); break;
+      case 'l': link = optarg; break;
+      case 'w': firstwait = atoi(optarg); break;
+      case 'f': freerun = 1; break;
+      case 'p': print = 1; break;
+      default:
+        printf("Usage: ./serial-replay [-x speed] [-f] [-d fd] [-l link] [-w secs] [-p]\n");
+        printf("                       capture [command ...]\n");
+        printf("   -x   speed factor, 0 = no delays. Default 1\n");
+        printf("   -f   free-running, do not wait for the program writes\n");
+        printf("   -d   port fd in the capture, default the first one\n");
+        printf("   -l   symlink to the pty, e.g. /tmp/ttySC1\n");
+        printf("   -w   seconds to wait for the first program write. Default 30\n");
+        printf("   -p   print the capture records\n");
+        return -1;
+    }
+  }
+  if(optind >= argc || load(argv[optind]) == -1) return -1;
+  if(print) {
+    printtrace();
+    return 0;
+  }
+  if(fd == -1) {
+    pos = sizeof(serial_capheader);
+    if((rec = nextrec(&pos)) == NULL) return 0;
+    fd = rec->fd;
+  }
+
+  /* --------------------------------------------------------- *
+   * create the raw pty, the slave stays open between programs *
+   * --------------------------------------------------------- */
+  if((master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK)) == -1
+     || grantpt(master) == -1 || unlockpt(master) == -1
+     || (slave = open(ptsname(master), O_RDWR | O_NOCTTY)) == -1) {
+    printf("Error creating pty\n");
+    return -1;
+  }
+  tcgetattr(slave, &options);
+  cfmakeraw(&options);
+  tcsetattr(slave, TCSANOW, &options);
+  if(link != NULL) {
+    unlink(link);
+    if(symlink(ptsname(master), link) == -1) printf("Error linking %s\n", link);
+  }
+  printf("Replay %s on %s\n", argv[optind], ptsname(master));
+  fflush(stdout);
+
+  if(optind + 1 < argc) {
+    if((child = fork()) == 0) {
+      setenv("SERIAL_DEVICE", ptsname(master), 1);
+      close(master);
+      close(slave);
+      execvp(argv[optind + 1], &argv[optind + 1]);
+      printf("Error running %s\n", argv[optind + 1]);
+      _exit(127);
+    }
+  }
+
+  errors = replay(fd);
+  if(child > 0) {
+    if(errors > 0) kill(child, SIGTERM);
+    waitpid(child, &childstatus, 0);
+  }
+  if(link != NULL) unlink(link);
+  close(slave);
+  close(master);
+  if(errors > 0) {
+    printf("Replay failed, %d errors\n", errors);
+    return -1;
+  }
+  return (WIFEXITED(childstatus) && WEXITSTATUS(childstatus) == 0) ? 0 : -1;
+}
@@ -6,19 +6,463 @@
 #include <termios.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <errno.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
+#include <linux/serial.h>
 #include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 #include <sys/stat.h>
 #include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include "serial.h"
 
 /* ------------------------------------------------------------ *
- * getserial() Opens and inits the serial port with given speed *
+ * Per-port receive buffer, indexed by fd. fill() moves all     *
+ * bytes the kernel has queued with one read(), the getters     *
+ * then take them from memory. Unread data always sits in one   *
+ * piece at buf[head..tail), it is moved to the front when the  *
+ * end of the buffer is reached.                                *
+ * The transmit queue is a ring with free-running counters, the *
+ * fd is non-blocking and push() hands the queued bytes to the  *
+ * kernel with one writev() of the (up to) two ring pieces.     *
  * ------------------------------------------------------------ */
-int getserial(const char *device, const int baud) {
+typedef struct {
+  unsigned char buf[SERIAL_RXBUF];
+  int head;                         // first unread byte
+  int tail;                         // end of received data
+  unsigned char tx[SERIAL_TXBUF];
+  unsigned int txhead;              // next byte to write()
+  unsigned int txtail;              // end of queued bytes
+  long long written;                // total bytes given to kernel
+  int baud;                         // line speed, for drain waits
+  char lockpath[108];               // serhubd lock socket, "" = direct
+  int lockfd;                       // lock connection, -1 = not held
+  int contended;                    // 1 = the hub reported a waiter
+} serial_port;
+
+static serial_port *ports[SERIAL_MAXFD];
+
+/* ------------------------------------------------------------ *
+ * getport() returns the buffer of fd, allocated on first use   *
+ * ------------------------------------------------------------ */
+static serial_port *getport(const int fd) {
+  if(fd < 0 || fd >= SERIAL_MAXFD) return NULL;
+  if(ports[fd] == NULL) ports[fd] = calloc(1, sizeof(serial_port));
+  return ports[fd];
+}
+
+/* ------------------------------------------------------------ *
+ * Capture: with SERIAL_CAPTURE=<file> (or capserial()) every   *
+ * chunk read or written is logged as a serial_caprec and its   *
+ * data. The records go into a single-producer lock-free byte   *
+ * ring, a background thread appends the ring to the file every *
+ * SERIAL_CAPWAIT ms. Serial I/O never blocks on the disk, if   *
+ * the ring is full records are dropped and counted in the next *
+ * record (lost). Serial I/O must come from one thread.         *
+ * ------------------------------------------------------------ */
+static unsigned char *cap_ring = NULL;
+static _Atomic unsigned int cap_head;   // written by serial I/O
+static _Atomic unsigned int cap_tail;   // written by the writer
+static atomic_int cap_stop;
+static unsigned int cap_lost = 0;
+static long long cap_start;
+static FILE *cap_file;
+static pthread_t cap_thread;
+
+/* ------------------------------------------------------------ *
+ * capnow() returns CLOCK_MONOTONIC ns, or CLOCK_REALTIME ns    *
+ * ------------------------------------------------------------ */
+static long long capnow(clockid_t clock) {
+  struct timespec ts;
+  clock_gettime(clock, &ts);
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* ------------------------------------------------------------ *
+ * capput() copies len bytes into the ring at position pos      *
+ * ------------------------------------------------------------ */
+static void capput(unsigned int pos, const void *data, unsigned int len) {
+  unsigned int off = pos % SERIAL_CAPRING;
+  unsigned int first = (len > SERIAL_CAPRING - off) ? SERIAL_CAPRING - off : len;
+  memcpy(cap_ring + off, data, first);
+  memcpy(cap_ring, (const char *) data + first, len - first);
+}
+
+/* ------------------------------------------------------------ *
+ * capture() logs one chunk, given as up to two pieces a and b  *
+ * ------------------------------------------------------------ */
+static void capture(const int fd, const int type, const void *a, int alen, const void *b, int blen) {
+  serial_caprec rec;
+  unsigned int head, need;
+
+  if(cap_ring == NULL) return;
+  head = atomic_load_explicit(&cap_head, memory_order_relaxed);
+  need = sizeof(rec) + alen + blen;
+  if(need > SERIAL_CAPRING - (head - atomic_load_explicit(&cap_tail, memory_order_acquire))) {
+    cap_lost++;                     // writer is behind
+    return;
+  }
+  rec.time = capnow(CLOCK_MONOTONIC) - cap_start;
+  rec.lost = cap_lost;
+  rec.len = alen + blen;
+  rec.type = type;
+  rec.fd = fd;
+  cap_lost = 0;
+  capput(head, &rec, sizeof(rec));
+  capput(head + sizeof(rec), a, alen);
+  if(blen > 0) capput(head + sizeof(rec) + alen, b, blen);
+  atomic_store_explicit(&cap_head, head + need, memory_order_release);
+}
+
+/* ------------------------------------------------------------ *
+ * capwrite() appends the filled part of the ring to the file   *
+ * ------------------------------------------------------------ */
+static void capwrite(void) {
+  unsigned int tail = atomic_load_explicit(&cap_tail, memory_order_relaxed);
+  unsigned int head = atomic_load_explicit(&cap_head, memory_order_acquire);
+  unsigned int off, len;
+
+  while(tail != head) {
+    off = tail % SERIAL_CAPRING;
+    len = head - tail;
+    if(len > SERIAL_CAPRING - off) len = SERIAL_CAPRING - off;
+    fwrite(cap_ring + off, 1, len, cap_file);
+    tail += len;
+  }
+  atomic_store_explicit(&cap_tail, tail, memory_order_release);
+  fflush(cap_file);
+}
+
+/* ------------------------------------------------------------ *
+ * capthread() is the background writer                         *
+ * ------------------------------------------------------------ */
+static void *capthread(void *arg) {
+  struct timespec wait = { 0, SERIAL_CAPWAIT * 1000000L };
+  while(!atomic_load(&cap_stop)) {
+    capwrite();
+    nanosleep(&wait, NULL);
+  }
+  capwrite();
+  return NULL;
+}
+
+/* ------------------------------------------------------------ *
+ * capclose() writes the rest of the ring at program exit       *
+ * ------------------------------------------------------------ */
+static void capclose(void) {
+  if(cap_ring == NULL) return;
+  atomic_store(&cap_stop, 1);
+  pthread_join(cap_thread, NULL);
+  fclose(cap_file);
+  free(cap_ring);
+  cap_ring = NULL;
+}
+
+/* ------------------------------------------------------------ *
+ * capserial() starts the capture into file. Returns 0 on       *
+ * success, -1 on errors or if a capture is already running.    *
+ * ------------------------------------------------------------ */
+int capserial(const char *file) {
+  serial_capheader hdr;
+
+  if(cap_ring != NULL || (cap_file = fopen(file, "wb")) == NULL) return -1;
+  memset(&hdr, 0, sizeof(hdr));
+  memcpy(hdr.magic, SERIAL_CAPMAGIC, 4);
+  hdr.version = SERIAL_CAPVERSION;
+  hdr.start = capnow(CLOCK_REALTIME);
+  fwrite(&hdr, sizeof(hdr), 1, cap_file);
+  if((cap_ring = malloc(SERIAL_CAPRING)) == NULL) {
+    fclose(cap_file);
+    return -1;
+  }
+  cap_start = capnow(CLOCK_MONOTONIC);
+  if(pthread_create(&cap_thread, NULL, capthread, NULL) != 0) {
+    free(cap_ring);
+    cap_ring = NULL;
+    fclose(cap_file);
+    return -1;
+  }
+  atexit(capclose);
+  return 0;
+}
+
+/* ------------------------------------------------------------ *
+ * push() writes as much of the tx queue as the kernel takes    *
+ * without blocking. Returns the bytes written, -1 on errors.   *
+ * ------------------------------------------------------------ */
+static int push(const int fd, serial_port *p) {
+  struct iovec iov[2];
+  unsigned int used = p->txtail - p->txhead;
+  unsigned int off = p->txhead % SERIAL_TXBUF;
+  int cnt = 1, res;
+
+  if(used == 0) return 0;
+  iov[0].iov_base = p->tx + off;
+  iov[0].iov_len = (off + used > SERIAL_TXBUF) ? SERIAL_TXBUF - off : used;
+  if(iov[0].iov_len < used) {       // ring wraps, second piece
+    iov[1].iov_base = p->tx;
+    iov[1].iov_len = used - iov[0].iov_len;
+    cnt = 2;
+  }
+  res = writev(fd, iov, cnt);
+  if(res == -1) return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+  if((unsigned int) res <= iov[0].iov_len) capture(fd, SERIAL_CAP_TX, iov[0].iov_base, res, NULL, 0);
+  else capture(fd, SERIAL_CAP_TX, iov[0].iov_base, iov[0].iov_len, p->tx, res - iov[0].iov_len);
+  p->txhead += res;
+  p->written += res;
+  return res;
+}
+
+/* ------------------------------------------------------------ *
+ * txwait() pushes the tx queue until it has no more than left  *
+ * bytes, waiting for the port to take data until the deadline. *
+ * Returns 1 when done, 0 on timeout, -1 on errors.             *
+ * ------------------------------------------------------------ */
+static int txwait(const int fd, serial_port *p, const unsigned int left, const unsigned int deadline) {
+  struct pollfd pfd;
+  int wait;
+
+  pfd.fd = fd;
+  pfd.events = POLLOUT;
+  while(1) {
+    if(push(fd, p) == -1) return -1;
+    if(p->txtail - p->txhead <= left) return 1;
+    wait = (int) (deadline - msec());
+    if(wait <= 0) return 0;
+    if(poll(&pfd, 1, wait) == -1 && errno != EINTR) return -1;
+  }
+}
+
+/* ------------------------------------------------------------ *
+ * fill() waits until deadline (msec() time) for data, and then *
+ * reads all queued bytes that fit into the buffer at once.     *
+ * Returns the bytes added, 0 on timeout, -1 on errors.         *
+ * ------------------------------------------------------------ */
+static int fill(const int fd, serial_port *p, const unsigned int deadline) {
+  struct pollfd pfd;
+  int wait, res;
+
+  if(p->head == p->tail) p->head = p->tail = 0;
+  if(p->tail == SERIAL_RXBUF) {     // move unread data to front
+    if(p->head == 0) return 0;      // buffer full
+    memmove(p->buf, p->buf + p->head, p->tail - p->head);
+    p->tail -= p->head;
+    p->head = 0;
+  }
+  pfd.fd = fd;
+  while(1) {
+    pfd.events = POLLIN;            // keep sending while we wait
+    if(p->txtail != p->txhead) pfd.events |= POLLOUT;
+    wait = (int) (deadline - msec());
+    if(wait < 0) wait = 0;
+    res = poll(&pfd, 1, wait);
+    if(res == -1 && errno == EINTR) continue;
+    if(res == -1) return -1;
+    if(res == 0) break;             // timeout, get bytes below VMIN
+    if((pfd.revents & POLLOUT) && push(fd, p) == -1) return -1;
+    if(pfd.revents & (POLLIN | POLLERR | POLLHUP)) break;
+  }
+  res = read(fd, p->buf + p->tail, SERIAL_RXBUF - p->tail);
+  if(res == -1) return (errno == EAGAIN || errno == EINTR) ? 0 : -1;
+  if(res > 0) capture(fd, SERIAL_CAP_RX, p->buf + p->tail, res, NULL, 0);
+  p->tail += res;
+  return res;
+}
+
+/* ------------------------------------------------------------ *
+ * lowlatency() sets or clears the kernel ASYNC_LOW_LATENCY     *
+ * flag. Drivers without TIOCSSERIAL (e.g. a pty) return -1.    *
+ * ------------------------------------------------------------ */
+static int lowlatency(const int fd, const int enabled) {
+  struct serial_struct ss;
+  if(ioctl(fd, TIOCGSERIAL, &ss) == -1) return -1;
+  if(enabled) ss.flags |= ASYNC_LOW_LATENCY;
+  else ss.flags &= ~ASYNC_LOW_LATENCY;
+  return ioctl(fd, TIOCSSERIAL, &ss);
+}
+
+/* ------------------------------------------------------------ *
+ * flowserial() turns RTS/CTS hardware flow control on or off.  *
+ * Returns 0 on success, -1 on errors.                          *
+ * ------------------------------------------------------------ */
+#ifdef CRTSXOFF
+#define SERIAL_FLOW_FLAGS (CRTSCTS | CRTSXOFF)
+#else
+#define SERIAL_FLOW_FLAGS (CRTSCTS)
+#endif
+int flowserial(const int fd, const int enabled) {
   struct termios options;
+  if(tcgetattr(fd, &options) == -1) return -1;
+  if(enabled) options.c_cflag |= SERIAL_FLOW_FLAGS;
+  else options.c_cflag &= ~SERIAL_FLOW_FLAGS;
+  return tcsetattr(fd, TCSANOW, &options);
+}
+
+/* ------------------------------------------------------------ *
+ * hubserial() connects to the serhubd socket for device, e.g.  *
+ * /run/serhub/ttySC1.sock (SERHUB_DIR overrides the dir). The  *
+ * hub owns the port, the socket fd works with all functions    *
+ * here, lockserial() uses the <name>.lock socket next to it.   *
+ * Returns the fd, -1 if no hub serves the device.              *
+ * ------------------------------------------------------------ */
+int hubserial(const char *device) {
+  struct sockaddr_un addr;
+  const char *dir = getenv("SERHUB_DIR");
+  const char *name = strrchr(device, '/');
+  serial_port *p;
+  int fd;
+
+  if(dir == NULL) dir = SERIAL_HUBDIR;
+  name = (name != NULL) ? name + 1 : device;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if(snprintf(addr.sun_path, sizeof(addr.sun_path), "%s/%s.sock", dir, name)
+     >= (int) sizeof(addr.sun_path)) return -1;
+  if(access(addr.sun_path, F_OK) == -1) return -1;
+  if((fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) == -1) return -1;
+  if(connect(fd, (struct sockaddr *) &addr, sizeof(addr)) == -1) {
+    close(fd);
+    return -1;
+  }
+  fcntl(fd, F_SETFL, O_NONBLOCK);
+  if((p = getport(fd)) != NULL) {
+    p->lockfd = -1;
+    memcpy(p->lockpath, addr.sun_path, sizeof(p->lockpath));
+    strcpy(p->lockpath + strlen(p->lockpath) - 5, ".lock");
+  }
+  return fd;
+}
+
+/* ------------------------------------------------------------ *
+ * lockpoll() reads the hub messages on the lock connection:    *
+ * 'L' = granted, 'W' = another program waits for the lock.     *
+ * Returns 1 once granted, 0 if nothing new, -1 if the hub has  *
+ * dropped the lock (lease expired or hub gone).                *
+ * ------------------------------------------------------------ */
+static int lockpoll(serial_port *p) {
+  char msg[16];
+  int i, n, granted = 0;
+
+  while((n = recv(p->lockfd, msg, sizeof(msg), MSG_DONTWAIT)) > 0) {
+    for(i = 0; i < n; i++) {
+      if(msg[i] == 'L') granted = 1;
+      if(msg[i] == 'W') p->contended = 1;
+    }
+  }
+  if(n == 0 || (n == -1 && errno != EAGAIN && errno != EINTR)) {
+    close(p->lockfd);
+    p->lockfd = -1;
+    p->contended = 0;
+    return -1;
+  }
+  return granted;
+}
+
+/* ------------------------------------------------------------ *
+ * lockserial() takes the serhubd port lock for lease ms, while *
+ * held the hub reads no data from other programs on the port,  *
+ * e.g. during XBee command mode. Called again it renews the    *
+ * lease. Waits for the lock until the deadline in msec() time, *
+ * data received until it is granted answered the last holder   *
+ * and is discarded.                                            *
+ * Returns 1 when held, 0 for a direct port or a hub without a  *
+ * lock socket (nothing to share), -1 on timeout or errors.     *
+ * ------------------------------------------------------------ */
+int lockserial(const int fd, const unsigned int lease, const unsigned int deadline) {
+  serial_port *p = getport(fd);
+  struct sockaddr_un addr;
+  struct pollfd pfd;
+  uint32_t ms = lease;
+  int wait, r;
+
+  if(p == NULL) return -1;
+  if(p->lockpath[0] == '\0') return 0;
+  if(p->lockfd != -1 && lockpoll(p) != -1)
+    return (send(p->lockfd, &ms, sizeof(ms), MSG_NOSIGNAL) == sizeof(ms)) ? 1 : -1;
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  memcpy(addr.sun_path, p->lockpath, sizeof(p->lockpath));
+  if((p->lockfd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0)) == -1) return -1;
+  if(connect(p->lockfd, (struct sockaddr *) &addr, sizeof(addr)) == -1
+     || send(p->lockfd, &ms, sizeof(ms), MSG_NOSIGNAL) != sizeof(ms)) {
+    r = (errno == ENOENT) ? 0 : -1;
+    unlockserial(fd);
+    return r;
+  }
+  pfd.fd = p->lockfd;
+  pfd.events = POLLIN;
+  while((wait = (int) (deadline - msec())) > 0) {
+    if(poll(&pfd, 1, wait) == -1 && errno != EINTR) break;
+    if((r = lockpoll(p)) == -1) return -1;
+    if(r == 1) {
+      p->head = p->tail = 0;
+      while(recv(fd, p->buf, sizeof(p->buf), MSG_DONTWAIT) > 0);
+      return 1;
+    }
+  }
+  unlockserial(fd);
+  return -1;
+}
+
+/* ------------------------------------------------------------ *
+ * unlockserial() releases the serhubd port lock, if held       *
+ * ------------------------------------------------------------ */
+void unlockserial(const int fd) {
+  serial_port *p = getport(fd);
+  if(p == NULL || p->lockpath[0] == '\0' || p->lockfd == -1) return;
+  close(p->lockfd);
+  p->lockfd = -1;
+  p->contended = 0;
+}
+
+/* ------------------------------------------------------------ *
+ * contendserial() returns 1 if another program waits for the   *
+ * port lock held by fd, 0 if not (or the lock is not held)     *
+ * ------------------------------------------------------------ */
+int contendserial(const int fd) {
+  serial_port *p = getport(fd);
+  if(p == NULL || p->lockpath[0] == '\0' || p->lockfd == -1) return 0;
+  lockpoll(p);
+  return p->contended;
+}
+
+/* ------------------------------------------------------------ *
+ * getserial() Opens and inits the serial port with the profile *
+ * baud rate, latency or throughput tuning, and flow control.   *
+ * SERIAL_LATENCY: poll() wakes for each byte (VMIN 1) and the  *
+ * driver sets ASYNC_LOW_LATENCY. SERIAL_THROUGHPUT: poll()     *
+ * wakes once SERIAL_VMIN bytes are queued, a shorter rest is   *
+ * picked up at the read deadline, ASYNC_LOW_LATENCY is off.    *
+ * RTS/CTS lets the SC16IS752 stop the sender before its 64     *
+ * byte FIFO overruns at high baud rates.                       *
+ * If serhubd owns the device the hub socket is returned, the   *
+ * hub then applies its own settings. profile.direct skips it.  *
+ * SERIAL_DEVICE replaces only the first device opened, and any *
+ * reopen of it, other ports of the program stay unchanged.     *
+ * Returns the fd, -1 on open errors, -2 for bad baud rates.    *
+ * ------------------------------------------------------------ */
+static char dev_first[256] = "";        // SERIAL_DEVICE target
+
+int getserial(const char *device, const serial_profile *profile) {
+  struct termios options;
+  serial_port *p;
   speed_t bps;
   int status, fd;
+  int baud = profile->baud;
+  const char *capfile = getenv("SERIAL_CAPTURE");
+
+  if(dev_first[0] == '\0') {
+    strncpy(dev_first, device, sizeof(dev_first) - 1);
+    dev_first[sizeof(dev_first) - 1] = '\0';
+  }
+  if(getenv("SERIAL_DEVICE") != NULL && strcmp(device, dev_first) == 0)
+    device = getenv("SERIAL_DEVICE");
+  if(capfile != NULL && cap_ring == NULL) capserial(capfile);
 
   /* --------------------------------------------------------- *
    * convert speed number into termios constants               *
@@ -58,11 +502,21 @@ int getserial(const char *device, const int baud) {
   }
 
   /* --------------------------------------------------------- *
-   * try to open the port read-write                           *
+   * attach to the hub if it serves this port, no guard time   *
+   * --------------------------------------------------------- */
+  if(!profile->direct && (fd = hubserial(device)) >= 0) {
+    if((p = getport(fd)) != NULL) p->baud = baud;
+    capture(fd, SERIAL_CAP_OPEN, device, strlen(device), NULL, 0);
+    return fd;
+  }
+
+  /* --------------------------------------------------------- *
+   * try to open the port read-write. The fd stays non-block-  *
+   * ing, reads wait in poll(), writes go through the tx queue *
    * --------------------------------------------------------- */
   if((fd=open(device, O_RDWR | O_NOCTTY
       | O_NDELAY | O_NONBLOCK)) == -1) return -1;
-  fcntl (fd, F_SETFL, O_RDWR);
+  if((p = getport(fd)) != NULL) p->baud = baud;
 
   /* --------------------------------------------------------- *
    * get current port params and modify                        *
@@ -79,38 +533,157 @@ int getserial(const char *device, const int baud) {
   options.c_cflag |= CS8;           // set char to 8bit
   options.c_lflag &= ~(ICANON | ECHO | ECHOE | ISIG);
   options.c_oflag &= ~OPOST;        // disable ext. output processing
-  options.c_cc [VMIN]  =   0;       // min chars for noncanonical read
-  options.c_cc [VTIME] = 100;	    // 10sec noncanonical read timeout
+  if(profile->rtscts) options.c_cflag |= SERIAL_FLOW_FLAGS;
+  else options.c_cflag &= ~SERIAL_FLOW_FLAGS;
+  /* --------------------------------------------------------- *
+   * VTIME must be 0, else poll() wakes on the first byte      *
+   * --------------------------------------------------------- */
+  options.c_cc [VMIN]  = (profile->mode == SERIAL_THROUGHPUT) ? SERIAL_VMIN : 1;
+  options.c_cc [VTIME] = 0;
 
   tcsetattr(fd, TCSANOW, &options); // apply changes immediately
+  lowlatency(fd, profile->mode == SERIAL_LATENCY);
   ioctl(fd, TIOCMGET, &status);
   status |= TIOCM_DTR;
   status |= TIOCM_RTS;
 
   ioctl (fd, TIOCMSET, &status);
   usleep(10000);                   // wait 10millisecs
+  capture(fd, SERIAL_CAP_OPEN, device, strlen(device), NULL, 0);
   return fd;
 }
 
 /* ------------------------------------------------------------ *
- * flushserial() empty out the tx and rx buffers                *
+ * flushserial() empty out the tx and rx buffers, this discards *
+ * unsent data. Use drainserial() to wait until it is sent.     *
+ * ------------------------------------------------------------ */
+void flushserial(const int fd){
+  serial_port *p = getport(fd);
+  tcflush(fd, TCIOFLUSH);
+  if(p != NULL) {
+    p->head = p->tail = 0;
+    p->txhead = p->txtail;
+  }
+}
+
+/* ------------------------------------------------------------ *
+ * closeserial() sends the queued data (up to SERIAL_TXWAIT ms) *
+ * then closes the serial port and releases the fd              *
+ * ------------------------------------------------------------ */
+void closeserial(const int fd) {
+  if(fd >= 0 && fd < SERIAL_MAXFD && ports[fd] != NULL) {
+    if(ports[fd]->txtail != ports[fd]->txhead)
+      drainserial(fd, msec() + SERIAL_TXWAIT);
+    unlockserial(fd);
+    free(ports[fd]);
+    ports[fd] = NULL;
+  }
+  close(fd);
+}
+
+/* ------------------------------------------------------------ *
+ * sendserial() queues len bytes for sending and writes what    *
+ * the port takes now. If the queue is full it waits for space  *
+ * until the deadline in msec() time, deadline msec() does not  *
+ * block. Returns the num bytes queued, less than len when the  *
+ * queue stayed full. -1 on errors.                             *
+ * ------------------------------------------------------------ */
+int sendserial(const int fd, const void *buf, const int len, const unsigned int deadline) {
+  serial_port *p = getport(fd);
+  unsigned int off;
+  int n = 0, chunk, res;
+
+  if(p == NULL) return -1;
+  while(n < len) {
+    if(p->txtail - p->txhead == SERIAL_TXBUF) {
+      if((res = txwait(fd, p, SERIAL_TXBUF - 1, deadline)) == -1) return -1;
+      if(res == 0) break;           // queue full until deadline
+    }
+    off = p->txtail % SERIAL_TXBUF;
+    chunk = SERIAL_TXBUF - (p->txtail - p->txhead);
+    if(chunk > SERIAL_TXBUF - off) chunk = SERIAL_TXBUF - off;
+    if(chunk > len - n) chunk = len - n;
+    memcpy(p->tx + off, (const char *) buf + n, chunk);
+    p->txtail += chunk;
+    n += chunk;
+  }
+  if(push(fd, p) == -1) return -1;
+  return n;
+}
+
+/* ------------------------------------------------------------ *
+ * pushserial() writes queued data without blocking, event      *
+ * loops call it when the fd polls POLLOUT. Returns the num     *
+ * bytes still queued (poll for POLLOUT while > 0), -1 errors.  *
+ * ------------------------------------------------------------ */
+int pushserial(const int fd) {
+  serial_port *p = getport(fd);
+  if(p == NULL || push(fd, p) == -1) return -1;
+  return p->txtail - p->txhead;
+}
+
+/* ------------------------------------------------------------ *
+ * pendserial() returns the num bytes not yet sent by the UART: *
+ * the tx queue plus the kernel output buffer (TIOCOUTQ).       *
+ * ------------------------------------------------------------ */
+int pendserial(const int fd) {
+  serial_port *p = getport(fd);
+  int outq;
+  if(p == NULL || ioctl(fd, TIOCOUTQ, &outq) == -1) return -1;
+  return outq + (p->txtail - p->txhead);
+}
+
+/* ------------------------------------------------------------ *
+ * sentserial() returns the total num bytes that have left the  *
+ * kernel buffer since open. Comparing it with the running sum  *
+ * of sendserial() returns tells when a message is on the wire. *
  * ------------------------------------------------------------ */
-void flushserial(const int fd){ tcflush(fd, TCIOFLUSH); }
+long long sentserial(const int fd) {
+  serial_port *p = getport(fd);
+  int outq;
+  if(p == NULL || ioctl(fd, TIOCOUTQ, &outq) == -1) return -1;
+  return p->written - outq;
+}
 
 /* ------------------------------------------------------------ *
- * closeserial() close the serial port and release the fd       *
+ * drainserial() waits until all queued data has left the UART, *
+ * or until the deadline in msec() time. The kernel buffer is   *
+ * checked with TIOCOUTQ, sleeping for its estimated send time, *
+ * tcdrain() then waits for the last bytes in the UART FIFO.    *
+ * Returns 0 when all data is sent, -1 on timeout and errors.   *
  * ------------------------------------------------------------ */
-void closeserial(const int fd) { close(fd); }
+int drainserial(const int fd, const unsigned int deadline) {
+  serial_port *p = getport(fd);
+  int outq, wait, est;
+
+  if(p == NULL || txwait(fd, p, 0, deadline) != 1) return -1;
+  while(1) {
+    if(ioctl(fd, TIOCOUTQ, &outq) == -1) return -1;
+    if(outq == 0) break;
+    wait = (int) (deadline - msec());
+    if(wait <= 0) return -1;
+    est = (p->baud > 0) ? outq * 10000 / p->baud + 1 : 1;
+    poll(NULL, 0, (est < wait) ? est : wait);
+  }
+  tcdrain(fd);
+  return 0;
+}
 
 /* ------------------------------------------------------------ *
- * charserial() sends one char to the serial port               *
+ * charserial() sends one char to the serial port, waiting up   *
+ * to SERIAL_TXWAIT ms if the tx queue is full.                 *
  * ------------------------------------------------------------ */
-void charserial(const int fd, const unsigned char c){ write(fd, &c, 1); }
+void charserial(const int fd, const unsigned char c){
+  sendserial(fd, &c, 1, msec() + SERIAL_TXWAIT);
+}
 
 /* ------------------------------------------------------------ *
- * strserial() writes a string to the serial port               *
+ * strserial() writes a string to the serial port, waiting up   *
+ * to SERIAL_TXWAIT ms if the tx queue is full.                 *
  * ------------------------------------------------------------ */
-void strserial(const int fd, const char *s) { write(fd, s, strlen(s)); }
+void strserial(const int fd, const char *s) {
+  sendserial(fd, s, strlen(s), msec() + SERIAL_TXWAIT);
+}
 
 /* ------------------------------------------------------------ *
  * prtserial() send a printf formatted string to the serial port*
@@ -128,8 +701,10 @@ void prtserial(const int fd, const char *message, ...) {
  * checkserial() returns num bytes waiting to be read from port *
  * ------------------------------------------------------------ */
 int checkserial(const int fd) {
+  serial_port *p = getport(fd);
   int res;
   if(ioctl (fd, FIONREAD, &res) == -1) return -1;
+  if(p != NULL) res += p->tail - p->head;
   return res;
 }
 
@@ -137,9 +712,197 @@ int checkserial(const int fd) {
  * getcharserial() get one char from the port. (10sec timeout)  *
  * ------------------------------------------------------------ */
 int getcharserial(const int fd) {
-  uint8_t x;
-  if(read (fd, &x, 1) != 1) return -1;
-  return ((int)x) & 0xFF;
+  serial_port *p = getport(fd);
+  if(p == NULL) return -1;
+  if(p->head == p->tail && fill(fd, p, msec() + 10000) <= 0) return -1;
+  return p->buf[p->head++];
+}
+
+/* ------------------------------------------------------------ *
+ * waitserial() waits until data is received, or until the      *
+ * deadline in msec() time. Returns the num bytes buffered, 0   *
+ * on timeout, -1 on errors.                                    *
+ * ------------------------------------------------------------ */
+int waitserial(const int fd, const unsigned int deadline) {
+  serial_port *p = getport(fd);
+  if(p == NULL) return -1;
+  if(p->head == p->tail && fill(fd, p, deadline) == -1) return -1;
+  return p->tail - p->head;
+}
+
+/* ------------------------------------------------------------ *
+ * readserial() reads exactly len bytes, waiting for them up to *
+ * the deadline in msec() time. Returns the num bytes read, it  *
+ * is less than len on timeout. -1 on errors.                   *
+ * ------------------------------------------------------------ */
+int readserial(const int fd, void *buf, const int len, const unsigned int deadline) {
+  serial_port *p = getport(fd);
+  int n = 0, chunk, res;
+
+  if(p == NULL) return -1;
+  while(n < len) {
+    if(p->head == p->tail) {
+      if((res = fill(fd, p, deadline)) == -1) return -1;
+      if(res == 0) break;           // timeout
+    }
+    chunk = p->tail - p->head;
+    if(chunk > len - n) chunk = len - n;
+    memcpy((char *) buf + n, p->buf + p->head, chunk);
+    p->head += chunk;
+    n += chunk;
+  }
+  return n;
+}
+
+/* ------------------------------------------------------------ *
+ * finddelim() returns the first of the splitter delimiters in  *
+ * s[0..n), or NULL. Each memchr() (SIMD in glibc) only has to  *
+ * search up to the best hit so far.                            *
+ * ------------------------------------------------------------ */
+static unsigned char *finddelim(unsigned char *s, int n, const serial_splitter *sp) {
+  unsigned char *hit, *best = NULL;
+  int i;
+  for(i = 0; i < sp->ndelims; i++) {
+    hit = memchr(s, sp->delims[i], best ? best - s : n);
+    if(hit != NULL) best = hit;
+  }
+  return best;
+}
+
+/* ------------------------------------------------------------ *
+ * frame() takes the next frame from the buffer into span.      *
+ * scanned carries the bytes already searched between calls.    *
+ * Returns 1 for a frame, 0 if it is not complete yet.          *
+ * ------------------------------------------------------------ */
+static int frame(serial_port *p, const serial_splitter *sp, int *scanned, serial_span *span) {
+  unsigned char *start = p->buf + p->head;
+  unsigned char *end;
+  int avail = p->tail - p->head;
+  int max = sp->maxframe;
+  int len, skip = 0;
+
+  if(max > SERIAL_RXBUF - 1 || max < 0) max = SERIAL_RXBUF - 1;
+  end = finddelim(start + *scanned, avail - *scanned, sp);
+  if(end != NULL && end - start <= max) {
+    len = end - start;
+    span->delim = *end;
+    skip = 1;                       // consume the delimiter
+    if(sp->keep) len++;
+  }
+  else if(end != NULL || avail >= max) {
+    len = max;                      // frame too long, cut it
+    span->delim = -1;
+  }
+  else {
+    *scanned = avail;
+    return 0;
+  }
+  span->data = (const char *) start;
+  span->len = len;
+  p->head += (sp->keep) ? len : len + skip;
+  *scanned = 0;
+  return 1;
+}
+
+/* ------------------------------------------------------------ *
+ * spanserial() returns the next frame from the receive buffer  *
+ * without copying, waiting for it until the deadline in msec() *
+ * time. The span points into the buffer, it stays valid until  *
+ * the next read call on fd. A frame ends with a splitter       *
+ * delimiter (span.delim), or is cut at maxframe bytes (delim   *
+ * -1). With flush, buffered bytes are returned as a partial    *
+ * frame (delim -1) at the deadline. Returns 1 for a frame, 0   *
+ * on timeout (partial data stays buffered), -1 on errors.      *
+ * ------------------------------------------------------------ */
+int spanserial(const int fd, const serial_splitter *sp, serial_span *span, const unsigned int deadline) {
+  serial_port *p = getport(fd);
+  int scanned = 0, res;
+
+  if(p == NULL) return -1;
+  while(frame(p, sp, &scanned, span) == 0) {
+    if((res = fill(fd, p, deadline)) == -1) return -1;
+    if(res == 0) {                  // timeout
+      if(!sp->flush || p->head == p->tail) return 0;
+      span->data = (const char *) p->buf + p->head;
+      span->len = p->tail - p->head;
+      span->delim = -1;
+      p->head = p->tail;
+      return 1;
+    }
+  }
+  return 1;
+}
+
+/* ------------------------------------------------------------ *
+ * spansserial() waits like spanserial() for the first frame,   *
+ * then returns all complete frames already received, up to max *
+ * spans. The spans stay valid until the next read call on fd.  *
+ * Returns the num spans, 0 on timeout, -1 on errors.           *
+ * ------------------------------------------------------------ */
+int spansserial(const int fd, const serial_splitter *sp, serial_span *spans, const int max, const unsigned int deadline) {
+  serial_port *p = getport(fd);
+  int n, scanned = 0;
+
+  if(p == NULL || max < 1) return -1;
+  if((n = spanserial(fd, sp, &spans[0], deadline)) != 1) return n;
+  while(n < max && frame(p, sp, &scanned, &spans[n]) == 1) n++;
+  return n;
+}
+
+/* ------------------------------------------------------------ *
+ * writespans() writes n spans to outfd (stdout or a file) with *
+ * writev(), sep (if not NULL) is added after each span.        *
+ * Returns the num bytes written, -1 on errors.                 *
+ * ------------------------------------------------------------ */
+int writespans(const int outfd, const serial_span *spans, const int n, const char *sep) {
+  struct iovec iov[SERIAL_MAXIOV];
+  int i = 0, cnt, sum = 0, res, seplen = (sep != NULL) ? strlen(sep) : 0;
+
+  while(i < n) {
+    for(cnt = 0; i < n && cnt < SERIAL_MAXIOV - 1; i++) {
+      iov[cnt].iov_base = (void *) spans[i].data;
+      iov[cnt++].iov_len = spans[i].len;
+      if(seplen > 0) {
+        iov[cnt].iov_base = (void *) sep;
+        iov[cnt++].iov_len = seplen;
+      }
+    }
+    res = 0;
+    while(cnt > 0) {                // handle partial writes
+      if((res = writev(outfd, iov, cnt)) == -1) {
+        if(errno == EINTR) continue;
+        return -1;
+      }
+      sum += res;
+      while(cnt > 0 && (size_t) res >= iov[0].iov_len) {
+        res -= iov[0].iov_len;
+        memmove(iov, iov + 1, --cnt * sizeof(struct iovec));
+      }
+      if(cnt > 0) {
+        iov[0].iov_base = (char *) iov[0].iov_base + res;
+        iov[0].iov_len -= res;
+      }
+    }
+  }
+  return sum;
+}
+
+/* ------------------------------------------------------------ *
+ * delimserial() reads up to the delimiter char, e.g. '\r', and *
+ * waits for it until the deadline in msec() time. The line is  *
+ * returned without delimiter and '\0' terminated, a line with  *
+ * size or more bytes is cut into size-1 pieces. Returns the    *
+ * line length, or -1 on timeout (partial data stays buffered)  *
+ * and errors.                                                  *
+ * ------------------------------------------------------------ */
+int delimserial(const int fd, char *buf, const int size, const char delim, const unsigned int deadline) {
+  serial_splitter sp = { { delim }, 1, size - 1, 0, 0 };
+  serial_span span;
+
+  if(size < 1 || spanserial(fd, &sp, &span, deadline) != 1) return -1;
+  memcpy(buf, span.data, span.len);
+  buf[span.len] = '\0';
+  return span.len;
 }
 
 /* ------------------------------------------------------------ *
@@ -0,0 +1,452 @@
+/* ------------------------------------------------------------ *
+ * file:        uart-bench.c                                    *
+ * purpose:     Serial throughput and latency benchmark. It     *
+ *              streams sequence-numbered, CRC'd packets from   *
+ *              port A to port B, and reports goodput, packet   *
+ *              loss, sequence gaps, duplicates and reordering, *
+ *              CRC errors and the inter-byte gap jitter.       *
+ *              A ping-pong of single packets (B echoes them    *
+ *              back to A) measures the round-trip latency.     *
+ *              It sweeps the baud rates, payload sizes and     *
+ *              flow control settings given on the command line *
+ *              with the latency or throughput serial profile.  *
+ *                                                              *
+ *               ttySC0 RX ---\/--- RX ttySC1                   *
+ *               ttySC0 TX ---/\--- TX ttySC1                   *
+ *                                                              *
+ *              With -p it runs over a pseudo-terminal pair,    *
+ *              no SC16IS752 needed. A pty never loses data, so *
+ *              lost, duplicate or reordered packets then count *
+ *              as an error.                                    *
+ *                                                              *
+ * return:      0 on success, and -1 on errors.                 *
+ * compile:     see Makefile                                    *
+ * example:     ./uart-bench -s 115200,921600 -l 16,256 -f none *
+ *              ./uart-bench -p                                 *
+ *                                                              *
+ * author:      10/17/2026 Frank4DD                             *
+ * ------------------------------------------------------------ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <math.h>
+#include <time.h>
+#include <termios.h>
+#include "serial.h"
+
+#define UART1      "/dev/ttySC0"
+#define UART2      "/dev/ttySC1"
+#define SYNC1      0x55         // packet start bytes
+#define SYNC2      0xAA
+#define HDRLEN     8            // sync(2) seq(4) len(2)
+#define CRCLEN     2            // CRC-16/CCITT over seq..payload
+#define MAXPAYLOAD 1024
+#define MAXPKT     (HDRLEN + MAXPAYLOAD + CRCLEN)
+#define PINGS      10           // round trips per run
+
+/* ------------------------------------------------------------ *
+ * receive side packet parser state                             *
+ * ------------------------------------------------------------ */
+typedef struct {
+   unsigned char buf[SERIAL_RXBUF + MAXPKT];
+   int len;                     // bytes in buf
+   long good;                   // packets with valid CRC
+   long crcerr;                 // packets with CRC mismatch
+   long skipped;                // bytes dropped to resync
+   uint32_t seq;                // last good sequence number
+   uint32_t next;               // expected sequence number
+   unsigned char *seen;         // bitmap of received seq numbers
+   uint32_t packets;            // seq numbers sent, bits in seen
+   long unique;                 // packets received at least once
+   long seqgap;                 // missing seq numbers, before next
+   long dup;                    // packets received again
+   long reorder;                // late packets, filled a gap
+   long long bytes;             // raw bytes received
+   long long last;              // last arrival, ns
+   double gapsum, gapsq;        // per-byte gaps between reads
+   long gaps;
+   double gapmax;               // longest pause between reads
+} bench_rx;
+
+int fdA = -1, fdB = -1;         // sending and receiving port
+int ptymode = 0;
+int seconds = 2;                // stream time per run
+int maxpackets = 10000;
+int mode = SERIAL_LATENCY;      // -m throughput for SERIAL_VMIN wakeups
+
+/* ------------------------------------------------------------ *
+ * nsec() returns CLOCK_MONOTONIC time in nanoseconds           *
+ * ------------------------------------------------------------ */
+static long long nsec(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* ------------------------------------------------------------ *
+ * crc16() CRC-16/CCITT-FALSE, poly 0x1021 init 0xFFFF          *
+ * ------------------------------------------------------------ */
+static uint16_t crc16(const unsigned char *data, int len) {
+   uint16_t crc = 0xFFFF;
+   int i;
+   while(len--) {
+      crc ^= *data++ << 8;
+      for(i = 0; i < 8; i++)
+         crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+   }
+   return crc;
+}
+
+/* ------------------------------------------------------------ *
+ * mkpacket() builds packet seq with a seq-dependent payload    *
+ * pattern, so shifted or repeated data fails the CRC check.    *
+ * Returns the packet length.                                   *
+ * ------------------------------------------------------------ */
+static int mkpacket(unsigned char *pkt, uint32_t seq, int size) {
+   uint16_t crc;
+   int i;
+
+   pkt[0] = SYNC1;
+   pkt[1] = SYNC2;
+   memcpy(pkt + 2, &seq, 4);
+   pkt[6] = size & 0xFF;
+   pkt[7] = size >> 8;
+   for(i = 0; i < size; i++) pkt[HDRLEN + i] = seq * 31 + i;
+   crc = crc16(pkt + 2, HDRLEN - 2 + size);
+   pkt[HDRLEN + size] = crc & 0xFF;
+   pkt[HDRLEN + size + 1] = crc >> 8;
+   return HDRLEN + size + CRCLEN;
+}
+
+/* ------------------------------------------------------------ *
+ * sequence() checks the seq number of a good packet. A jump    *
+ * ahead counts the skipped numbers as gap, a number below the  *
+ * expected one is a duplicate if it was seen before, else a    *
+ * late (reordered) packet that closes one gap.                 *
+ * ------------------------------------------------------------ */
+static void sequence(bench_rx *rx) {
+   uint32_t s = rx->seq;
+
+   if(s >= rx->packets || (rx->seen[s / 8] & (1 << (s % 8)))) {
+      rx->dup++;
+      return;
+   }
+   rx->seen[s / 8] |= 1 << (s % 8);
+   rx->unique++;
+   if(s >= rx->next) {
+      rx->seqgap += s - rx->next;
+      rx->next = s + 1;
+   }
+   else {
+      rx->reorder++;
+      rx->seqgap--;
+   }
+}
+
+/* ------------------------------------------------------------ *
+ * getpacket() takes one packet from the front of the parser    *
+ * buffer. Garbage before a sync is skipped. Returns 1 for a    *
+ * good packet, 0 if more data is needed.                       *
+ * ------------------------------------------------------------ */
+
+static int getpacket(bench_rx *rx) {
+   int size, plen, drop;
+   uint16_t crc;
+
+   while(rx->len >= HDRLEN) {
+      if(rx->buf[0] != SYNC1 || rx->buf[1] != SYNC2
+         || (size = rx->buf[6] | rx->buf[7] << 8) > MAXPAYLOAD) {
+         drop = 1;                             // resync
+         rx->skipped++;
+      }
+      else {
+         plen = HDRLEN + size + CRCLEN;
+         if(rx->len < plen) return 0;
+         crc = rx->buf[plen - 2] | rx->buf[plen - 1] << 8;
+         if(crc == crc16(rx->buf + 2, plen - 4)) {
+            memcpy(&rx->seq, rx->buf + 2, 4);
+            rx->good++;
+            sequence(rx);
+            drop = plen;
+         }
+         else {                                // damaged, resync
+            rx->crcerr++;
+            drop = 2;
+         }
+      }
+      rx->len -= drop;
+      memmove(rx->buf, rx->buf + drop, rx->len);
+      if(drop > 2) return 1;
+   }
+   return 0;
+}
+
+/* ------------------------------------------------------------ *
+ * receive() moves all data buffered for port B into the parser *
+ * and records the arrival gaps. Returns the good packets.      *
+ * ------------------------------------------------------------ */
+static int receive(bench_rx *rx) {
+   long long now;
+   double gap;
+   int n, packets = 0;
+
+   while((n = readserial(fdB, rx->buf + rx->len, sizeof(rx->buf) - rx->len, msec())) > 0) {
+      now = nsec();
+      if(rx->last != 0) {
+         gap = (now - rx->last) / 1000.0;      // us
+         if(gap > rx->gapmax) rx->gapmax = gap;
+         gap /= n;
+         rx->gapsum += gap;
+         rx->gapsq += gap * gap;
+         rx->gaps++;
+      }
+      rx->last = now;
+      rx->bytes += n;
+      rx->len += n;
+      while(getpacket(rx) == 1) packets++;
+   }
+   return (n == -1) ? -1 : packets;
+}
+
+/* ------------------------------------------------------------ *
+ * openports() opens A and B, or a pty master (A) and slave (B) *
+ * ------------------------------------------------------------ */
+static int openports(const char *portA, const char *portB, const serial_profile *profile) {
+   struct termios options;
+   int master;
+
+   if(ptymode) {
+      if((master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK)) == -1
+         || grantpt(master) == -1 || unlockpt(master) == -1) return -1;
+      tcgetattr(master, &options);
+      cfmakeraw(&options);
+      tcsetattr(master, TCSANOW, &options);
+      fdA = master;
+      portB = ptsname(master);
+   }
+   else if((fdA = getserial(portA, profile)) < 0) {
+      printf("Error opening port %s %d Baud\n", portA, profile->baud);
+      return -1;
+   }
+   if((fdB = getserial(portB, profile)) < 0) {
+      printf("Error opening port %s %d Baud\n", portB, profile->baud);
+      closeserial(fdA);
+      return -1;
+   }
+   return 0;
+}
+
+/* ------------------------------------------------------------ *
+ * closeports() discards leftovers so close does not wait       *
+ * ------------------------------------------------------------ */
+static void closeports(void) {
+   flushserial(fdA);
+   flushserial(fdB);
+   closeserial(fdA);
+   closeserial(fdB);
+}
+
+/* ------------------------------------------------------------ *
+ * stream() sends packets A->B as fast as the ports take them,  *
+ * B is read in the same poll loop. The run ends when all were  *
+ * received, or nothing arrived for idle ms. Returns the num    *
+ * packets never received, -1 on errors.                        *
+ * ------------------------------------------------------------ */
+static long stream(bench_rx *rx, int baud, int size, long packets, double *goodput) {
+   static unsigned char pkt[MAXPKT];
+   struct pollfd pfd[2];
+   long long start, end;
+   unsigned int last;
+   int plen = 0, off = 0, n, idle;
+   uint32_t seq = 0;
+
+   idle = 500 + (ptymode ? 0 : MAXPKT * 10000 / baud);
+   start = nsec();
+   last = msec();
+   while(rx->unique < packets) {
+      /* ------------------------------------------------------ *
+       * queue packets until the tx queue is full               *
+       * ------------------------------------------------------ */
+      while(seq < packets || off < plen) {
+         if(off == plen) {
+            plen = mkpacket(pkt, seq++, size);
+            off = 0;
+         }
+         if((n = sendserial(fdA, pkt + off, plen - off, msec())) == -1) return -1;
+         off += n;
+         if(off < plen) break;                 // queue full
+      }
+      pfd[0].fd = fdA;
+      pfd[0].events = (pushserial(fdA) > 0) ? POLLOUT : 0;
+      pfd[1].fd = fdB;
+      pfd[1].events = POLLIN;
+      if(poll(pfd, 2, 10) == -1) continue;
+      if((n = receive(rx)) == -1) return -1;
+      if(n > 0 || rx->len > 0) last = msec();
+      else if(seq == packets && off == plen && msec() - last > (unsigned int) idle) break;
+   }
+   end = (rx->last > 0) ? rx->last : nsec();
+   *goodput = rx->unique * (double) size * 1.0e9 / (end - start);
+   return packets - rx->unique;
+}
+
+/* ------------------------------------------------------------ *
+ * ping() sends one packet A->B, B echoes it, A receives it.    *
+ * Returns the round-trip time in ms, -1 on timeout.            *
+ * ------------------------------------------------------------ */
+static double ping(uint32_t seq, int size, int baud) {
+   static unsigned char pkt[MAXPKT], echo[MAXPKT];
+   unsigned int deadline;
+   long long start;
+   int plen;
+
+   plen = mkpacket(pkt, seq, size);
+   deadline = msec() + 1000 + (ptymode ? 0 : 2 * plen * 10000 / baud);
+   start = nsec();
+   if(sendserial(fdA, pkt, plen, deadline) != plen) return -1;
+   if(readserial(fdB, echo, plen, deadline) != plen) return -1;
+   if(sendserial(fdB, echo, plen, deadline) != plen) return -1;
+   if(readserial(fdA, echo, plen, deadline) != plen) return -1;
+   if(memcmp(pkt, echo, plen) != 0) return -1;
+   return (nsec() - start) / 1.0e6;
+}
+
+/* ------------------------------------------------------------ *
+ * run() benchmarks one baud / size / flow setting, and prints  *
+ * the result line. Returns the lost, duplicate and reordered   *
+ * packets, -1 on errors.                                       *
+ * ------------------------------------------------------------ */
+static long run(const char *portA, const char *portB, int baud, int size, int flow) {
+   serial_profile profile = { baud, mode, flow, 1 }; // direct, not serhubd speed
+   static bench_rx rx;
+   double goodput = 0, rtt, rttmin = 0, rttmax = 0, rttsum = 0;
+   double gapavg = 0, gapsd = 0;
+   long packets, lost;
+   int i, pings = 0;
+
+   if(openports(portA, portB, &profile) == -1) return -1;
+   memset(&rx, 0, sizeof(rx));
+
+   /* --------------------------------------------------------- *
+    * packets for about seconds at the line rate, 10 bits/byte  *
+    * --------------------------------------------------------- */
+   packets = (long) seconds * baud / 10 / (HDRLEN + size + CRCLEN);
+   if(ptymode || packets > maxpackets) packets = maxpackets;
+   if(packets < 1) packets = 1;
+   rx.packets = packets;
+   if((rx.seen = calloc((packets + 7) / 8, 1)) == NULL) {
+      closeports();
+      return -1;
+   }
+
+   lost = stream(&rx, baud, size, packets, &goodput);
+   free(rx.seen);
+   if(lost == -1) {
+      printf("Error: serial I/O failed\n");
+      closeports();
+      return -1;
+   }
+   if(rx.gaps > 0) {
+      gapavg = rx.gapsum / rx.gaps;
+      gapsd = sqrt(fabs(rx.gapsq / rx.gaps - gapavg * gapavg));
+   }
+
+   flushserial(fdA);
+   flushserial(fdB);
+   for(i = 0; i < PINGS; i++) {
+      if((rtt = ping(i, size, baud)) < 0) {
+         flushserial(fdA);
+         flushserial(fdB);
+         continue;
+      }
+      if(pings == 0 || rtt < rttmin) rttmin = rtt;
+      if(rtt > rttmax) rttmax = rtt;
+      rttsum += rtt;
+      pings++;
+   }
+   closeports();
+
+   if(ptymode) printf("%8s", "pty");
+   else printf("%8d", baud);
+   printf(" %5d %-6s %7ld %11.0f", size, flow ? "rtscts" : "none", packets, goodput);
+   if(ptymode) printf("     -");
+   else printf(" %5.1f", goodput * 10 * 100.0 / baud);
+   printf(" %6ld %4ld %4ld %4ld %4ld %5ld %8.1f %7.1f %8.1f", lost, rx.seqgap, rx.dup, rx.reorder,
+          rx.crcerr, rx.skipped, gapavg, gapsd, rx.gapmax);
+   if(pings > 0) printf(" %7.2f %7.2f %7.2f", rttmin, rttsum / pings, rttmax);
+   else printf("     timeout");
+   if(pings < PINGS) printf(" (%d/%d)", pings, PINGS);
+   printf("\n");
+   return lost + rx.dup + rx.reorder + PINGS - pings;
+}
+
+int main(int argc, char *argv[]) {
+   char *portA = UART1, *portB = UART2;
+   char *bauds = "9600,115200,921600";
+   char *sizes = "16,64,256";
+   char *flows = "none";
+   char *s1, *s2, *s3, *p1, *p2, *p3, *b, *l, *f;
+   long lost, losses = 0;
+   int arg, size;
+
+   while ((arg = getopt(argc, argv, "a:b:s:l:f:m:n:t:ph")) != -1) {
+      switch (arg) {
+         case 'a': portA = optarg; break;
+         case 'b': portB = optarg; break;
+         case 's': bauds = optarg; break;
+         case 'l': sizes = optarg; break;
+         case 'f': flows = optarg; break;
+         case 'n': maxpackets = atoi(optarg); break;
+         case 't': seconds = atoi(optarg); break;
+         case 'm': mode = (strcmp(optarg, "throughput") == 0) ? SERIAL_THROUGHPUT : SERIAL_LATENCY; break;
+         case 'p': ptymode = 1; break;
+         default:
+            printf("Usage: ./uart-bench [-a port] [-b port] [-s baud,..] [-l size,..]\n");
+            printf("                    [-f none,rtscts] [-m latency|throughput]\n");
+            printf("                    [-n max packets] [-t secs] [-p]\n");
+            return -1;
+      }
+   }
+   if(ptymode) {
+      printf("UART benchmark on a pty pair, %d packets per run", maxpackets);
+      bauds = "115200";                        // pty has no line rate
+   }
+   else printf("UART benchmark %s -> %s, %d s per run", portA, portB, seconds);
+   printf(", %s profile\n", (mode == SERIAL_THROUGHPUT) ? "throughput" : "latency");
+   printf("    baud  size flow   packets goodput B/s  eff%%   lost miss  dup  ooo  crc  skip");
+   printf(" gap us/B      sd   max us rtt min     avg     max\n");
+
+   /* --------------------------------------------------------- *
+    * sweep all baud / size / flow control combinations         *
+    * --------------------------------------------------------- */
+   s1 = strdup(bauds);
+   for(b = strtok_r(s1, ",", &p1); b != NULL; b = strtok_r(NULL, ",", &p1)) {
+      s2 = strdup(sizes);
+      for(l = strtok_r(s2, ",", &p2); l != NULL; l = strtok_r(NULL, ",", &p2)) {
+         size = atoi(l);
+         if(size < 1 || size > MAXPAYLOAD) {
+            printf("Error: payload size %s not in 1..%d\n", l, MAXPAYLOAD);
+            return -1;
+         }
+         s3 = strdup(flows);
+         for(f = strtok_r(s3, ",", &p3); f != NULL; f = strtok_r(NULL, ",", &p3)) {
+            if((lost = run(portA, portB, atoi(b), size, strcmp(f, "rtscts") == 0)) == -1)
+               return -1;
+            losses += lost;
+         }
+         free(s3);
+      }
+      free(s2);
+   }
+   free(s1);
+   if(ptymode && losses > 0) {
+      printf("Error: %ld packets lost or out of sequence on the pty\n", losses);
+      return -1;
+   }
+   return 0;
+}
@@ -3,6 +3,7 @@
  * purpose:     Sample program to test serial communication for *
  *              SC16IS752 ports /dev/ttySC0 and /dev/ttySC1.    *
  *              uart-receive prints received serial data        *
+ *              until the '~' char, in bulk through a splitter. *
  *                                                              *
  *               ttySC0 RX ---\/--- RX ttySC1 --> uart-receive  *
  * uart-send --> ttySC0 TX ---/\--- TX ttySC1                   *
@@ -24,6 +25,7 @@
 #define UART1    "/dev/ttySC0"
 #define UART2    "/dev/ttySC1"
 #define SPEED    115200
+#define SPANS    16
 
 int fd;
 
@@ -35,9 +37,12 @@ void  Handler(int signo){
 }
 
 int main(void) {
-  char str;
+  serial_profile profile = { SPEED, SERIAL_LATENCY, 0 };
+  serial_splitter splitter = { "~", 1, SERIAL_RXBUF - 1, 1, 1 };
+  serial_span spans[SPANS];
+  int i, n, done = 0;
 
-  if((fd=getserial(UART2, SPEED)) < 0) {
+  if((fd=getserial(UART2, &profile)) < 0) {
     printf("Error opening port %s\n", UART2);
     return -1;
   }
@@ -45,17 +50,21 @@ int main(void) {
   printf("%s [%d] receive: ", UART2, SPEED);
   fflush(stdout);
   signal(SIGINT, Handler); // Exception handling:ctrl+c
-  for (;;) {
-    str = getcharserial(fd);
-    //putchar(str) ;
-    printf("%c", str);
-    fflush(stdout);
-
-    if(str == '~'){
-      printf("\r\n");
-      break;
+  /* --------------------------------------------------------- *
+   * print the received spans with one write, partial lines    *
+   * come out after 100ms (flush), the '~' span ends the loop  *
+   * --------------------------------------------------------- */
+  while(!done) {
+    if((n = spansserial(fd, &splitter, spans, SPANS, msec() + 100)) == -1) break;
+    for(i = 0; i < n; i++) {
+      if(spans[i].delim == '~') {
+        n = i + 1;
+        done = 1;
+      }
     }
+    writespans(STDOUT_FILENO, spans, n, NULL);
   }
+  printf("\r\n");
   closeserial(fd);
   return 0;
 }
@@ -22,8 +22,9 @@
 #define SPEED 115200
 
 int main(void) {
+  serial_profile profile = { SPEED, SERIAL_LATENCY, 0 };
   int fd;
-  if((fd=getserial(UART1, SPEED)) < 0){
+  if((fd=getserial(UART1, &profile)) < 0){
     printf("Error opening port %s\n", UART1);
     return -1;
   }
@@ -32,8 +32,9 @@ int speed    = 115200;         // XBee modified speed
 
 int main(void) {
    int fd;                      // serial port file descriptor
-   int i;                       // loop counter
-   int wait;                    // serail bytes waiting
+   int len;                     // reply length, -1 = timeout
+   unsigned int start;          // reply wait start in ms
+   serial_profile profile = { speed, SERIAL_LATENCY, 0, 1 }; // direct, probes this baud
    char response[1024] = "";    // serial response string
 
    printf("XBee DEV open: %s %dB\n", port, speed);
@@ -41,7 +42,7 @@ int main(void) {
 /* ------------------------------------------------------------ *
  * open serial port                                             *
  * ------------------------------------------------------------ */
-   if((fd=getserial(port, speed)) < 0) {
+   if((fd=getserial(port, &profile)) < 0) {
       printf("Error opening port %s %d Baud\n", port, speed);
       return -1;
    }
@@ -55,82 +56,46 @@ int main(void) {
    if(verbose == 1) printf("Debug: %s send +++\n", port);
 
 /* ------------------------------------------------------------ *
- * wait guard time, and check if 3 bytes response is received   *
+ * wait up to 3 seconds for the '\r' terminated reply, the      *
+ * carriage return is not copied into the response string.      *
  * ------------------------------------------------------------ */
-   i = 0; wait = 0;
-   while((wait = checkserial(fd)) == 0) {
-      usleep(250000);     // waith another quarter second
-      if(i>12) break;     // stop waiting after 3 seconds
-      i++;
-   }
-   if(verbose == 1) printf("Debug: %s got %d bytes after %d ms\n", port, wait, i*250);
+   start = msec();
+   len = delimserial(fd, response, sizeof(response), '\r', start + 3000);
+   if(verbose == 1) printf("Debug: %s got %d bytes after %u ms\n", port, len, msec() - start);
 
 /* ------------------------------------------------------------ *
  * If there is no response, we have XBee communication failure  *
  * Either no XBee is connected, or XBee is on different speed.  *
  * ------------------------------------------------------------ */
-   if(wait == 0) {
+   if(len == -1) {
       printf("Error: No XBee responding\n");
       return -1;
    }
 
-/* ------------------------------------------------------------ *
- * retrieve the reply chars and save them into response string  *
- * ------------------------------------------------------------ */
-   i = 0;
-   for (i=0; i<1024; i++) {
-      if(checkserial(fd)>0) response[i] = getcharserial(fd);
-      else break;
-   }
-/* ------------------------------------------------------------ *
- * Eliminate '\r' carriage return from response last char       *
- * ------------------------------------------------------------ */
-   i--;                                        // back to last char
-   if(response[i] == '\r') response[i] = '\0'; // eliminate '\r'
-
 /* ------------------------------------------------------------ *
  * display response string                                      *
  * ------------------------------------------------------------ */
-   if(verbose == 1) printf("Debug: port %s reply: %s (%d bytes)\n", port, response, i);
+   if(verbose == 1) printf("Debug: port %s reply: %s (%d bytes)\n", port, response, len);
    if(strcmp(response, "OK") == 0) printf("XBee CMD mode: OK\n");
 
 /* ------------------------------------------------------------ *
  * Send ATSL command to get lower device address                *
  * ------------------------------------------------------------ */
    strserial(fd, "ATSL\r");
-   wait = checkserial(fd);
    if(verbose == 1) printf("Debug: %s send ATSL\\r\n", port);
 
 /* ------------------------------------------------------------ *
  * Check if a response is received, wait up to 3 seconds        *
  * ------------------------------------------------------------ */
-   i = 0;
-   while((wait = checkserial(fd)) == 0) {
-      usleep(250000);     // waith another quarter second
-      if(i>12) break;     // stop waiting after 3 seconds
-      i++;
-   }
-   if(verbose == 1) printf("Debug: %s got %d bytes after %d ms\n", port, wait, i*250);
-
-/* ------------------------------------------------------------ *
- * retrieve the reply chars and save them into response string  *
- * ------------------------------------------------------------ */
-   response[0] = '\0';
-   for (i=0; i<1024; i++) {
-      if(checkserial(fd)>0) response[i] = getcharserial(fd);
-      else break;
-   }
-
-/* ------------------------------------------------------------ *
- * Eliminate '\r' carriage return from response last char       *
- * ------------------------------------------------------------ */
-   i--;                                        // back to last char
-   if(response[i] == '\r') response[i] = '\0'; // eliminate '\r'
+   start = msec();
+   len = delimserial(fd, response, sizeof(response), '\r', start + 3000);
+   if(len == -1) response[0] = '\0';
+   if(verbose == 1) printf("Debug: %s got %d bytes after %u ms\n", port, len, msec() - start);
 
 /* ------------------------------------------------------------ *
  * display response string                                      *
  * ------------------------------------------------------------ */
-   if(verbose == 1) printf("Debug: port %s reply: %s (%d bytes)\n", port, response, i);
+   if(verbose == 1) printf("Debug: port %s reply: %s (%d bytes)\n", port, response, len);
    printf("Xbee cmd ATSL: [%s]\n", response);
 
 /* ------------------------------------------------------------ *
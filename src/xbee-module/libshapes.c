@@ -20,6 +20,7 @@
 #include "NotoMono.inc"
 #include "eglstate.h"					   // data structures for graphics state
 #include "fontinfo.h"					   // font data structure
+#include "tft-latency.h"				   // button-to-photon timing
 
 static STATE_T _state, *state = &_state;	// global graphics state
 static const int MAXFONTPATH = 500;
@@ -652,7 +653,9 @@ void Start(int width, int height) {
 // End checks for errors, and renders to the display
 void End() {
 	assert(vgGetError() == VG_NO_ERROR);
+	lat_drawn();
 	eglSwapBuffers(state->display, state->surface);
+	lat_swapped();
 	assert(eglGetError() == EGL_SUCCESS);
 }
 
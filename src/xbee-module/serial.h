@@ -1,4 +1,67 @@
-extern int getserial(const char *device, const int speed);
+#include <stdint.h>
+
+#define SERIAL_MAXFD 256          // highest fd + 1 with a buffer
+#define SERIAL_RXBUF 4096         // receive buffer size per port
+#define SERIAL_TXBUF 4096         // transmit queue size, power of 2
+#define SERIAL_TXWAIT 10000       // ms charserial() waits on a full queue
+#define SERIAL_VMIN 32            // throughput: wake per 32 bytes (FIFO/2)
+
+#define SERIAL_LATENCY 0          // wake on each byte, low latency flag
+#define SERIAL_THROUGHPUT 1       // wake per SERIAL_VMIN bytes
+
+typedef struct {
+  int baud;                       // line speed, 50 .. 4000000
+  int mode;                       // SERIAL_LATENCY or SERIAL_THROUGHPUT
+  int rtscts;                     // 1 = RTS/CTS hardware flow control
+  int direct;                     // 1 = open the device, not serhubd
+} serial_profile;
+
+#define SERIAL_MAXDELIM 8         // delimiters per splitter
+#define SERIAL_MAXIOV 64          // iovecs per writev() in writespans()
+#define SERIAL_HUBDIR "/run/serhub" // serhubd sockets, SERHUB_DIR overrides
+#define SERIAL_CAPRING (1 << 20)  // capture ring bytes, power of 2
+#define SERIAL_CAPWAIT 10         // ms between capture file writes
+#define SERIAL_CAPMAGIC "SCAP"
+#define SERIAL_CAPVERSION 1
+#define SERIAL_CAP_RX 0           // data read from the port
+#define SERIAL_CAP_TX 1           // data written to the port
+#define SERIAL_CAP_OPEN 2         // port opened, data = device name
+
+typedef struct {
+  char delims[SERIAL_MAXDELIM];   // frame end chars, e.g. "\r\n"
+  int ndelims;                    // num chars used in delims
+  int maxframe;                   // longer frames are cut, max RXBUF-1
+  int keep;                       // 1 = the span includes the delimiter
+  int flush;                      // 1 = partial frame at the deadline
+} serial_splitter;
+
+typedef struct {
+  const char *data;               // frame start in the receive buffer
+  int len;                        // frame length
+  int delim;                      // delimiter found, -1 = cut or partial
+} serial_span;
+
+typedef struct {                  // capture file header
+  char magic[4];                  // "SCAP"
+  uint32_t version;
+  int64_t start;                  // CLOCK_REALTIME ns at start
+} serial_capheader;
+
+typedef struct {                  // capture record, len data bytes follow
+  uint64_t time;                  // ns since capture start, monotonic
+  uint32_t lost;                  // records dropped before this one
+  uint16_t len;
+  uint8_t type;                   // SERIAL_CAP_RX, _TX or _OPEN
+  uint8_t fd;
+} serial_caprec;
+
+extern int getserial(const char *device, const serial_profile *profile);
+extern int flowserial(const int fd, const int enabled);
+extern int hubserial(const char *device);
+extern int lockserial(const int fd, const unsigned int lease, const unsigned int deadline);
+extern void unlockserial(const int fd);
+extern int contendserial(const int fd);
+extern int capserial(const char *file);
 extern void closeserial(const int fd);
 extern void flushserial(const int fd);
 extern void charserial(const int fd, const unsigned char c);
@@ -7,3 +70,14 @@ extern void prtserial(const int fd, const char *msg, ...);
 extern int checkserial(const int fd);
 extern int getcharserial(const int fd);
 extern unsigned int msec(void);
+extern int waitserial(const int fd, const unsigned int deadline);
+extern int readserial(const int fd, void *buf, const int len, const unsigned int deadline);
+extern int delimserial(const int fd, char *buf, const int size, const char delim, const unsigned int deadline);
+extern int spanserial(const int fd, const serial_splitter *sp, serial_span *span, const unsigned int deadline);
+extern int spansserial(const int fd, const serial_splitter *sp, serial_span *spans, const int max, const unsigned int deadline);
+extern int writespans(const int outfd, const serial_span *spans, const int n, const char *sep);
+extern int sendserial(const int fd, const void *buf, const int len, const unsigned int deadline);
+extern int pushserial(const int fd);
+extern int pendserial(const int fd);
+extern long long sentserial(const int fd);
+extern int drainserial(const int fd, const unsigned int deadline);
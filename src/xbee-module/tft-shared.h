@@ -5,10 +5,7 @@ void tftbottom(const char *addr, const char *mask);
 uint8_t sw_detect();
 uint32_t time_elapsed(struct timespec);
 
-#define SW1_UP          21
-#define SW2_MODE        22
-#define SW3_DOWN        23
-#define SW4_ENTER       24
+#include "buttons.h"
 
 #ifndef TRUE
 #define TRUE true
@@ -15,7 +15,6 @@
 #include <VG/openvg.h>
 #include <VG/vgu.h>
 #include <stdbool.h>
-#include <wiringPi.h>
 #include "fontinfo.h"
 #include "shapes.h"
 #include "ip.h"
@@ -47,7 +46,7 @@ int main() {
    uint32_t volt_interval = 300;           // volt refresh interval in milliseconds
    uint32_t ms_elapsed;                    // time since last measurement
    struct timespec refts;                  // reference time for update interval
-   char response[8];                       // serial byte response for voltage read
+   char response[XBEE_REPLY];              // serial byte response for voltage read
    int fd;
    uint8_t swstate = 0;                    // button press status
    bool runstate = FALSE;
@@ -55,13 +54,9 @@ int main() {
    uint8_t i = 0;
 
    /* --------------------------------------------------------- *
-    * Setup GPIO pins for button control                        *
+    * Setup button edge events                                  *
     * --------------------------------------------------------- */
-   wiringPiSetup ();
-   pinMode (SW1_UP,    INPUT);  // SW1 Up
-   pinMode (SW2_MODE,  INPUT);  // SW2 Mode
-   pinMode (SW3_DOWN,  INPUT);  // SW3 Down
-   pinMode (SW4_ENTER, INPUT);  // SW4 Enter
+   if(btn_open(BTN_DEBOUNCE) == -1) exit(-1);
 
    /* --------------------------------------------------------- *
     * Setup display control. Get IP and Netmask.                *
@@ -105,6 +100,7 @@ int main() {
       }
       else if(prgstat == 1) {
          Image(10, 170, 460, 66, XBEELOGO_PATH);// load XBee logo
+         xbee_api = XBEE_API_ESCAPED;           // AT cmds without +++
          fd = xbee_enable(port, speed);
          if(fd != -1) snprintf(connect_str, sizeof(connect_str), "Connecting to %s %dB ... OK.", port, speed);
          else snprintf(connect_str, sizeof(connect_str), "XBee not connected");
@@ -137,7 +133,7 @@ int main() {
          
          if(runstate == TRUE) {
             snprintf(outstr, sizeof(outstr), "%d Picon-One Hello World\r", i);
-            strserial(fd, outstr);
+            xbee_sendstring(fd, outstr);
             snprintf(connect_str, sizeof(connect_str), "Transmit: %s", outstr);
             i++;
             if(i>99) i = 0;
@@ -192,6 +188,6 @@ int main() {
    }
       
    finish();                               // Graphics cleanup
-   closeserial(fd);
+   xbee_disable(fd);
    exit(0);
 }
@@ -175,6 +175,6 @@ int main(int argc, char *argv[]) {
       xbee_setconfig(fd, device_conf, 7);
    }
 
-   closeserial(fd);
+   xbee_disable(fd);
    return 0;
 }
@@ -0,0 +1,381 @@
+/* ------------------------------------------------------------ *
+ * file:        xbee-nodes.c                                    *
+ * purpose:     XBee network node table. Node discovery (ATND)  *
+ *              records, node identification (0x95) and RX      *
+ *              (0x90) frames update a fixed size table, with   *
+ *              an index by 64 bit MAC and by 16 bit network    *
+ *              address. The table is saved to a text file, so  *
+ *              that programs start with the known nodes and    *
+ *              need not wait for a new discovery.              *
+ *                                                              *
+ * compile:     see Makefile                                    *
+ * author:      10/17/2026 Frank4DD                             *
+ * ------------------------------------------------------------ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "serial.h"
+#include "xbee.h"
+
+extern int verbose;        // verbose set in the main prog
+extern int timeout;        // timeout set in the main prog
+XBee_NodeTable nw_nodes;   // known network nodes
+
+/* ---------------------------------------------------- *
+ * machash() and nwhash() return the index slot to      *
+ * start the linear search for a MAC or NW address.     *
+ * ---------------------------------------------------- */
+static unsigned int machash(uint64_t mac) {
+   return (unsigned int) ((mac * 0x9E3779B97F4A7C15ULL) >> 40) & (XBEE_NODEHASH - 1);
+}
+
+static unsigned int nwhash(uint16_t nw) {
+   return ((nw * 40503u) >> 8) & (XBEE_NODEHASH - 1);
+}
+
+/* ---------------------------------------------------- *
+ * reindex() rebuilds both indexes. With XBEE_NODES it  *
+ * is cheap, and only runs when a node is added or gets *
+ * a new NW address.                                    *
+ * ---------------------------------------------------- */
+static void reindex(void) {
+   unsigned int h;
+   int i;
+
+   memset(nw_nodes.bymac, 0, sizeof(nw_nodes.bymac));
+   memset(nw_nodes.bynw, 0, sizeof(nw_nodes.bynw));
+   for(i = 0; i < nw_nodes.count; i++) {
+      for(h = machash(nw_nodes.node[i].mac); nw_nodes.bymac[h]; h = (h + 1) & (XBEE_NODEHASH - 1));
+      nw_nodes.bymac[h] = i + 1;
+      if(nw_nodes.node[i].nw_address == 0xFFFE) continue;
+      for(h = nwhash(nw_nodes.node[i].nw_address); nw_nodes.bynw[h]; h = (h + 1) & (XBEE_NODEHASH - 1));
+      nw_nodes.bynw[h] = i + 1;
+   }
+}
+
+/* ---------------------------------------------------- *
+ * xbee_nodebymac() returns the node with the 64 bit    *
+ * MAC address, or NULL if it is not in the table.      *
+ * ---------------------------------------------------- */
+XBee_Node *xbee_nodebymac(uint64_t mac) {
+   unsigned int h;
+
+   for(h = machash(mac); nw_nodes.bymac[h]; h = (h + 1) & (XBEE_NODEHASH - 1))
+      if(nw_nodes.node[nw_nodes.bymac[h] - 1].mac == mac)
+         return &nw_nodes.node[nw_nodes.bymac[h] - 1];
+   return NULL;
+}
+
+/* ---------------------------------------------------- *
+ * xbee_nodebynw() returns the node with the 16 bit NW  *
+ * address, or NULL if it is not in the table.          *
+ * ---------------------------------------------------- */
+XBee_Node *xbee_nodebynw(uint16_t nw) {
+   unsigned int h;
+
+   if(nw == 0xFFFE) return NULL;
+   for(h = nwhash(nw); nw_nodes.bynw[h]; h = (h + 1) & (XBEE_NODEHASH - 1))
+      if(nw_nodes.node[nw_nodes.bynw[h] - 1].nw_address == nw)
+         return &nw_nodes.node[nw_nodes.bynw[h] - 1];
+   return NULL;
+}
+
+/* ---------------------------------------------------- *
+ * setnw() gives node a new NW address. A node that had *
+ * that address before has left it, and gets FFFE.      *
+ * ---------------------------------------------------- */
+static void setnw(XBee_Node *node, uint16_t nw) {
+   XBee_Node *old;
+
+   if(node->nw_address == nw) return;
+   if((old = xbee_nodebynw(nw)) != NULL) old->nw_address = 0xFFFE;
+   node->nw_address = nw;
+   reindex();
+}
+
+/* ---------------------------------------------------- *
+ * newnode() adds an empty node for mac. If the table   *
+ * is full, the node not seen for the longest time goes *
+ * ---------------------------------------------------- */
+static XBee_Node *newnode(uint64_t mac) {
+   XBee_Node *node;
+   int i, oldest = 0;
+
+   if(nw_nodes.count < XBEE_NODES) node = &nw_nodes.node[nw_nodes.count++];
+   else {
+      for(i = 1; i < XBEE_NODES; i++)
+         if(nw_nodes.node[i].last_seen < nw_nodes.node[oldest].last_seen) oldest = i;
+      node = &nw_nodes.node[oldest];
+   }
+   memset(node, 0, sizeof(XBee_Node));
+   node->mac = mac;
+   node->nw_address = 0xFFFE;
+   node->pt_address = 0xFFFE;
+   node->dev_type = 0xFF;
+   reindex();
+   return node;
+}
+
+/* ---------------------------------------------------- *
+ * xbee_nodeupdate() adds or updates the node with the  *
+ * MAC address of rec, and marks it as seen now.        *
+ * Returns the node in the table.                       *
+ * ---------------------------------------------------- */
+XBee_Node *xbee_nodeupdate(const XBee_Node *rec) {
+   XBee_Node *node;
+
+   if((node = xbee_nodebymac(rec->mac)) == NULL) node = newnode(rec->mac);
+   node->pt_address = rec->pt_address;
+   node->dev_type   = rec->dev_type;
+   node->status     = rec->status;
+   node->profile_id = rec->profile_id;
+   node->mfg_id     = rec->mfg_id;
+   strncpy(node->nodeid, rec->nodeid, sizeof(node->nodeid) - 1);
+   node->last_seen  = (uint32_t) time(NULL);
+   setnw(node, rec->nw_address);
+   if(verbose == 1) printf("Debug: node %016llX %04X [%s]\n",
+                           (unsigned long long) node->mac, node->nw_address, node->nodeid);
+   return node;
+}
+
+/* ---------------------------------------------------- *
+ * get16() and get64() read big endian API values       *
+ * ---------------------------------------------------- */
+static uint16_t get16(const uint8_t *d) {
+   return (d[0] << 8) | d[1];
+}
+
+static uint64_t get64(const uint8_t *d) {
+   uint64_t v = 0;
+   int i;
+   for(i = 0; i < 8; i++) v = (v << 8) | d[i];
+   return v;
+}
+
+/* ---------------------------------------------------- *
+ * parserecord() reads a binary node record: MY, SH+SL, *
+ * NI with '\0', parent, device type, status, profile   *
+ * and manufacturer ID. ATND replies in API mode and    *
+ * 0x95 frames use it. Returns 0, or -1 if too short.   *
+ * ---------------------------------------------------- */
+static int parserecord(const uint8_t *d, int len, XBee_Node *rec) {
+   int ni;
+
+   if(len < 10) return -1;
+   memset(rec, 0, sizeof(XBee_Node));
+   rec->nw_address = get16(d);
+   rec->mac = get64(d + 2);
+   for(ni = 0; 10 + ni < len && d[10 + ni] != '\0'; ni++);
+   if(10 + ni + 9 > len) return -1;
+   memcpy(rec->nodeid, d + 10, (ni < 20) ? ni : 20);
+   d += 10 + ni + 1;
+   rec->pt_address = get16(d);
+   rec->dev_type   = d[2];
+   rec->status     = d[3];
+   rec->profile_id = get16(d + 4);
+   rec->mfg_id     = get16(d + 6);
+   return 0;
+}
+
+/* ---------------------------------------------------- *
+ * xbee_nodeframe() updates the table from a received   *
+ * API frame: a node identification (0x95) is a join    *
+ * or a commissioning button press, an RX packet (0x90) *
+ * shows the sender and its NW address. Returns 1 if    *
+ * the table changed, 0 for other frames.               *
+ * ---------------------------------------------------- */
+int xbee_nodeframe(const XBee_Frame *frame) {
+   XBee_Node rec, *node;
+
+   if(frame->type == XBEE_FRAME_NODE_ID && frame->len > 11) {
+      if(parserecord(frame->data + 11, frame->len - 11, &rec) == -1) return 0;
+      xbee_nodeupdate(&rec);
+      return 1;
+   }
+   if(frame->type == XBEE_FRAME_RX && frame->len >= 11) {
+      if((node = xbee_nodebymac(get64(frame->data))) == NULL) node = newnode(get64(frame->data));
+      node->last_seen = (uint32_t) time(NULL);
+      setnw(node, get16(frame->data + 8));
+      return 1;
+   }
+   return 0;
+}
+
+/* ---------------------------------------------------- *
+ * ndline() adds one transparent mode ATND reply line   *
+ * to the record. Lines come in the order MY, SH, SL,   *
+ * NI, parent, device type, status, profile, mfg ID,    *
+ * and an empty line ends the record. Returns 1 at the  *
+ * end of a record.                                     *
+ * ---------------------------------------------------- */
+static int ndline(const char *line, int field, XBee_Node *rec) {
+   unsigned long v = strtoul(line, NULL, 16);
+
+   switch(field) {
+      case 0: memset(rec, 0, sizeof(XBee_Node));
+              rec->nw_address = v; break;
+      case 1: rec->mac = (uint64_t) v << 32; break;
+      case 2: rec->mac |= v; break;
+      case 3: strncpy(rec->nodeid, (line[0] == ' ') ? line + 1 : line, sizeof(rec->nodeid) - 1);
+              break;
+      case 4: rec->pt_address = v; break;
+      case 5: rec->dev_type = v; break;
+      case 6: rec->status = v; break;
+      case 7: rec->profile_id = v; break;
+      case 8: rec->mfg_id = v; break;
+   }
+   return (line[0] == '\0' && field > 3);
+}
+
+/* ---------------------------------------------------- *
+ * xbee_nodediscover() runs ATND and updates the table  *
+ * with each node as its reply comes in. Discovery ends *
+ * after the ATNT time. Returns the number of nodes     *
+ * that replied, -1 for errors.                         *
+ * ---------------------------------------------------- */
+int xbee_nodediscover(int fd) {
+   char response[XBEE_REPLY];
+   unsigned int nt = XBEE_NT, deadline;
+   uint8_t data[3] = { 0, 'N', 'D' };
+   XBee_Frame frame, keep[XBEE_API_QUEUE];
+   XBee_Node rec;
+   int field = 0, found = 0, kept = 0, i;
+
+   if(xbee_startcmdmode(fd, timeout) == -1) return -1;
+   if(xbee_sendcmd(fd, "ATNT\r", response) == 0 && strtoul(response, NULL, 16) > 0)
+      nt = strtoul(response, NULL, 16) * 100;
+   deadline = msec() + nt + timeout * 1000;
+
+   /* ------------------------------------------------- *
+    * API mode: one ATND reply frame per node, with the *
+    * frame ID of the request. Other frames e.g. RX are *
+    * kept, and go back to the queue after the ATND.    *
+    * ------------------------------------------------- */
+   if(xbee_api != XBEE_API_OFF) {
+      data[0] = xbee_frameid();
+      if(xbee_sendframe(fd, XBEE_FRAME_AT, data, 3) == -1) return -1;
+      while(xbee_recvframe(fd, &frame, deadline) == 1) {
+         if(frame.type == XBEE_FRAME_NODE_ID) {
+            xbee_nodeframe(&frame);
+            continue;
+         }
+         if(frame.type != XBEE_FRAME_AT_RESPONSE) {
+            keep[kept++ % XBEE_API_QUEUE] = frame;
+            continue;
+         }
+         if(frame.len < 4 || frame.data[0] != data[0] || frame.data[1] != 'N'
+            || frame.data[2] != 'D' || frame.data[3] != 0) continue;
+         if(frame.len == 4) break;                 // end of discovery
+         if(parserecord(frame.data + 4, frame.len - 4, &rec) == -1) continue;
+         xbee_nodeupdate(&rec);
+         found++;
+      }
+      for(i = (kept > XBEE_API_QUEUE) ? kept - XBEE_API_QUEUE : 0; i < kept; i++)
+         xbee_queueframe(&keep[i % XBEE_API_QUEUE]);
+   }
+
+   /* ------------------------------------------------- *
+    * transparent mode: one '\r' line per field, empty  *
+    * lines end a record, and an extra one the ATND. No *
+    * node at all is not an error, the deadline ends it *
+    * ------------------------------------------------- */
+   else {
+      strserial(fd, "ATND\r");
+      while(delimserial(fd, response, sizeof(response), '\r', deadline) != -1) {
+         if(field == 0 && response[0] == '\0') break;
+         if(ndline(response, field, &rec)) {
+            xbee_nodeupdate(&rec);
+            found++;
+            field = 0;
+         }
+         else field++;
+      }
+   }
+   xbee_touchsession(fd);                       // ATND reply restarts ATCT
+
+   nw_nodes.last_update = (uint32_t) time(NULL);
+   if(xbee_endcmdmode(fd, timeout) == -1) return -1;
+   return found;
+}
+
+/* ---------------------------------------------------- *
+ * nodefile() returns file, or if NULL the env variable *
+ * XBEE_NODEFILE, else the default XBEE_NODEFILE path.  *
+ * ---------------------------------------------------- */
+static const char *nodefile(const char *file) {
+   if(file == NULL) file = getenv("XBEE_NODEFILE");
+   return (file != NULL) ? file : XBEE_NODEFILE;
+}
+
+/* ---------------------------------------------------- *
+ * xbee_nodesave() writes the table as text, one node   *
+ * per line. It writes a temp file first and renames it *
+ * so readers never see half a table. Returns 0 on      *
+ * success, -1 for errors.                              *
+ * ---------------------------------------------------- */
+int xbee_nodesave(const char *file) {
+   char tmp[256];
+   XBee_Node *n;
+   FILE *fp;
+   int i;
+
+   file = nodefile(file);
+   snprintf(tmp, sizeof(tmp), "%s.tmp", file);
+   if((fp = fopen(tmp, "w")) == NULL) {
+      printf("Error: cannot write %s\n", tmp);
+      return -1;
+   }
+   fprintf(fp, "# xbee nodes, last ATND %u\n", nw_nodes.last_update);
+   fprintf(fp, "# mac my parent type status profile mfg last_seen nodeid\n");
+   for(i = 0; i < nw_nodes.count; i++) {
+      n = &nw_nodes.node[i];
+      fprintf(fp, "%016llX %04X %04X %02X %02X %04X %04X %u %s\n",
+              (unsigned long long) n->mac, n->nw_address, n->pt_address, n->dev_type,
+              n->status, n->profile_id, n->mfg_id, n->last_seen, n->nodeid);
+   }
+   if(fclose(fp) != 0 || rename(tmp, file) == -1) {
+      unlink(tmp);
+      return -1;
+   }
+   return 0;
+}
+
+/* ---------------------------------------------------- *
+ * xbee_nodeload() reads a table saved by nodesave().   *
+ * Returns the number of nodes, -1 if there is no file. *
+ * ---------------------------------------------------- */
+int xbee_nodeload(const char *file) {
+   char line[256];
+   unsigned long long mac;
+   unsigned int my, pt, type, status, profile, mfg, seen;
+   XBee_Node *n;
+   FILE *fp;
+   int pos;
+
+   if((fp = fopen(nodefile(file), "r")) == NULL) return -1;
+   memset(&nw_nodes, 0, sizeof(nw_nodes));
+   while(fgets(line, sizeof(line), fp) != NULL && nw_nodes.count < XBEE_NODES) {
+      if(sscanf(line, "# xbee nodes, last ATND %u", &seen) == 1) nw_nodes.last_update = seen;
+      if(line[0] == '#') continue;
+      line[strcspn(line, "\r\n")] = '\0';
+      pos = 0;
+      if(sscanf(line, "%llx %x %x %x %x %x %x %u %n", &mac, &my, &pt, &type,
+                &status, &profile, &mfg, &seen, &pos) < 8 || pos == 0) continue;
+      n = &nw_nodes.node[nw_nodes.count++];
+      n->mac = mac;
+      n->nw_address = my;
+      n->pt_address = pt;
+      n->dev_type = type;
+      n->status = status;
+      n->profile_id = profile;
+      n->mfg_id = mfg;
+      n->last_seen = seen;
+      strncpy(n->nodeid, line + pos, sizeof(n->nodeid) - 1);
+   }
+   fclose(fp);
+   reindex();
+   return nw_nodes.count;
+}
@@ -2,6 +2,9 @@
  * file:        xbee-ping.c                                     *
  * purpose:     XBEE network discovery sending the ATND command *
  *              It returns a list of parameters for each node   *
+ *              The node table is cached in XBEE_NODEFILE, ATND *
+ *              only runs if it is older than XBEE_NODEAGE, or  *
+ *              with -d.                                        *
  * return:      0 on success, and -1 on errors.                 *
  * compile:     see Makefile                                    *
  * example:     ./xbee-ping                                     *
@@ -15,6 +18,7 @@
 #include <string.h>
 #include <unistd.h>
 #include <stdint.h>
+#include <time.h>
 #include "serial.h"
 #include "xbee.h"
 
@@ -27,14 +31,16 @@ char *port   = "/dev/ttySC1";  // serial port device
 int speed    = 115200;         // XBee modified speed
 //int speed    = 9600;         // XBee default speed
 int timeout  = 3;              // 3 seconds timeout
+int discover = 0;              // 1 = run ATND even if cached
 
 /* ------------------------------------------------------------ *
  * print_usage() prints the programs commandline instructions.  *
  * ------------------------------------------------------------ */
 void usage() {
-   static char const usage[] = "Usage: ./xbee-ping [-s speed] [-v]\n\
+   static char const usage[] = "Usage: ./xbee-ping [-s speed] [-d] [-v]\n\
 Command line parameters have the following format:\n\
    -s   set serial ine speed. Default = 115200. Example -s 9600\n\
+   -d   run node discovery, even if the node table is recent\n\
    -h   display this message\n\
    -v   enable debug output\n\
 \n\
@@ -51,12 +57,16 @@ void parseargs(int argc, char* argv[]) {
    int arg;
    opterr = 0;
 
-   while ((arg = (int) getopt (argc, argv, "cei:s:rhv")) != -1) {
+   while ((arg = (int) getopt (argc, argv, "cei:s:rdhv")) != -1) {
       switch (arg) {
          // arg -v verbose, type: flag, optional
          case 'v':
             verbose = 1; break;
 
+         // arg -d discover, type: flag, optional
+         case 'd':
+            discover = 1; break;
+
          // arg -s speed type: int
          case 's':
             if(verbose == 1) printf("Debug: arg -s, value %s\n", optarg);
@@ -93,8 +103,9 @@ void parseargs(int argc, char* argv[]) {
  * main() function to execute the program                       *
  * ------------------------------------------------------------ */
 int main(int argc, char *argv[]) {
-   char response[4096];
-   int ret;
+   const char *types[3] = { "coord", "router", "enddev" };
+   XBee_Node *n;
+   int i, found;
 
    /* ---------------------------------------------------------- *
     * process the cmdline parameters                             *
@@ -102,44 +113,47 @@ int main(int argc, char *argv[]) {
    parseargs(argc, argv);
 
    /* ---------------------------------------------------------- *
-    * Open the port with the speed in -s, or the program default *
+    * A recent node table from the cache needs no new discovery  *
     * ---------------------------------------------------------- */
-   printf("XBee open with %s %dB\n", port, speed);
-   int fd = xbee_enable(port, speed);
-   if(fd != -1) printf("XBee connected %s %dB\n", port, speed);
-   else printf("Error: XBee not connected\n");
-
-   printf("XBee Network Node Discovery\n");
-
-   /* ------------------------------------------------- *
-    * Enter CMD mode                                    *
-    * ------------------------------------------------- */
-   if(xbee_startcmdmode(fd, timeout) == -1) return -1;
-
-   /* ------------------------------------------------- *
-    * Send node discovery command with ATND             *
-    * ------------------------------------------------- */
-   ret = xbee_sendcmd(fd, "ATND\r", response);
-   if(ret == -1) return -1; // exit with failure code
-   printf(response);
-
-   // Data returned for ATND:
-   // -----------------------
-   // SH\r
-   // SL\r
-   // Node Name as in ATNI (0..20 bytes)
-   // parent network address \r (2bytes)
-   // 1-byte device type: 0=coord, 1=router, 2=enddevice \r
-   // status \r (1byte reserved)
-   // profile_id \r (2bytes)
-   // manufacturer_id \r (2 bytes)
-   // \r
+   if(xbee_nodeload(NULL) > 0 && discover == 0
+      && (uint32_t) time(NULL) - nw_nodes.last_update < XBEE_NODEAGE) {
+      printf("XBee node table from %u s ago, -d to discover\n",
+             (uint32_t) time(NULL) - nw_nodes.last_update);
+   }
+   else {
+      /* ------------------------------------------------------- *
+       * Open the port with the speed in -s, or the default      *
+       * ------------------------------------------------------- */
+      printf("XBee open with %s %dB\n", port, speed);
+      int fd = xbee_enable(port, speed);
+      if(fd != -1) printf("XBee connected %s %dB\n", port, speed);
+      else {
+         printf("Error: XBee not connected\n");
+         return -1;
+      }
 
-   /* ------------------------------------------------- *
-    * Finished, end command mode                        *
-    * ------------------------------------------------- */
-   if(xbee_endcmdmode(fd, timeout) == -1)   return -1;
+      /* ------------------------------------------------------- *
+       * ATND updates the table with each node that replies,     *
+       * nodes that do not reply now stay with their last_seen   *
+       * ------------------------------------------------------- */
+      printf("XBee Network Node Discovery\n");
+      found = xbee_nodediscover(fd);
+      xbee_disable(fd);
+      if(found == -1) return -1;
+      printf("%d nodes replied\n", found);
+      xbee_nodesave(NULL);
+   }
 
-   closeserial(fd);
+   /* ---------------------------------------------------------- *
+    * list the node table                                        *
+    * ---------------------------------------------------------- */
+   printf("MAC              NW   Parent Type   Profile Mfg  Seen   Name\n");
+   for(i = 0; i < nw_nodes.count; i++) {
+      n = &nw_nodes.node[i];
+      printf("%016llX %04X %04X   %-6s %04X    %04X %5us %s\n",
+             (unsigned long long) n->mac, n->nw_address, n->pt_address,
+             (n->dev_type < 3) ? types[n->dev_type] : "?", n->profile_id, n->mfg_id,
+             (uint32_t) time(NULL) - n->last_seen, n->nodeid);
+   }
    return 0;
 }
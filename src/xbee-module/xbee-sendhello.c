@@ -22,8 +22,9 @@
 #define SPEED 115200
 
 int main(void) {
+  serial_profile profile = { SPEED, SERIAL_LATENCY, 0 };
   int fd;
-  if((fd=getserial(UART, SPEED)) < 0){
+  if((fd=getserial(UART, &profile)) < 0){
     printf("Error opening port %s\n", UART);
     return -1;
   }
@@ -39,7 +40,7 @@ int main(void) {
   }
 
   printf("\n");
-  flushserial(fd);
+  drainserial(fd, msec() + 3000);
   closeserial(fd);
   return 0;
 }
@@ -23,6 +23,7 @@
 #include <sys/ioctl.h>
 #include <fcntl.h>
 #include "xbee-term.h"
+#include "serial.h"
 
 typedef struct {
   char device[20];
@@ -280,28 +281,12 @@ void check_cts(xbee_serial_t *port) {
 }
 
 int xbee_ser_flowcontrol(xbee_serial_t *serial, int enabled) {
-   struct termios options;
    do {if (xbee_ser_invalid(serial)) return -EINVAL;} while (0);
 
-    // Get the current options for the port...
-    if (tcgetattr( serial->fd, &options) == -1) {
+    // RTS/CTS flags are set by flowserial() in serial.c
+    if (flowserial( serial->fd, enabled) == -1) {
         #ifdef XBEE_SERIAL_VERBOSE
-            printf( "%s: %s failed (%d)\n", __FUNCTION__, "tcgetattr", errno);
-        #endif
-        return -errno;
-    }
-
-#ifdef CRTSXOFF
-    #define XBEE_FLOW_FLAGS (CRTSCTS | CRTSXOFF)
-#else
-    #define XBEE_FLOW_FLAGS (CRTSCTS)
-#endif
-    if (enabled) options.c_cflag |= XBEE_FLOW_FLAGS;
-    else options.c_cflag &= ~XBEE_FLOW_FLAGS;
-    // Set the new options for the port immediately
-    if (tcsetattr( serial->fd, TCSANOW, &options) == -1) {
-        #ifdef XBEE_SERIAL_VERBOSE
-            printf( "%s: %s failed (%d)\n", __FUNCTION__, "tcsetattr", errno);
+            printf( "%s: %s failed (%d)\n", __FUNCTION__, "flowserial", errno);
         #endif
         return -errno;
     }
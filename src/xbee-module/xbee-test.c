@@ -41,6 +41,6 @@ int main(void) {
    xbee_getinfo(fd);
    printf("XBee getstatus\n");
    xbee_getstatus(fd);
-   closeserial(fd);
+   xbee_disable(fd);
    return 0;
 }
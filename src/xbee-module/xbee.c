@@ -24,6 +24,7 @@ extern int verbose;        // verbose set in the main prog
 extern char *port;         // port is set in the main prog
 XBee_Info info;            // XBee device information
 XBee_Status status;        // XBee device status
+XBee_Session session;      // XBee command mode session
 
 // Coordinator configuration (PiCon One default)
 const char *coord_conf[8] = {
@@ -48,38 +49,425 @@ const char *device_conf[7] = {
    "ATAP0" };            // Set transparent mode
 // End Device configuration
 
+/* ---------------------------------------------------- *
+ * API mode state: xbee_api is set by the main prog     *
+ * before xbee_enable(). Frames that arrive while an AT *
+ * cmd waits for its reply go to the queue for recv.    *
+ * ---------------------------------------------------- */
+int xbee_api = XBEE_API_OFF;
+static XBee_Frame apiqueue[XBEE_API_QUEUE];
+static unsigned int qhead = 0, qtail = 0;
+static uint8_t frameid = 0;
+static int apinext = -1;   // ATAP value that ATAC applies
+static uint8_t apidest[8]; // TX destination, from ATDH+ATDL
+static int apidestset = 0;
+
+/* ---------------------------------------------------- *
+ * apiput() adds one byte to an encoded frame, escaped  *
+ * in AP2 mode if it is 0x7E, 0x7D, XON or XOFF.        *
+ * ---------------------------------------------------- */
+static int apiput(uint8_t *frame, int n, uint8_t c, int escaped) {
+   if(escaped && (c == XBEE_API_START || c == XBEE_API_ESCAPE
+                  || c == 0x11 || c == 0x13)) {
+      frame[n++] = XBEE_API_ESCAPE;
+      c ^= 0x20;
+   }
+   frame[n++] = c;
+   return n;
+}
+
+/* ---------------------------------------------------- *
+ * xbee_apiencode() builds the API frame for type and   *
+ * data: start, length, type, data and checksum. frame  *
+ * needs XBEE_API_FRAME bytes. Returns the frame length *
+ * ---------------------------------------------------- */
+int xbee_apiencode(uint8_t *frame, uint8_t type, const uint8_t *data,
+                   int len, int escaped) {
+   uint8_t sum = type;
+   int i, n = 0;
+
+   frame[n++] = XBEE_API_START;
+   n = apiput(frame, n, (len + 1) >> 8, escaped);
+   n = apiput(frame, n, (len + 1) & 0xFF, escaped);
+   n = apiput(frame, n, type, escaped);
+   for(i = 0; i < len; i++) {
+      sum += data[i];
+      n = apiput(frame, n, data[i], escaped);
+   }
+   return apiput(frame, n, 0xFF - sum, escaped);
+}
+
+/* ---------------------------------------------------- *
+ * xbee_sendframe() sends one API frame to the XBee.    *
+ * Returns 0 on success, -1 for errors.                 *
+ * ---------------------------------------------------- */
+int xbee_sendframe(int fd, uint8_t type, const uint8_t *data, int len) {
+   uint8_t frame[XBEE_API_FRAME];
+   int n;
+
+   if(len > XBEE_API_DATA) return -1;
+   n = xbee_apiencode(frame, type, data, len, xbee_api == XBEE_API_ESCAPED);
+   if(verbose == 1) printf("Debug: %s send frame 0x%02X (%d bytes)\n", port, type, n);
+   if(sendserial(fd, frame, n, msec() + timeout * 1000) != n) return -1;
+   return 0;
+}
+
+/* ---------------------------------------------------- *
+ * apibyte() reads one frame byte and removes the AP2   *
+ * escape. Returns 1 for a byte, 2 for an unescaped     *
+ * 0x7E (a new frame starts), 0 on timeout, -1 errors.  *
+ * ---------------------------------------------------- */
+static int apibyte(int fd, uint8_t *c, unsigned int deadline) {
+   int res;
+
+   if((res = readserial(fd, c, 1, deadline)) != 1) return res;
+   if(xbee_api != XBEE_API_ESCAPED) return 1;
+   if(*c == XBEE_API_START) return 2;
+   if(*c != XBEE_API_ESCAPE) return 1;
+   if((res = readserial(fd, c, 1, deadline)) != 1) return res;
+   *c ^= 0x20;
+   return 1;
+}
+
+/* ---------------------------------------------------- *
+ * apiread() reads the next valid frame from the port.  *
+ * Bytes before the start delimiter, frames with a bad  *
+ * length or checksum are skipped. Returns 1 for a new  *
+ * frame, 0 on timeout, -1 for errors.                  *
+ * ---------------------------------------------------- */
+static int apiread(int fd, XBee_Frame *frame, unsigned int deadline) {
+   uint8_t c, sum, hdr[3];
+   int i, len, res, sync = 0;
+
+   while(1) {
+      while(!sync) {
+         if((res = readserial(fd, &c, 1, deadline)) != 1) return res;
+         sync = (c == XBEE_API_START);
+      }
+      sync = 0;
+      /* ---------------------------------------------- *
+       * length high, length low and the frame type     *
+       * ---------------------------------------------- */
+      for(i = 0; i < 3; i++) {
+         if((res = apibyte(fd, &hdr[i], deadline)) == 2) break;
+         if(res != 1) return res;
+      }
+      if(res == 2) { sync = 1; continue; }
+      len = ((hdr[0] << 8) | hdr[1]) - 1;
+      if(len < 0 || len > XBEE_API_DATA) continue;
+      frame->type = hdr[2];
+      frame->len = len;
+      sum = hdr[2];
+      /* ---------------------------------------------- *
+       * frame data and the checksum byte at the end    *
+       * ---------------------------------------------- */
+      for(i = 0; i <= len; i++) {
+         if((res = apibyte(fd, &c, deadline)) == 2) break;
+         if(res != 1) return res;
+         if(i < len) frame->data[i] = c;
+         sum += c;
+      }
+      if(res == 2) { sync = 1; continue; }
+      if(sum == 0xFF) return 1;
+      if(verbose == 1) printf("Debug: %s frame 0x%02X checksum error\n", port, frame->type);
+   }
+}
+
+/* ---------------------------------------------------- *
+ * xbee_recvframe() returns the next received frame, a  *
+ * queued one first. Returns 1 for a frame, 0 if none   *
+ * came until the msec() deadline, -1 for errors.       *
+ * ---------------------------------------------------- */
+int xbee_recvframe(int fd, XBee_Frame *frame, unsigned int deadline) {
+   if(qhead != qtail) {
+      *frame = apiqueue[qhead++ % XBEE_API_QUEUE];
+      return 1;
+   }
+   return apiread(fd, frame, deadline);
+}
+
+/* ---------------------------------------------------- *
+ * xbee_frameid() returns the next frame ID 1..255, ID  *
+ * 0 would tell the XBee to send no reply.              *
+ * ---------------------------------------------------- */
+uint8_t xbee_frameid(void) {
+   if(++frameid == 0) frameid = 1;
+   return frameid;
+}
+
+/* ---------------------------------------------------- *
+ * xbee_queueframe() keeps a frame for xbee_recvframe() *
+ * e.g. RX data that came in during an AT cmd. A full   *
+ * queue drops the oldest frame.                        *
+ * ---------------------------------------------------- */
+void xbee_queueframe(const XBee_Frame *frame) {
+   if(qtail - qhead == XBEE_API_QUEUE) qhead++;       // drop oldest
+   apiqueue[qtail++ % XBEE_API_QUEUE] = *frame;
+}
+
+/* ---------------------------------------------------- *
+ * apireply() returns the next AT cmd response frame.   *
+ * Other frames go to the queue for xbee_recvframe().   *
+ * Returns 1 for a response, 0 on timeout, -1 errors.   *
+ * ---------------------------------------------------- */
+static int apireply(int fd, XBee_Frame *frame, unsigned int deadline) {
+   int res;
+
+   while((res = apiread(fd, frame, deadline)) == 1) {
+      if(frame->type == XBEE_FRAME_AT_RESPONSE && frame->len >= 4) return 1;
+      if(frame->type == XBEE_FRAME_AT_RESPONSE) continue;
+      xbee_queueframe(frame);
+   }
+   return res;
+}
+
+/* ---------------------------------------------------- *
+ * apidestcheck() drops the cached TX destination when  *
+ * the two letter cmd sets DH/DL, or applies, restores  *
+ * or changes settings (AC, RE, AP).                    *
+ * ---------------------------------------------------- */
+static void apidestcheck(const char *cmd, int plen) {
+   if((cmd[0] == 'D' && (cmd[1] == 'H' || cmd[1] == 'L') && plen > 0)
+      || (cmd[0] == 'A' && cmd[1] == 'C') || (cmd[0] == 'R' && cmd[1] == 'E')
+      || (cmd[0] == 'A' && cmd[1] == 'P' && plen > 0)) apidestset = 0;
+}
+
+/* ---------------------------------------------------- *
+ * xbee_atcmd() runs the two letter AT cmd with the raw *
+ * param bytes as an API frame, and waits for the reply *
+ * with the same frame ID. The value bytes go to value. *
+ * Returns the value length, XBEE_AT_ERROR if the XBee  *
+ * rejected the cmd, -1 on timeout or errors.           *
+ * ---------------------------------------------------- */
+int xbee_atcmd(int fd, const char *cmd, const uint8_t *param, int plen,
+               uint8_t *value, int size, unsigned int deadline) {
+   uint8_t data[XBEE_API_DATA];
+   uint8_t type = XBEE_FRAME_AT;
+   XBee_Frame frame;
+   int len;
+
+   if(plen > XBEE_API_DATA - 3) return -1;
+   data[0] = xbee_frameid();
+   data[1] = cmd[0];
+   data[2] = cmd[1];
+   if(plen > 0) memcpy(data + 3, param, plen);
+   /* ------------------------------------------------- *
+    * a new API mode applies at ATAC, so that the cmds  *
+    * up to ATAC still arrive in the current mode       *
+    * ------------------------------------------------- */
+   if(cmd[0] == 'A' && cmd[1] == 'P' && plen == 1) type = XBEE_FRAME_AT_QUEUE;
+   if(xbee_sendframe(fd, type, data, plen + 3) == -1) return -1;
+   apidestcheck(cmd, plen);
+
+   while(apireply(fd, &frame, deadline) == 1) {
+      if(frame.data[0] != data[0] || frame.data[1] != cmd[0] || frame.data[2] != cmd[1]) continue;
+      if(frame.data[3] != 0) {
+         if(verbose == 1) printf("Debug: AT%c%c status %d\n", cmd[0], cmd[1], frame.data[3]);
+         return XBEE_AT_ERROR;
+      }
+      if(type == XBEE_FRAME_AT_QUEUE) apinext = param[0];
+      if(cmd[0] == 'A' && cmd[1] == 'C' && apinext != -1) {
+         xbee_api = apinext;
+         apinext = -1;
+      }
+      len = frame.len - 4;
+      if(len > size) len = size;
+      if(len > 0) memcpy(value, frame.data + 4, len);
+      return len;
+   }
+   if(verbose == 1) printf("Debug: AT%c%c no API reply\n", cmd[0], cmd[1]);
+   return -1;
+}
+
+/* ---------------------------------------------------- *
+ * apiparam() converts the param of a cmd string as     *
+ * "NIname" or "ID24" to API frame bytes. Text params   *
+ * (NI) are sent as is, numbers as hex bytes. Returns   *
+ * the param length.                                    *
+ * ---------------------------------------------------- */
+static int apiparam(const char *cmd, uint8_t *param) {
+   const char *arg = cmd + 2;
+   int i, n = strcspn(arg, "\r,"), plen = 0;
+
+   if(strncmp(cmd, "NI", 2) == 0) {
+      if(n > XBEE_API_DATA - 3) n = XBEE_API_DATA - 3;
+      memcpy(param, arg, n);
+      return n;
+   }
+   if(n > 2 * (XBEE_API_DATA - 3)) n = 2 * (XBEE_API_DATA - 3);
+   memset(param, 0, (n + 1) / 2);
+   for(i = 0; i < n; i++) {
+      char hex[2] = { arg[i], '\0' };
+      if((n - i) % 2 == 0) param[plen] = strtol(hex, NULL, 16) << 4;
+      else param[plen++] |= strtol(hex, NULL, 16);
+   }
+   return plen;
+}
+
+/* ---------------------------------------------------- *
+ * apitext() writes the xbee_atcmd() result n as the    *
+ * transparent mode reply: hex values without leading   *
+ * zeros, NI as text, "OK" or "ERROR".                  *
+ * ---------------------------------------------------- */
+static void apitext(const char *cmd, int plen, const uint8_t *value, int n,
+                    char *response, int size) {
+   int i;
+
+   if(n == XBEE_AT_ERROR) snprintf(response, size, "ERROR");
+   else if(n == 0 && plen > 0) snprintf(response, size, "OK");
+   else if(strncmp(cmd, "NI", 2) == 0) {
+      if(n >= size) n = size - 1;
+      memcpy(response, value, n);
+      response[n] = '\0';
+   }
+   else if(n == 0) snprintf(response, size, "OK");
+   else {
+      for(i = 0; i < n - 1 && value[i] == 0; i++);    // skip leading zeros
+      if(n - i > (size - 1) / 2) n = i + (size - 1) / 2;
+      response += sprintf(response, "%X", value[i]);
+      for(i++; i < n; i++) response += sprintf(response, "%02X", value[i]);
+   }
+}
+
+/* ---------------------------------------------------- *
+ * xbee_apicmd() runs a transparent mode cmd string as  *
+ * "ATNIname\r" through xbee_atcmd(), and writes the    *
+ * reply as transparent mode text.                      *
+ * ---------------------------------------------------- */
+static int xbee_apicmd(int fd, const char *cmd, char *response) {
+   uint8_t param[XBEE_API_DATA], value[XBEE_API_DATA];
+   int n, plen;
+
+   if(strlen(cmd) < 4) return -1;
+   plen = apiparam(cmd + 2, param);
+   n = xbee_atcmd(fd, cmd + 2, param, plen, value, sizeof(value), msec() + timeout * 1000);
+   if(n == -1) return -1;
+   apitext(cmd + 2, plen, value, n, response, XBEE_REPLY);
+   return 0;
+}
+
+/* ---------------------------------------------------- *
+ * xbee_apiprobe() asks for ATAP in API mode, and sets  *
+ * xbee_api to the mode the XBee reports. Returns 0 if  *
+ * the XBee answered within XBEE_API_WAIT ms, else -1.  *
+ * ---------------------------------------------------- */
+static int xbee_apiprobe(int fd) {
+   int saved = xbee_api;
+   uint8_t ap;
+
+   if(xbee_api == XBEE_API_OFF) xbee_api = XBEE_API_ESCAPED;
+   if(xbee_atcmd(fd, "AP", NULL, 0, &ap, 1, msec() + XBEE_API_WAIT) == 1
+      && (ap == XBEE_API_ON || ap == XBEE_API_ESCAPED)) {
+      xbee_api = ap;
+      if(verbose == 1) printf("Debug: %s XBee in API mode %d\n", port, ap);
+      return 0;
+   }
+   xbee_api = saved;
+   return -1;
+}
+
+/* ---------------------------------------------------- *
+ * endsession() marks the command mode session closed,  *
+ * and releases the serhubd port lock held for it.      *
+ * ---------------------------------------------------- */
+static void endsession(int fd) {
+   session.open = 0;
+   unlockserial(fd);
+}
+
+/* ---------------------------------------------------- *
+ * insession() returns the ms until ATCT ends the open  *
+ * command mode session on fd, 0 if there is none.      *
+ * ---------------------------------------------------- */
+static int insession(int fd) {
+   int left;
+
+   if(session.open == 0 || session.fd != fd) return 0;
+   left = (int) (session.expires - msec());
+   if(left <= 0) endsession(fd);       // the XBee left by itself
+   return (left > 0) ? left : 0;
+}
+
+/* ---------------------------------------------------- *
+ * xbee_touchsession() restarts the ATCT timer, the     *
+ * XBee does that on each cmd it gets in command mode.  *
+ * The serhubd port lock lease is renewed to match.     *
+ * ---------------------------------------------------- */
+void xbee_touchsession(int fd) {
+   if(session.open == 0 || session.fd != fd) return;
+   session.expires = msec() + session.ct;
+   lockserial(fd, session.ct, msec());
+}
+
 /* ---------------------------------------------------- * 
  * xbee_enable() connects the XBee to the given serial  * 
  * port. Returns the fd for success, -1 for errors      * 
  * ---------------------------------------------------- */
 int xbee_enable(char *port, int speed) {
-   int fd;
+   serial_profile profile = { speed, SERIAL_LATENCY, 0 };
+   char cmd[8], response[XBEE_REPLY];
+   int fd, mode;
 
    /* ------------------------------------------------- *
     * open serial port                                  *
     * ------------------------------------------------- */
-   if((fd=getserial(port, speed)) < 0) {
+   if((fd=getserial(port, &profile)) < 0) {
       printf("Error opening port %s %d Baud\n", port, speed);
       return -1;
    }
    if(verbose == 1) printf("Debug: %s %d Baud connected\n", port, speed);
 
+   /* ------------------------------------------------- *
+    * API mode: the XBee answers the ATAP probe frame   *
+    * in ms if it is still in API mode. If not, switch  *
+    * it once with +++ and ATAP, until the next reset.  *
+    * ------------------------------------------------- */
+   if(xbee_api != XBEE_API_OFF) {
+      if(xbee_apiprobe(fd) == 0) return fd;
+      mode = xbee_api;
+      xbee_api = XBEE_API_OFF;
+      snprintf(cmd, sizeof(cmd), "ATAP%d\r", mode);
+      if(xbee_startcmdmode(fd, timeout) == -1) return -1;
+      if(xbee_sendcmd(fd, cmd, response) == -1 || strcmp(response, "OK") != 0) return -1;
+      if(xbee_exitcmdmode(fd, timeout) == -1)  return -1;   // ATCN applies ATAP
+      xbee_api = mode;
+      if(xbee_apiprobe(fd) == -1) return -1;
+      return fd;
+   }
+
    /* ------------------------------------------------- * 
     * Test Xbee S2C module by sending break signal +++  * 
+    * If there is no reply, the XBee may have been left *
+    * in API mode. Then switch it back with ATAP0.      *
     * ------------------------------------------------- */
-   if(xbee_startcmdmode(fd, timeout) == -1) return -1;
-   if(xbee_endcmdmode(fd, timeout) == -1)   return -1;
+   if(xbee_startcmdmode(fd, timeout) == 0) {
+      if(xbee_endcmdmode(fd, timeout) == -1)   return -1;
+      return fd;
+   }
+   if(xbee_apiprobe(fd) == -1) return -1;
+   if(xbee_sendcmd(fd, "ATAP0\r", response) == -1
+      || xbee_sendcmd(fd, "ATAC\r", response) == -1) return -1;
    return fd;
 } // end xbee_enable()
 
+/* ---------------------------------------------------- *
+ * xbee_disable() leaves an open command mode session,  *
+ * so the next program finds the XBee in data mode, and *
+ * closes the serial port.                              *
+ * ---------------------------------------------------- */
+void xbee_disable(int fd) {
+   xbee_exitcmdmode(fd, timeout);
+   closeserial(fd);
+}
+
 /* ---------------------------------------------------- * 
  * getinfo() gets XBee S2C module HW information incl.  * 
  * MAC, firmware version, hardware model, bus voltage   * 
  * returns 0 for success, -1 for errors.                * 
  * ---------------------------------------------------- */
 int xbee_getinfo(int fd) {
-   char response[512];
-   int ret;
+   const char *cmds[6] = { "VR", "HV", "NI", "SH", "SL", "%V" };
+   char replies[6][XBEE_BATCH_REPLY];
 
    /* ------------------------------------------------- * 
     * Enter CMD mode                                    * 
@@ -87,69 +475,26 @@ int xbee_getinfo(int fd) {
    if(xbee_startcmdmode(fd, timeout) == -1) return -1;
 
    /* ------------------------------------------------- * 
-    * Get firmware version with ATVR                    * 
-    * ------------------------------------------------- */
-   ret = xbee_sendcmd(fd, "ATVR\r", response);
-   if(ret == -1) return -1; // exit with failure code
-   strncpy(info.firmware, response, sizeof(info.firmware));
-   memset(response,0,sizeof(response));
-
-   /* ------------------------------------------------- */
-   /* Get hardware version with ATHV, returns 4 bytes   */
-   /* ------------------------------------------------- */
-   ret = xbee_sendcmd(fd, "ATHV\r", response);
-   if(ret == -1) return -1; // exit with failure code
-   strncpy(info.hardware, response, sizeof(info.hardware));
-   memset(response,0,sizeof(response));
-
-   /* ------------------------------------------------- * 
-    * Get node identifier with ATNI, may return 0 bytes * 
-    * ------------------------------------------------- */
-   ret = xbee_sendcmd(fd, "ATNI\r", response);
-   if(ret == -1) return -1; // exit with failure code
-   strncpy(info.nodeid, response, sizeof(info.nodeid));
-   memset(response,0,sizeof(response));
-
-   /* ------------------------------------------------- * 
-    * Get MAC address with ATSH and ATSL, ret 6/8 bytes * 
+    * Get all values in one batch: firmware version     *
+    * (ATVR), hardware version (ATHV), node identifier  *
+    * (ATNI, may be empty), MAC address high and low    *
+    * (ATSH, ATSL), and the bus voltage in mV (AT%V)    *
     * ------------------------------------------------- */
-   ret = xbee_sendcmd(fd, "ATSH\r", response);
-   if(ret == -1) return -1; // exit with failure code
-
-   // assign response to MAC string, e.g. 0013A200417D5111
-   char mac[17];
-   uint8_t leadzeros = 8 - strlen(response);
-   mac[leadzeros] = '\0';
-   while(leadzeros > 0) {
-     leadzeros--;
-     mac[leadzeros] = '0';
+   if(xbee_batch(fd, cmds, 6, replies, msec() + timeout * 1000) != 6) {
+      printf("Error: No XBee response received\n");
+      return -1;
    }
-   strcat(mac, response);
-   if(verbose == 1) printf("Debug: MAC %s\n", mac);
-   memset(response,0,sizeof(response));
+   strncpy(info.firmware, replies[0], sizeof(info.firmware) - 1);
+   strncpy(info.hardware, replies[1], sizeof(info.hardware) - 1);
+   strncpy(info.nodeid, replies[2], sizeof(info.nodeid) - 1);
 
-   ret = xbee_sendcmd(fd, "ATSL\r", response);
-   if(ret == -1) return -1; // exit with failure code
-   // add response to MAC string e.g. 0013A200417D5111
-   leadzeros = 8 - strlen(response);
-   mac[8+leadzeros] = '\0';
-   while(leadzeros > 0) {
-     leadzeros--;
-     mac[8+leadzeros] = '0';
-   }
-   strcat(mac, response);
-   strncpy(info.mac, mac, sizeof(info.mac));
-   if(verbose == 1) printf("Debug: MAC %s\n", mac);
-   memset(response,0,sizeof(response));
-
-   /* ------------------------------------------------- * 
-    * Get bus voltage in mV with AT%V, returns 3 bytes  * 
-    * ------------------------------------------------- */
-   ret = xbee_sendcmd(fd, "AT%V\r", response);
-   if(ret == -1) return -1; // exit with failure code
+   // MAC string with lead zeros, e.g. 0013A200417D5111
+   snprintf(info.mac, sizeof(info.mac), "%08lX%08lX",
+            strtoul(replies[3], NULL, 16), strtoul(replies[4], NULL, 16));
+   if(verbose == 1) printf("Debug: MAC %s\n", info.mac);
 
    // convert string to float
-   uint32_t millivolt = strtol(response, NULL, 16);
+   uint32_t millivolt = strtol(replies[5], NULL, 16);
    info.volt = (float) millivolt / 1000.0;
    if(verbose == 1) printf("Debug: Convert Volt: %.3f\n", info.volt);
 
@@ -160,133 +505,291 @@ int xbee_getinfo(int fd) {
    return 0;                               // return success
 } // end xbee_getinfo()
 
+/* ---------------------------------------------------- *
+ * xbee_getreply() waits up to timeout seconds for one  *
+ * '\r' terminated AT reply, and returns it without the *
+ * '\r'. The wait ends as soon as the '\r' arrives.     *
+ * Returns the reply length, -1 on timeout or errors.   *
+ * ---------------------------------------------------- */
+static int xbee_getreply(int fd, char *response, int size, int timeout) {
+   unsigned int start = msec();
+   int len;
+
+   len = delimserial(fd, response, size, '\r', start + timeout * 1000);
+   if(verbose == 1) printf("Debug: %s reply: %s (%d bytes) after %u ms\n",
+                           port, (len == -1) ? "" : response, len, msec() - start);
+   return len;
+}
+
+/* ---------------------------------------------------- *
+ * apibatch() sends the batch cmds as AT frames at once *
+ * and matches the replies to the cmds by frame ID, in  *
+ * any order. Returns the number of replies.            *
+ * ---------------------------------------------------- */
+static int apibatch(int fd, const char **cmds, int n,
+                    char (*replies)[XBEE_BATCH_REPLY], unsigned int deadline) {
+   uint8_t data[XBEE_API_DATA], ids[XBEE_BATCH], done[XBEE_BATCH];
+   int plens[XBEE_BATCH];
+   XBee_Frame frame;
+   int i, got = 0;
+
+   for(i = 0; i < n; i++) {
+      ids[i] = xbee_frameid();
+      done[i] = 0;
+      data[0] = ids[i];
+      data[1] = cmds[i][0];
+      data[2] = cmds[i][1];
+      plens[i] = apiparam(cmds[i], data + 3);
+      if(xbee_sendframe(fd, XBEE_FRAME_AT, data, plens[i] + 3) == -1) return -1;
+   }
+   while(got < n && apireply(fd, &frame, deadline) == 1) {
+      for(i = 0; i < n && ids[i] != frame.data[0]; i++);
+      if(i == n || done[i]) continue;          // stale reply
+      apitext(cmds[i], plens[i], frame.data + 4,
+              (frame.data[3] != 0) ? XBEE_AT_ERROR : frame.len - 4,
+              replies[i], XBEE_BATCH_REPLY);
+      done[i] = 1;
+      got++;
+   }
+   return got;
+}
+
+/* ---------------------------------------------------- *
+ * xbee_batch() runs n AT cmds written without the "AT" *
+ * e.g. "NC" or "ID24", as one batch. In transparent    *
+ * mode they go out comma-chained in one line, as in    *
+ * "ATNC,AI,OP\r", and the '\r' replies are taken in    *
+ * order while they stream in. In API mode all frames   *
+ * go out at once. Each reply is taken the moment it    *
+ * arrives, the deadline only ends a missing reply. It  *
+ * needs command mode. Returns the number of replies,   *
+ * -1 for errors. Replies that did not come stay "".    *
+ * ---------------------------------------------------- */
+int xbee_batch(int fd, const char **cmds, int n,
+               char (*replies)[XBEE_BATCH_REPLY], unsigned int deadline) {
+   char line[XBEE_REPLY];
+   int i, len, got;
+
+   if(n > XBEE_BATCH) return -1;
+   for(i = 0; i < n; i++) replies[i][0] = '\0';
+   if(xbee_api != XBEE_API_OFF) return apibatch(fd, cmds, n, replies, deadline);
+
+   len = snprintf(line, sizeof(line), "AT");
+   for(i = 0; i < n && len < (int) sizeof(line); i++)
+      len += snprintf(line + len, sizeof(line) - len, "%s%s", (i > 0) ? "," : "", cmds[i]);
+   if(len >= (int) sizeof(line) - 1) return -1;
+   line[len++] = '\r';
+   line[len] = '\0';
+   if(verbose == 1) printf("Debug: send CMD %s\n", line);
+   if(sendserial(fd, line, len, deadline) != len) return -1;
+   xbee_touchsession(fd);
+
+   for(got = 0; got < n; got++) {
+      if(delimserial(fd, line, sizeof(line), '\r', deadline) == -1) break;
+      strncpy(replies[got], line, XBEE_BATCH_REPLY - 1);
+      replies[got][XBEE_BATCH_REPLY - 1] = '\0';
+   }
+   if(verbose == 1) printf("Debug: %s %d of %d replies\n", port, got, n);
+   return got;
+}
+
+/* ---------------------------------------------------- *
+ * xbee_apisend() sends data as TX request frames to    *
+ * the ATDH+ATDL destination, like transparent mode. No *
+ * frame ID, the XBee sends no TX status back.          *
+ * ---------------------------------------------------- */
+static int xbee_apisend(int fd, const char *buf, int len) {
+   uint8_t data[XBEE_API_DATA];
+   unsigned int deadline = msec() + timeout * 1000;
+   int chunk;
+
+   if(apidestset == 0) {
+      if(xbee_atcmd(fd, "DH", NULL, 0, apidest, 4, deadline) != 4
+         || xbee_atcmd(fd, "DL", NULL, 0, apidest + 4, 4, deadline) != 4) return -1;
+      apidestset = 1;
+   }
+   data[0] = 0;                    // frame ID 0, no TX status
+   memcpy(data + 1, apidest, 8);   // 64 bit destination
+   data[9] = 0xFF;                 // 16 bit address unknown
+   data[10] = 0xFE;
+   data[11] = 0;                   // broadcast radius max hops
+   data[12] = 0;                   // TX options
+   while(len > 0) {
+      chunk = (len > XBEE_API_PAYLOAD) ? XBEE_API_PAYLOAD : len;
+      memcpy(data + 13, buf, chunk);
+      if(xbee_sendframe(fd, XBEE_FRAME_TX, data, chunk + 13) == -1) return -1;
+      buf += chunk;
+      len -= chunk;
+   }
+   return 0;
+}
+
 /* ---------------------------------------------------- * 
  * sendstring() sends a string over / to the XBee radio * 
- * args: String to send, flag to send AT cmds to module * 
+ * and waits up to timeout seconds until it has left    * 
+ * the UART. Returns 0 on success, -1 for errors.       * 
  * ---------------------------------------------------- */
 int xbee_sendstring(int fd, const char * sendstr) {
-   uint8_t sendbytes = strlen(sendstr);
+   int sendbytes = strlen(sendstr);
    if(verbose == 1) {
       printf("Debug: send %s (%d bytes)", sendstr, sendbytes);
    }
-   strserial(fd, sendstr);
-   flushserial(fd);
+   if(xbee_api != XBEE_API_OFF) {
+      if(xbee_apisend(fd, sendstr, sendbytes) == -1) return -1;
+      return drainserial(fd, msec() + timeout * 1000);
+   }
+   /* ------------------------------------------------- *
+    * transparent data needs the cmd session closed     *
+    * ------------------------------------------------- */
+   if(xbee_exitcmdmode(fd, timeout) == -1) return -1;
+   if(sendserial(fd, sendstr, sendbytes, msec() + timeout * 1000) != sendbytes)
+      return -1;
+   if(drainserial(fd, msec() + timeout * 1000) == -1) return -1;
+   session.lastdata = msec();            // next +++ guard counts from here
+   session.datasent = 1;
    return 0;
 }
 
 /* ---------------------------------------------------- * 
  * xbee_startcmdmode() enters command mode to send AT   * 
- * cmds. Returns 0 on success, -1 for errors.           * 
+ * cmds. A session still open from the last cmds is     * 
+ * reused, if ATCT leaves it XBEE_CT_MARGIN ms or more. * 
+ * Else it sends +++ after the guard time. In API mode  * 
+ * AT cmds need no command mode, it returns at once.    * 
+ * Returns 0 on success, -1 for errors.                 * 
  * ---------------------------------------------------- */
 int xbee_startcmdmode(int fd, int timeout) {
-   int cycles = timeout * 10; // check interval is 100ms
-   int i = 0; int wait = 0;
    char response[512];
+   int wait = XBEE_GUARD;
 
+   if(xbee_api != XBEE_API_OFF) return 0;
+   if(insession(fd) > XBEE_CT_MARGIN) {
+      if(verbose == 1) printf("Debug: XBee CMD mode reused, %u ms left.\n",
+                              session.expires - msec());
+      return 0;
+   }
    /* ------------------------------------------------- *
-    * wait guard time, send cmd char sequence (cc): +++ *
+    * a session that ends within the margin is left to  *
+    * run out, cmds sent too late would go out as data  *
     * ------------------------------------------------- */
-   sleep(1);              // wait guard time 1 second
-   strserial(fd, "+++");
-   if(verbose == 1) printf("Debug: %s send +++\n", port);
+   if(insession(fd) > 0) usleep(insession(fd) * 1000);
+   endsession(fd);
 
    /* ------------------------------------------------- *
-    * wait guard time, check for the 3 bytes response   *
+    * via serhubd, hold the port lock so no other       *
+    * program's data reaches the XBee in command mode   *
     * ------------------------------------------------- */
-   while((wait = checkserial(fd)) == 0) {
-      usleep(100000);     // wait 100ms
-      if(i>cycles) break; // stop waiting after timeout s
-      i++;
+   if(session.ct == 0) session.ct = XBEE_CT;
+   if(lockserial(fd, 2 * XBEE_GUARD + timeout * 1000 + session.ct,
+                 msec() + XBEE_LOCKWAIT) == -1) {
+      printf("Error: %s command mode locked by another program\n", port);
+      return -1;
    }
-   if(verbose == 1) printf("Debug: %s got %d bytes after %d ms\n", port, wait, i*100);
+
    /* ------------------------------------------------- *
+    * wait guard time, send cmd char sequence (cc): +++ *
+    * The guard time only counts from our last data.    *
+    * ------------------------------------------------- */
+   if(session.datasent) wait -= (int) (msec() - session.lastdata);
+   if(wait > 0) usleep(wait * 1000);
+   strserial(fd, "+++");
+   if(verbose == 1) printf("Debug: %s send +++\n", port);
+
+   /* ------------------------------------------------- *
+    * wait for the "OK\r" response, up to timeout secs  *
     * If no response we have XBee communication failure *
     * Either no XBee connected, or has different speed. *
     * ------------------------------------------------- */
-   if(wait == 0) {
+   if(xbee_getreply(fd, response, sizeof(response), timeout) == -1) {
       printf("Error: No XBee responding\n");
+      unlockserial(fd);
       return -1;
    }
 
-   /* ------------------------------------------------ *
-    * retrieve reply and save it into response string  *
-    * ------------------------------------------------ */
-   i = 0;
-   for (i=0; i<1024; i++) {
-      if(checkserial(fd)>0) response[i] = getcharserial(fd);
-      else break;
-   }
-   /* ------------------------------------------------- *
-    * Remove '\r' carriage return in response last char *
-    * ------------------------------------------------- */
-   i--;                                        // back to last char
-   if(response[i] == '\r') response[i] = '\0'; // eliminate '\r'
-
    /* ------------------------------------------------- *
     * Confirm response string == "OK"                   *
     * ------------------------------------------------- */
-   if(verbose == 1) printf("Debug: port %s reply: %s (%d bytes)\n", port, response, i);
    if(strcmp(response, "OK") != 0) {
       if(verbose == 1) printf("Debug: XBee CMD mode start failed.\n");
+      unlockserial(fd);
       return -1;       // exit with failure code
    }
-   if(verbose == 1) printf("Debug: XBee CMD mode start complete.\n");
+   session.fd = fd;
+   session.open = 1;
+   xbee_touchsession(fd);
+
+   /* ------------------------------------------------- *
+    * Read the ATCT timeout once, in 100 ms units       *
+    * ------------------------------------------------- */
+   if(session.ctread == 0 && xbee_sendcmd(fd, "ATCT\r", response) == 0
+      && strtoul(response, NULL, 16) > 0) {
+      session.ct = strtoul(response, NULL, 16) * 100;
+      session.ctread = 1;
+      xbee_touchsession(fd);
+   }
+   if(verbose == 1) printf("Debug: XBee CMD mode start complete, ATCT %u ms.\n", session.ct);
    return 0;
 }
 
 /* ---------------------------------------------------- */
-/* endcmdmode() close command mode after sending AT cmd */
+/* endcmdmode() ends a burst of AT cmds. The session    */
+/* stays open for the next cmds until ATCT ends it, or  */
+/* until transparent data must flow. No ATCN is sent,   */
+/* unless another program waits for the serhubd lock.   */
 /* returns 0 for success, -1 for errors.                */
 /* ---------------------------------------------------- */
 int xbee_endcmdmode(int fd, int timeout) {
-   int cycles = timeout * 10; // check interval is 100ms
-   int i = 0; int wait = 0;
+   if(insession(fd) > 0 && contendserial(fd)) return xbee_exitcmdmode(fd, timeout);
+   if(verbose == 1 && insession(fd) > 0)
+      printf("Debug: XBee CMD mode kept, %d ms left.\n", insession(fd));
+   return 0;
+}
+
+/* ---------------------------------------------------- */
+/* exitcmdmode() leaves an open command mode session    */
+/* with ATCN, so that transparent data flows again.     */
+/* returns 0 for success, -1 for errors.                */
+/* ---------------------------------------------------- */
+int xbee_exitcmdmode(int fd, int timeout) {
    char response[512];
+   int res;
+
+   /* ------------------------------------------------- *
+    * Within the margin, wait for ATCT to end it, ATCN  *
+    * might arrive too late and go out as data          *
+    * ------------------------------------------------- */
+   if(insession(fd) == 0) return 0;
+   if(insession(fd) <= XBEE_CT_MARGIN) {
+      usleep(insession(fd) * 1000);
+      endsession(fd);
+      return 0;
+   }
+   session.open = 0;
 
    /* ------------------------------------------------- * 
     * Send ATCN command to leave CMD mode               * 
     * ------------------------------------------------- */
    strserial(fd, "ATCN\r");
-   wait = checkserial(fd);
+   session.lastdata = msec();            // next +++ guard counts from here
+   session.datasent = 1;
    if(verbose == 1) printf("Debug: %s send ATCN\\r\n", port);
 
    /* ------------------------------------------------- *
-    * Check if response is received, wait up to timeout *
-    * ------------------------------------------------- */
-   i = 0;
-   while((wait = checkserial(fd)) == 0) {
-      usleep(100000);     // wait 100ms
-      if(i>cycles) break; // stop waiting after 3 seconds
-      i++;
-   }
-   if(verbose == 1) printf("Debug: %s got %d bytes after %d ms\n", port, wait, i*100);
-   /* ------------------------------------------------- *
+    * Wait for the response, up to timeout seconds      *
     * If no response, its a XBee communication failure  *
     * Either no XBee connected, or on different speed.  *
+    * Other programs may write again after the reply.   *
     * ------------------------------------------------- */
-   if(wait == 0) {
+   res = xbee_getreply(fd, response, sizeof(response), timeout);
+   unlockserial(fd);
+   if(res == -1) {
       printf("Error: No XBee response received\n");
       return -1;
    }
 
-   /* ------------------------------------------------- *
-    * retrieve the reply, save it into response string  *
-    * ------------------------------------------------- */
-   for (i=0; i<1024; i++) {
-      if(checkserial(fd)>0) response[i] = getcharserial(fd);
-      else break;
-   }
-
-   /* ------------------------------------------------- *
-    * Remove '\r' carriage return from last char        *
-    * ------------------------------------------------- */
-   i--;                                        // back to last char
-   if(response[i] == '\r') response[i] = '\0'; // eliminate '\r'
-
    /* ------------------------------------------------- *
     * Confirm response string == "OK"                   *
     * ------------------------------------------------- */
-   if(verbose == 1) printf("Debug: port %s reply: %s (%d bytes)\n", port, response, i);
    if(strcmp(response, "OK") != 0) {
       if(verbose == 1) printf("Debug: XBee CMD ATCN failed.\n");
       return -1;       // exit with failure code
@@ -300,26 +803,42 @@ int xbee_endcmdmode(int fd, int timeout) {
  * returns 0 for success, -1 for errors                 * 
  * ---------------------------------------------------- */
 int xbee_recvstring(int fd, char *received) {
-   int i;
-   while(0) {                            // wait for serial
-      if(checkserial(fd)>0) break;
-      usleep(100000);
-   }
+   serial_splitter splitter = { "\r", 1, 1023, 0, 1 };
+   serial_span span;
+   XBee_Frame frame;
+   int res;
 
    /* ------------------------------------------------- *
-    * retrieve the reply, save it into response string  *
+    * API mode: take the payload of the next RX frame,  *
+    * without a trailing '\r'. Other frames are skipped *
     * ------------------------------------------------- */
-   for (i=0; i<1024; i++) {
-      if(checkserial(fd)>0) received[i] = getcharserial(fd);
-      else break;
+   if(xbee_api != XBEE_API_OFF) {
+      received[0] = '\0';
+      while((res = xbee_recvframe(fd, &frame, msec())) == 1) {
+         xbee_nodeframe(&frame);                  // join events, senders
+         if(frame.type != XBEE_FRAME_RX || frame.len < 11) continue;
+         res = frame.len - 11;
+         if(res > 0 && frame.data[10 + res] == '\r') res--;
+         memcpy(received, frame.data + 11, res);
+         received[res] = '\0';
+         break;
+      }
+      if(res == -1) return -1;
+      if(verbose == 1) printf("Debug: Data recv %s (%d bytes)\n", received, (int) strlen(received));
+      return 0;
    }
+   if(xbee_exitcmdmode(fd, timeout) == -1) return -1;   // let RF data in
 
    /* ------------------------------------------------- *
-    * Remove '\r' carriage return from last char        *
+    * take the next '\r' terminated string, or the data *
+    * received so far, without waiting. The splitter    *
+    * strips the '\r' carriage return.                  *
     * ------------------------------------------------- */
-   i--;                                        // back to last char
-   if(received[i] == '\r') received[i] = '\0'; // eliminate '\r'
-   if(verbose == 1) printf("Debug: Data recv %s (%d bytes)\n", received, i);
+   if((res = spanserial(fd, &splitter, &span, msec())) == -1) return -1;
+   if(res == 0) span.len = 0;                  // nothing received
+   memcpy(received, span.data, span.len);
+   received[span.len] = '\0';
+   if(verbose == 1) printf("Debug: Data recv %s (%d bytes)\n", received, span.len);
    return 0;       // exit with success
 }
 
@@ -382,8 +901,8 @@ int xbee_setconfig(int fd, const char **conf, uint8_t entries) {
  * returns 0 for success, -1 for errors                 * 
  * ---------------------------------------------------- */
 int xbee_getstatus(int fd) {
-   char response[1024];
-   int ret;
+   const char *cmds[9] = { "NC", "AI", "OP", "CH", "DB", "PP", "NP", "MY", "MP" };
+   char replies[9][XBEE_BATCH_REPLY];
 
    /* ------------------------------------------------- *
     * Enter CMD mode                                    *
@@ -391,78 +910,25 @@ int xbee_getstatus(int fd) {
    if(xbee_startcmdmode(fd, timeout) == -1) return -1;
 
    /* ------------------------------------------------- * 
-    * Get device free with ATNC, returns 1 byte 0..14   * 
-    * Remaining num of devices the coordinator supports *
-    * ------------------------------------------------- */
-   ret = xbee_sendcmd(fd, "ATNC\r", response);
-   if(ret == -1) return -1;          // exit with failure code
-   strncpy(status.device_free, response, sizeof(status.device_free));
-   memset(response,0,sizeof(response));
-
-   /* ------------------------------------------------- * 
-    * Get association with ATAI, returns 1 byte, 0 = OK * 
-    * if non-zero return, it will be error codes in hex * 
-    * ------------------------------------------------- */
-   ret = xbee_sendcmd(fd, "ATAI\r", response);
-   if(ret == -1) return -1;          // exit with failure code
-   strncpy(status.association, response, sizeof(status.association));
-   memset(response,0,sizeof(response));
-
-   /* ------------------------------------------------- * 
-    * Get operational PAN ID with ATOP, returns 8 bytes * 
+    * Get all status values in one batch: devices free  *
+    * (ATNC), association (ATAI), operational PAN ID    *
+    * and channel (ATOP, ATCH), signal strength (ATDB), *
+    * power level (ATPP), max unicast bytes (ATNP), and *
+    * the own and parent network address (ATMY, ATMP)   *
     * ------------------------------------------------- */
-   ret = xbee_sendcmd(fd, "ATOP\r", response);
-   if(ret == -1) return -1; // exit with failure code
-   strncpy(status.oper_panid, response, sizeof(status.oper_panid));
-   memset(response,0,sizeof(response));
-
-   /* ------------------------------------------------- * 
-    * Get operational channel with ATCH returns 2 bytes * 
-    * ------------------------------------------------- */
-   ret = xbee_sendcmd(fd, "ATCH\r", response);
-   if(ret == -1) return -1; // exit with failure code
-   strncpy(status.oper_chan, response, sizeof(status.oper_chan));
-   memset(response,0,sizeof(response));
-
-   /* ------------------------------------------------- * 
-    * Get signal strengh with ATDB returns 1 byte 0..FF * 
-    * ------------------------------------------------- */
-   ret = xbee_sendcmd(fd, "ATDB\r", response);
-   if(ret == -1) return -1;        // exit with failure code
-   strncpy(status.last_rssi, response, sizeof(status.last_rssi));
-   memset(response,0,sizeof(response));
-
-   /* ------------------------------------------------- * 
-    * Get power level 4 with ATPP, returns 1 byte 0..FF * 
-    * ------------------------------------------------- */
-   ret = xbee_sendcmd(fd, "ATPP\r", response);
-   if(ret == -1) return -1;        // exit with failure code
-   strncpy(status.pwr_level, response, sizeof(status.pwr_level));
-   memset(response,0,sizeof(response));
-
-   /* ------------------------------------------------- * 
-    * max bytes for unicasts with ATNP, returns 1 byte  * 
-    * ------------------------------------------------- */
-   ret = xbee_sendcmd(fd, "ATNP\r", response);
-   if(ret == -1) return -1;          // exit with failure code
-   strncpy(status.max_packets, response, sizeof(status.max_packets));
-   memset(response,0,sizeof(response));
-
-   /* ------------------------------------------------- * 
-    * Get network address with ATMY, returns 2 bytes    * 
-    * ------------------------------------------------- */
-   ret = xbee_sendcmd(fd, "ATMY\r", response);
-   if(ret == -1) return -1;       // exit with failure code
-   strncpy(status.nw_address, response, sizeof(status.nw_address));
-   memset(response,0,sizeof(response));
-
-   /* ------------------------------------------------- * 
-    * Get parent nw address with ATMP, returns 2 bytes  * 
-    * ------------------------------------------------- */
-   ret = xbee_sendcmd(fd, "ATMP\r", response);
-   if(ret == -1) return -1;       // exit with failure code
-   strncpy(status.pt_address, response, sizeof(status.pt_address));
-   memset(response,0,sizeof(response));
+   if(xbee_batch(fd, cmds, 9, replies, msec() + timeout * 1000) != 9) {
+      printf("Error: No XBee response received\n");
+      return -1;
+   }
+   status.device_free = strtoul(replies[0], NULL, 16);
+   status.association = strtoul(replies[1], NULL, 16);
+   status.oper_panid  = strtoull(replies[2], NULL, 16);
+   status.oper_chan   = strtoul(replies[3], NULL, 16);
+   status.last_rssi   = strtoul(replies[4], NULL, 16);
+   status.pwr_level   = strtoul(replies[5], NULL, 16);
+   status.max_packets = strtoul(replies[6], NULL, 16);
+   status.nw_address  = strtoul(replies[7], NULL, 16);
+   status.pt_address  = strtoul(replies[8], NULL, 16);
 
    /* ------------------------------------------------- * 
     * Write current time timestamp to last_update       *
@@ -478,53 +944,48 @@ int xbee_getstatus(int fd) {
 
 /* ---------------------------------------------------- * 
  * xbee_sendcmd() sends an AT command to the XBee, and  * 
- * writes the reply into the response string.           * 
+ * writes the reply into the response string, it needs  * 
+ * XBEE_REPLY bytes. Returns when the '\r' arrives, or  * 
+ * in API mode when the reply frame with its ID comes.  * 
  * Returns true for success, false for errors           * 
  * ---------------------------------------------------- */
 int xbee_sendcmd(int fd, const char *cmd, char *response) {
-   int cycles = timeout * 10; // check interval is 100ms
-   int i = 0; int wait = 0;
-
    /* ------------------------------------------------- *
     * Send CMD to XBee                                  *
     * ------------------------------------------------- */
    if(verbose == 1) printf("Debug: send CMD %s\n", cmd);
+   if(xbee_api != XBEE_API_OFF) {
+      if(xbee_apicmd(fd, cmd, response) == 0) return 0;
+      printf("Error: No XBee response received\n");
+      return -1;
+   }
    strserial(fd, cmd);
-   wait = checkserial(fd);
+   xbee_touchsession(fd);
+   if(strlen(cmd) >= 4) apidestcheck(cmd + 2, strcspn(cmd + 4, "\r"));
 
    /* ------------------------------------------------- *
-    * Check if response is received, wait up to timeout *
-    * ------------------------------------------------- */
-   i = 0;
-   while((wait = checkserial(fd)) == 0) {
-      usleep(100000);     // wait 100ms
-      if(i>cycles) break; // stop waiting after timeout
-      i++;
-   }
-   if(verbose == 1) printf("Debug: got %d bytes after %d ms\n", wait, i*100);
-   /* ------------------------------------------------- *
+    * Wait for the response, up to timeout seconds      *
     * If no response, its a XBee communication failure  *
     * Either no XBee connected, or on different speed.  *
     * ------------------------------------------------- */
-   if(wait == 0) {
+   if(xbee_getreply(fd, response, XBEE_REPLY, timeout) == -1) {
       printf("Error: No XBee response received\n");
       return -1;
    }
 
    /* ------------------------------------------------- *
-    * retrieve the reply, save it into response string  *
+    * Track cmds that end the session or change ATCT    *
     * ------------------------------------------------- */
-   for (i=0; i<1024; i++) {
-      if(checkserial(fd)>0) response[i] = getcharserial(fd);
-      else break;
+   if(strncmp(cmd, "ATCN", 4) == 0) {
+      endsession(fd);
+      session.lastdata = msec();
+      session.datasent = 1;
+   }
+   if(strncmp(cmd, "ATCT", 4) == 0 && cmd[4] != '\r' && strcmp(response, "OK") == 0
+      && strtoul(cmd + 4, NULL, 16) > 0) {
+      session.ct = strtoul(cmd + 4, NULL, 16) * 100;
+      session.ctread = 1;
    }
-
-   /* ------------------------------------------------- *
-    * Remove '\r' carriage return from last char        *
-    * ------------------------------------------------- */
-   i--;                                        // back to last char
-   if(response[i] == '\r') response[i] = '\0'; // eliminate '\r'
-   if(verbose == 1) printf("Debug: reply %s (%d bytes)\n", response, i);
    return 0;       // exit with success
 } // end xbee_sendcmd()
 
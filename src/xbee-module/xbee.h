@@ -8,6 +8,52 @@ extern int verbose;       // verbose set in the main prog
 extern char *port;        // port is set in the main prog
 extern int timeout;       // timeout set in the main prog
 
+#define XBEE_REPLY 512    // response buffer size for xbee_sendcmd()
+
+#define XBEE_API_OFF 0         // transparent mode, AT cmds after +++
+#define XBEE_API_ON 1          // API frames (ATAP1)
+#define XBEE_API_ESCAPED 2     // API frames, special bytes escaped (ATAP2)
+#define XBEE_API_START 0x7E    // frame start delimiter
+#define XBEE_API_ESCAPE 0x7D   // escape char, next byte is XOR 0x20
+#define XBEE_API_DATA 256      // max frame data bytes after the type
+#define XBEE_API_FRAME (2 * (XBEE_API_DATA + 5))  // encoded frame bytes
+#define XBEE_API_PAYLOAD 84    // TX payload bytes per frame (S2C ATNP)
+#define XBEE_API_WAIT 100      // ms to wait for the API mode probe reply
+#define XBEE_API_QUEUE 8       // frames kept while waiting for a reply
+#define XBEE_AT_ERROR -2       // AT cmd status is not OK
+#define XBEE_GUARD 1000        // ms +++ guard time, ATGT default
+#define XBEE_CT 10000          // ms ATCT default, cmd mode ends after
+#define XBEE_CT_MARGIN 500     // ms before ATCT ends it, no more reuse
+#define XBEE_LOCKWAIT 30000    // ms to wait for the serhubd port lock
+#define XBEE_BATCH 16          // max cmds per xbee_batch()
+#define XBEE_BATCH_REPLY 24    // reply bytes per batch cmd, NI has 20
+
+#define XBEE_FRAME_AT 0x08           // local AT command, applied now
+#define XBEE_FRAME_AT_QUEUE 0x09     // local AT command, applied by ATAC
+#define XBEE_FRAME_TX 0x10           // transmit request
+#define XBEE_FRAME_AT_RESPONSE 0x88  // local AT command response
+#define XBEE_FRAME_MODEM_STATUS 0x8A // modem status
+#define XBEE_FRAME_TX_STATUS 0x8B    // transmit status
+#define XBEE_FRAME_RX 0x90           // received packet
+
+extern int xbee_api;      // XBEE_API_OFF, or the API mode to use
+
+typedef struct {
+  int fd;                 // port of the open session
+  int open;               // 1 = XBee is in command mode after +++
+  unsigned int expires;   // msec() when ATCT ends command mode
+  unsigned int ct;        // ATCT in ms, XBEE_CT until it is read
+  int ctread;             // 1 = ct was read from the XBee
+  unsigned int lastdata;  // msec() of the last transparent data sent
+  int datasent;           // 1 = lastdata is set
+} XBee_Session;
+
+typedef struct {
+  uint8_t type;           // frame type, e.g. XBEE_FRAME_RX
+  uint16_t len;           // frame data length after the type
+  uint8_t data[XBEE_API_DATA]; // frame data, for AT cmds frame ID first
+} XBee_Frame;
+
 typedef struct {
   char firmware[5];       // ATVR, returns 4 digits firmware
   char hardware[5];       // ATHV, returns 4 bytes HW
@@ -16,22 +62,47 @@ typedef struct {
   float volt;             // AT%V, hex converted to Volt
 } XBee_Info;
 
-XBee_Info nw_info[16]; 
-
 typedef struct {
-  char device_free[3];    // ATNC, 2 bytes 0...14
-  char association[2];    // ATAI, 1 byte connected = 0
-  char oper_panid[17];    // ATOP, 16 bytes, 0 = not connected
-  char oper_chan[3];      // ATCH, 2 bytes, 0 = not connected
-  char last_rssi[3];      // ATDB, 2 bytes recv signal strength 0..FF
-  char pwr_level[2];      // ATPP, 1 byte power level for pwr mode 4
-  char max_packets[3];    // ATNP, 2 bytes max. bytes for unicasts
-  char nw_address[5];     // ATMY, 4 bytes NW addr, FFFE if disconnected
-  char pt_address[5];     // ATMP, 4 bytes parent addr, FFFE if disconnected
+  uint8_t device_free;    // ATNC, 0...14 devices that can still join
+  uint8_t association;    // ATAI, connected = 0, else the error code
+  uint64_t oper_panid;    // ATOP, 0 = not connected
+  uint8_t oper_chan;      // ATCH, 0 = not connected
+  uint8_t last_rssi;      // ATDB, recv signal strength -dBm 0..FF
+  uint8_t pwr_level;      // ATPP, power level in dBm for pwr mode 4
+  uint16_t max_packets;   // ATNP, max. bytes for unicasts
+  uint16_t nw_address;    // ATMY, NW addr, FFFE if disconnected
+  uint16_t pt_address;    // ATMP, parent addr, FFFE if disconnected
   uint32_t last_update;   // timestamp of last update
 } XBee_Status;
 
-XBee_Info nw_status[16]; 
+#define XBEE_NODES 64          // node table capacity
+#define XBEE_NODEHASH 128      // index slots, power of 2, 2x XBEE_NODES
+#define XBEE_NODEFILE "/var/tmp/xbee-nodes" // env XBEE_NODEFILE overrides
+#define XBEE_NODEAGE 3600      // s until xbee-ping runs ATND again
+#define XBEE_NT 6000           // ms ATNT default, node discovery time
+#define XBEE_FRAME_NODE_ID 0x95      // node identification indicator
+
+typedef struct {
+  uint64_t mac;           // ATSH+ATSL 64 bit address
+  uint16_t nw_address;    // ATMY 16 bit NW addr, FFFE if unknown
+  uint16_t pt_address;    // parent NW addr, FFFE if none
+  uint8_t dev_type;       // 0 = coord, 1 = router, 2 = enddevice, FF unknown
+  uint8_t status;         // ND status byte, join event in 0x95 frames
+  uint16_t profile_id;    // e.g. C105 Digi
+  uint16_t mfg_id;        // e.g. 101E Digi
+  char nodeid[21];        // ATNI, 20 bytes Node name
+  uint32_t last_seen;     // timestamp of the last discovery or packet
+} XBee_Node;
+
+typedef struct {
+  XBee_Node node[XBEE_NODES];
+  int count;              // nodes in the table
+  uint32_t last_update;   // timestamp of the last ATND
+  int16_t bymac[XBEE_NODEHASH];  // index by mac, node + 1, 0 = free
+  int16_t bynw[XBEE_NODEHASH];   // index by nw_address
+} XBee_NodeTable;
+
+extern XBee_NodeTable nw_nodes; // node table in xbee-nodes.c
 
 enum xbee_io_type {
    XBEE_IO_TYPE_DISABLED            = 0, // Disabled
@@ -53,6 +124,7 @@ enum xbee_io_type {
 struct XBee_Config {}; // TBD
 
 int xbee_enable(char *, int);
+void xbee_disable(int);
 int xbee_getinfo(int);
 int xbee_getstatus(int);
 int xbee_getconfig();
@@ -61,5 +133,21 @@ int xbee_sendstring(int, const char *);
 int xbee_recvstring(int, char *);
 int xbee_startcmdmode(int, int);
 int xbee_endcmdmode(int, int);
+int xbee_exitcmdmode(int, int);
 int xbee_sendcmd(int, const char *, char *);
+void xbee_touchsession(int);
 int xbee_factoryreset(int);
+int xbee_apiencode(uint8_t *, uint8_t, const uint8_t *, int, int);
+int xbee_sendframe(int, uint8_t, const uint8_t *, int);
+int xbee_recvframe(int, XBee_Frame *, unsigned int);
+void xbee_queueframe(const XBee_Frame *);
+int xbee_atcmd(int, const char *, const uint8_t *, int, uint8_t *, int, unsigned int);
+int xbee_batch(int, const char **, int, char (*)[XBEE_BATCH_REPLY], unsigned int);
+uint8_t xbee_frameid(void);
+XBee_Node *xbee_nodebymac(uint64_t);
+XBee_Node *xbee_nodebynw(uint16_t);
+XBee_Node *xbee_nodeupdate(const XBee_Node *);
+int xbee_nodeframe(const XBee_Frame *);
+int xbee_nodediscover(int);
+int xbee_nodeload(const char *);
+int xbee_nodesave(const char *);